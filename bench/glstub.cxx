@@ -0,0 +1,30 @@
+/* =============================================================================
+ * glstub.cxx
+ * Masado Ishii
+ * v0.3 2026-10-19
+ *
+ * Description: No-op stand-ins for the GL calls made while traversing
+ *   draw lists, so funnelvision_bench times the CPU side alone, without a
+ *   context. Being defined in the executable, they take the place of
+ *   libGL's for every caller linked into it.
+ *
+ * Attributions:
+ * =============================================================================
+ */
+
+#include <GL/gl.h>
+
+#include "glstub.h"
+
+
+unsigned long glstub_NumCalls = 0;
+
+extern "C"
+{
+
+void GLAPIENTRY glPushMatrix(void) { glstub_NumCalls++; }
+void GLAPIENTRY glPopMatrix(void) { glstub_NumCalls++; }
+void GLAPIENTRY glMultMatrixf(const GLfloat *m) { glstub_NumCalls += (m != 0); }
+void GLAPIENTRY glCallList(GLuint list) { glstub_NumCalls += (list != 0); }
+
+}
@@ -0,0 +1,20 @@
+/* =============================================================================
+ * glstub.h
+ * Masado Ishii
+ * v0.3 2026-10-19
+ *
+ * Description: No-op GL entry points for the benchmarks; see glstub.cxx.
+ *
+ * Attributions:
+ * =============================================================================
+ */
+
+#ifndef _GLSTUB_H
+#define _GLSTUB_H
+
+/* Counts the stubbed calls, so that none can be optimized away and the
+ *   benchmarks can check what they drove.
+ */
+extern unsigned long glstub_NumCalls;
+
+#endif /* _GLSTUB_H */
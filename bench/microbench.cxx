@@ -0,0 +1,553 @@
+/* =============================================================================
+ * microbench.cxx
+ * Masado Ishii
+ * v0.3 2026-10-19
+ *
+ * Description: Microbenchmarks of the CPU hot paths: portal link matrices
+ *   and their composition along portal chains, computed and cached, draw
+ *   list traversal (GL stubbed), frame planning with draw lists built on
+ *   1 to N threads, the animation step, and building the scene's meshes.
+ *
+ *   funnelvision_bench [options]
+ *     --json PATH       Also write the results as JSON ("-" for stdout).
+ *     --filter TEXT     Run only benchmarks whose name contains TEXT.
+ *     --reps N          Timed repetitions of each benchmark (default 15).
+ *     --warmup N        Untimed repetitions first (default 3).
+ *     --min-time MS     Each repetition runs at least this long (default 20).
+ *     --max-objects N   Largest draw list (default 1000000).
+ *     --max-threads N   Most threads planning a frame (default: the cores,
+ *                       but at least 4).
+ *
+ *   Each repetition runs the body enough times to last --min-time; the
+ *   spread over repetitions gives the variance. Times are per operation:
+ *   per portal, per view, per object, per call or per scene, as named.
+ *
+ * Attributions:
+ * =============================================================================
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../include/meshobject.h"
+#include "../include/parallel.h"
+#include "../include/portalcache.h"
+#include "../include/portalplan.h"   // PortalFramePlanner::MAX_PORTAL_RECURSION_DEPTH
+#include "../include/portalscene.h"
+#include "glstub.h"
+
+
+namespace
+{
+
+struct BenchOptions
+{
+    std::string jsonPath;
+    std::string filter;
+    int reps, warmup;
+    double minSeconds;
+    long maxObjects;
+    int maxThreads;
+
+    BenchOptions()
+        : reps(15), warmup(3), minSeconds(0.020), maxObjects(1000000),
+          maxThreads(std::max(4, (int) std::thread::hardware_concurrency())) {}
+};
+
+struct BenchResult
+{
+    std::string name;
+    std::string paramName;
+    long param;
+    const char *unit;      // What one operation is.
+    long iterations;       // Body runs per repetition.
+    long opsPerIteration;
+    int reps, warmup;
+    double mean, stddev, median, min, max, ci95;  // ns per operation.
+};
+
+/* ------------------------------------------------------------------
+ * BenchRunner class.
+ * ------------------------------------------------------------------
+ */
+class BenchRunner
+{
+  public:
+    typedef std::function<void(long iterations)> Body;
+
+    BenchRunner(const BenchOptions &o) : opts(o) {}
+
+    /* Times body, which does opsPerIteration operations per iteration. */
+    void Run(const std::string &name, const std::string &paramName, long param,
+            const char *unit, long opsPerIteration, const Body &body);
+
+    void PrintTable(std::ostream &out) const;
+    void PrintJSON(std::ostream &out) const;
+
+  protected:
+    BenchOptions opts;
+    std::vector<BenchResult> results;
+
+    static double TimeRep(const Body &body, long iterations)
+    {
+        double start = mishii_Seconds();
+        body(iterations);
+        return mishii_Seconds() - start;
+    }
+};
+
+void BenchRunner::Run(const std::string &name, const std::string &paramName, long param,
+        const char *unit, long opsPerIteration, const Body &body)
+{
+    if (!opts.filter.empty() && name.find(opts.filter) == std::string::npos)
+        return;
+
+    // Iterations per repetition: doubled until one lasts minSeconds.
+    long iterations = 1;
+    while (TimeRep(body, iterations) < opts.minSeconds && iterations < (1L << 40))
+        iterations *= 2;
+
+    for (int r = 0; r < opts.warmup; r++)
+        TimeRep(body, iterations);
+    std::vector<double> ns(opts.reps);
+    for (int r = 0; r < opts.reps; r++)
+        ns[r] = 1e9 * TimeRep(body, iterations) / ((double) iterations * opsPerIteration);
+
+    BenchResult res;
+    res.name = name;
+    res.paramName = paramName;
+    res.param = param;
+    res.unit = unit;
+    res.iterations = iterations;
+    res.opsPerIteration = opsPerIteration;
+    res.reps = opts.reps;
+    res.warmup = opts.warmup;
+
+    double sum = 0.0;
+    for (int r = 0; r < opts.reps; r++)
+        sum += ns[r];
+    res.mean = sum / opts.reps;
+    double sq = 0.0;
+    for (int r = 0; r < opts.reps; r++)
+        sq += (ns[r] - res.mean) * (ns[r] - res.mean);
+    res.stddev = (opts.reps > 1 ? std::sqrt(sq / (opts.reps - 1)) : 0.0);
+    res.ci95 = 1.96 * res.stddev / std::sqrt((double) opts.reps);  // Normal approximation.
+    std::sort(ns.begin(), ns.end());
+    res.median = (ns[(opts.reps - 1) / 2] + ns[opts.reps / 2]) / 2;
+    res.min = ns.front();
+    res.max = ns.back();
+    results.push_back(res);
+
+    std::cerr << "bench: " << name << " " << paramName << "=" << param << " done" << std::endl;
+}
+
+void BenchRunner::PrintTable(std::ostream &out) const
+{
+    out << std::left << std::setw(20) << "benchmark" << std::setw(16) << "param"
+        << std::right << std::setw(14) << "median_ns" << std::setw(14) << "mean_ns"
+        << std::setw(10) << "cv_%" << "  per" << std::endl;
+    for (size_t k = 0; k < results.size(); k++)
+    {
+        const BenchResult &r = results[k];
+        std::string param = r.paramName + "=" + std::to_string(r.param);
+        out << std::left << std::setw(20) << r.name << std::setw(16) << param << std::right
+            << std::fixed << std::setprecision(2)
+            << std::setw(14) << r.median << std::setw(14) << r.mean
+            << std::setw(10) << (r.mean > 0.0 ? 100.0 * r.stddev / r.mean : 0.0)
+            << "  " << r.unit << std::endl;
+    }
+}
+
+void BenchRunner::PrintJSON(std::ostream &out) const
+{
+    char date[32];
+    time_t now = time(NULL);
+    strftime(date, sizeof date, "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+
+    out << "{" << std::endl
+        << "  \"schema\": \"funnelvision-bench/1\"," << std::endl
+        << "  \"date\": \"" << date << "\"," << std::endl
+        << "  \"compiler\": \"" << __VERSION__ << "\"," << std::endl
+#ifdef __OPTIMIZE__
+        << "  \"optimized\": true," << std::endl
+#else
+        << "  \"optimized\": false," << std::endl
+#endif
+        << "  \"cpus\": " << std::thread::hardware_concurrency() << "," << std::endl
+        << "  \"benchmarks\": [" << std::endl;
+    out << std::setprecision(4) << std::fixed;
+    for (size_t k = 0; k < results.size(); k++)
+    {
+        const BenchResult &r = results[k];
+        out << "    {\"name\": \"" << r.name << "\", \"param\": \"" << r.paramName
+            << "\", \"value\": " << r.param
+            << ", \"unit\": \"ns/" << r.unit << "\""
+            << ", \"iterations\": " << r.iterations
+            << ", \"ops_per_iteration\": " << r.opsPerIteration
+            << ", \"warmup\": " << r.warmup << ", \"reps\": " << r.reps
+            << ", \"median\": " << r.median << ", \"mean\": " << r.mean
+            << ", \"stddev\": " << r.stddev << ", \"ci95\": " << r.ci95
+            << ", \"min\": " << r.min << ", \"max\": " << r.max << "}"
+            << (k + 1 < results.size() ? "," : "") << std::endl;
+    }
+    out << "  ]" << std::endl << "}" << std::endl;
+}
+
+/* Keeps results alive past the optimizer. */
+volatile float sink;
+
+/* Deterministic pseudo-random numbers in [0, 1), as in BuildLights(). */
+class Random
+{
+  public:
+    Random(unsigned int s) : seed(s) {}
+    float Next()
+    {
+        seed = seed * 1103515245u + 12345u;
+        return ((seed >> 8) & 0xFFFF) / 65536.0f;
+    }
+  protected:
+    unsigned int seed;
+};
+
+/* numPairs linked portal pairs at random poses, like AddPortalGrid(). */
+void MakePortals(int numPairs, Mesh *mesh, MeshObjList &scene, std::vector<PortalObject *> &portals)
+{
+    using namespace glm_mishii_matrix_transforms;
+    Random random(441);
+    portals.clear();
+    for (int i = 0; i < 2*numPairs; i++)
+    {
+        mat4 m = translate(mat4(), vec3(36.0f*random.Next() - 18.0f,
+                        36.0f*random.Next() - 18.0f, 2.0f + 4.0f*random.Next()))
+                * glm::rotate(mat4(), 6.2832f*random.Next(), vec3(0.0f, 0.0f, 1.0f))
+                * glm::rotate(mat4(), 1.5708f, vec3(1.0f, 0.0f, 0.0f))
+                * scale(mat4(), vec3(1.5f, 1.5f, 1.0f));
+        portals.push_back(new PortalObject(mesh, &scene, NULL, m));
+    }
+    for (int i = 0; i < numPairs; i++)
+    {
+        portals[i]->SetDestPortal(portals[i + numPairs]);
+        portals[i + numPairs]->SetDestPortal(portals[i]);
+    }
+}
+
+/* PortalScene with its scene building open to the benchmarks. */
+class BenchScene : public PortalScene
+{
+  public:
+    using PortalScene::InitializeScene;
+};
+
+
+/* ------------------------------------------------------------------
+ * Benchmarks.
+ * ------------------------------------------------------------------
+ */
+
+/* One LinkMatrix() per portal: the portal-to-portal transform with the
+ *   inverse of the destination's model matrix.
+ */
+void BenchLinkMatrix(BenchRunner &runner)
+{
+    DisplayListMesh square(1);
+    MeshObjList scene;
+    std::vector<PortalObject *> portals;
+    MakePortals(128, &square, scene, portals);
+
+    runner.Run("link_matrix", "portals", (long) portals.size(), "portal", (long) portals.size(),
+        [&](long iterations)
+        {
+            float acc = 0.0f;
+            for (long it = 0; it < iterations; it++)
+                for (size_t p = 0; p < portals.size(); p++)
+                    acc += portals[p]->LinkMatrix()[3][0];
+            sink = acc;
+        });
+
+    for (size_t p = 0; p < portals.size(); p++)
+        delete portals[p];
+}
+
+/* Views at the end of portal chains, composed as the frame planner does:
+ *   chainMat = parent chainMat * LinkMatrix(), viewMat = camera * chainMat,
+ *   for every level of the chain.
+ */
+void BenchPortalChain(BenchRunner &runner)
+{
+    DisplayListMesh square(1);
+    MeshObjList scene;
+    std::vector<PortalObject *> portals;
+    MakePortals(128, &square, scene, portals);
+
+    const int NUM_CHAINS = 256;
+    int depths[] = { 1, PortalFramePlanner::MAX_PORTAL_RECURSION_DEPTH, 4, 8 };
+    for (size_t d = 0; d < sizeof depths / sizeof depths[0]; d++)
+    {
+        int depth = depths[d];
+        if (d > 0 && depth <= depths[d-1])
+            continue;
+
+        // Portals drawn at random; the cost does not depend on which.
+        Random random(depth);
+        std::vector<const PortalObject *> chains;
+        for (int c = 0; c < NUM_CHAINS; c++)
+            for (int k = 0; k < depth; k++)
+                chains.push_back(portals[(size_t) (random.Next() * portals.size())]);
+        glm::mat4 camera = glm::lookAt(glm::vec3(0.0f, -30.0f, 20.0f),
+                glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+
+        runner.Run("portal_chain", "depth", depth, "view", NUM_CHAINS,
+            [&](long iterations)
+            {
+                float acc = 0.0f;
+                for (long it = 0; it < iterations; it++)
+                    for (int c = 0; c < NUM_CHAINS; c++)
+                    {
+                        glm::mat4 chainMat(1.0f), viewMat;
+                        for (int k = 0; k < depth; k++)
+                        {
+                            chainMat = chainMat * chains[c*depth + k]->LinkMatrix();
+                            viewMat = camera * chainMat;
+                        }
+                        acc += viewMat[3][2];
+                    }
+                sink = acc;
+            });
+
+        // The same through PortalTransformCache, as planning does: all hits
+        //   after the first frame, so only the camera is applied.
+        PortalTransformCache cache;
+        runner.Run("portal_chain_cached", "depth", depth, "view", NUM_CHAINS,
+            [&](long iterations)
+            {
+                float acc = 0.0f;
+                for (long it = 0; it < iterations; it++)
+                {
+                    cache.BeginFrame();
+                    for (int c = 0; c < NUM_CHAINS; c++)
+                    {
+                        int chain = PortalTransformCache::ROOT;
+                        glm::mat4 viewMat;
+                        for (int k = 0; k < depth; k++)
+                        {
+                            chain = cache.Extend(chain, chains[c*depth + k]);
+                            viewMat = camera * cache.GetChain(chain).chainMat;
+                        }
+                        acc += viewMat[3][2];
+                    }
+                }
+                sink = acc;
+            });
+    }
+
+    for (size_t p = 0; p < portals.size(); p++)
+        delete portals[p];
+}
+
+/* MeshObject::DrawList() over lists of 1k to maxObjects objects, with the
+ *   GL calls stubbed: the list walk, virtual calls and matrix handoff.
+ */
+void BenchDrawList(BenchRunner &runner, long maxObjects)
+{
+    DisplayListMesh mesh(1);
+    for (long n = 1000; n <= maxObjects; n *= 10)
+    {
+        MeshObjList list;
+        Random random((unsigned int) n);
+        for (long i = 0; i < n; i++)
+            list.push_back(new MeshObject(&mesh, glm::translate(glm::mat4(),
+                    glm::vec3(random.Next(), random.Next(), random.Next()))));
+
+        unsigned long callsBefore = glstub_NumCalls;
+        MeshObject::DrawList(list);
+        if (glstub_NumCalls - callsBefore != 4 * (unsigned long) n)
+            std::cerr << "bench: draw_list: the GL stubs were not called; timing libGL." << std::endl;
+
+        runner.Run("draw_list", "objects", n, "object", n,
+            [&](long iterations)
+            {
+                for (long it = 0; it < iterations; it++)
+                    MeshObject::DrawList(list);
+            });
+
+        for (MeshObjList::iterator iter = list.begin(); iter != list.end(); ++iter)
+            delete *iter;
+    }
+}
+
+/* PortalFramePlanner::Plan() of a large multi-portal scene: 64 portal
+ *   pairs among 4096 cubes, seen from above. Planning the portals stays
+ *   on one thread; culling and sorting the draw lists of every view runs
+ *   on a TaskScheduler of 1 to maxThreads threads.
+ */
+void BenchFramePlan(BenchRunner &runner, int maxThreads)
+{
+    DisplayListMesh square(1), cube(2);
+    square.SetBounds(glm::vec3(-1.0f, -1.0f, 0.0f), glm::vec3(1.0f, 1.0f, 0.0f));
+    cube.SetBounds(glm::vec3(-0.5f), glm::vec3(0.5f));
+
+    MeshObjList scene;
+    std::vector<PortalObject *> portals;
+    MakePortals(64, &square, scene, portals);
+    scene.insert(scene.end(), portals.begin(), portals.end());
+    const int GRID = 16;
+    for (int i = 0; i < GRID*GRID*GRID; i++)
+        scene.push_back(new MeshObject(&cube, glm::translate(glm::mat4(),
+                glm::vec3(2.4f*(i % GRID) - 18.0f, 2.4f*(i / GRID % GRID) - 18.0f,
+                        1.0f*(i / (GRID*GRID))))));
+
+    glm::mat4 viewMat = glm::lookAt(glm::vec3(0.0f, -30.0f, 20.0f),
+            glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+    glm::mat4 projMat = glm::perspective(glm::radians(30.0f), 16.0f / 9.0f, 1.0f, 200.0f);
+    ScissorRect viewport(0, 0, 1280, 720);
+
+    PortalFramePlanner planner;
+    PortalFramePlan plan;
+    planner.Plan(scene, viewMat, projMat, viewport, plan);  // Warms the reused storage.
+    double start = mishii_Seconds();
+    planner.Plan(scene, viewMat, projMat, viewport, plan);
+    double planSeconds = mishii_Seconds() - start;
+    long drawn = 0;
+    for (size_t vi = 0; vi < plan.views.size(); vi++)
+        drawn += (long) plan.views[vi].drawList.size();
+    std::cerr << "bench: frame_plan views=" << plan.views.size()
+              << " objects=" << scene.size() << " drawn=" << drawn
+              << " culled=" << plan.numObjectsCulled
+              << " plan_ms=" << 1e3 * planSeconds
+              << " lists_ms=" << 1e3 * planner.BuildSeconds()
+              << " xform_hit_pct=" << 100.0 * planner.Transforms().HitRate()
+              << " cores=" << std::thread::hardware_concurrency() << std::endl;
+
+    for (int threads = 1; ; threads = std::min(2 * threads, maxThreads))
+    {
+        TaskScheduler scheduler(threads);
+        planner.SetScheduler(&scheduler);
+        runner.Run("frame_plan", "threads", threads, "frame", 1,
+            [&](long iterations)
+            {
+                for (long it = 0; it < iterations; it++)
+                    planner.Plan(scene, viewMat, projMat, viewport, plan);
+            });
+        planner.SetScheduler(&TaskScheduler::Shared());
+        if (threads >= maxThreads)
+            break;
+    }
+
+    for (MeshObjList::iterator iter = scene.begin(); iter != scene.end(); ++iter)
+        delete *iter;
+}
+
+/* PortalScene::AdvanceAnimation(): the animated object's rotation, then
+ *   the loop turning every light.
+ */
+void BenchAdvanceAnimation(BenchRunner &runner)
+{
+    int numLights[] = { 0, 1024, 16384 };
+    for (size_t k = 0; k < sizeof numLights / sizeof numLights[0]; k++)
+    {
+        BenchScene scene;
+        scene.SetNumLights(numLights[k]);
+        scene.InitializeScene();
+        runner.Run("advance_animation", "lights", numLights[k], "call", 1,
+            [&](long iterations)
+            {
+                for (long it = 0; it < iterations; it++)
+                    scene.AdvanceAnimation();
+            });
+    }
+}
+
+/* PortalScene::InitializeScene(): generating the meshes and placing the
+ *   objects, with the scene's construction and destruction.
+ */
+void BenchBuildScene(BenchRunner &runner)
+{
+    int numPortals[] = { 0, 256 };
+    for (size_t k = 0; k < sizeof numPortals / sizeof numPortals[0]; k++)
+    {
+        int pairs = numPortals[k] / 2;
+        runner.Run("build_scene", "portals", numPortals[k], "scene", 1,
+            [&](long iterations)
+            {
+                for (long it = 0; it < iterations; it++)
+                {
+                    BenchScene scene;
+                    scene.SetPortalPairs(pairs);
+                    scene.InitializeScene();
+                }
+            });
+    }
+}
+
+}
+
+
+/* --------------------------------------------------------------------
+ * main()
+ * --------------------------------------------------------------------
+ */
+int main(int argc, char *argv[])
+{
+    BenchOptions opts;
+    for (int i = 1; i < argc; i++)
+    {
+        bool hasValue = (i+1 < argc);
+        if (strcmp(argv[i], "--json") == 0 && hasValue)
+            opts.jsonPath = argv[++i];
+        else if (strcmp(argv[i], "--filter") == 0 && hasValue)
+            opts.filter = argv[++i];
+        else if (strcmp(argv[i], "--reps") == 0 && hasValue)
+            opts.reps = std::max(1, atoi(argv[++i]));
+        else if (strcmp(argv[i], "--warmup") == 0 && hasValue)
+            opts.warmup = std::max(0, atoi(argv[++i]));
+        else if (strcmp(argv[i], "--min-time") == 0 && hasValue)
+            opts.minSeconds = 1e-3 * atof(argv[++i]);
+        else if (strcmp(argv[i], "--max-objects") == 0 && hasValue)
+            opts.maxObjects = atol(argv[++i]);
+        else if (strcmp(argv[i], "--max-threads") == 0 && hasValue)
+            opts.maxThreads = std::max(1, atoi(argv[++i]));
+        else
+        {
+            std::cerr << "Usage: " << argv[0] << " [--json PATH] [--filter TEXT] [--reps N]"
+                      << " [--warmup N] [--min-time MS] [--max-objects N] [--max-threads N]"
+                      << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    BenchRunner runner(opts);
+    BenchLinkMatrix(runner);
+    BenchPortalChain(runner);
+    BenchDrawList(runner, opts.maxObjects);
+    BenchFramePlan(runner, opts.maxThreads);
+    BenchAdvanceAnimation(runner);
+    BenchBuildScene(runner);
+
+    bool jsonToStdout = (opts.jsonPath == "-");
+    if (!jsonToStdout)
+        runner.PrintTable(std::cout);
+    if (jsonToStdout)
+        runner.PrintJSON(std::cout);
+    else if (!opts.jsonPath.empty())
+    {
+        std::ofstream json(opts.jsonPath.c_str());
+        runner.PrintJSON(json);
+        if (!json)
+        {
+            std::cerr << "bench: cannot write " << opts.jsonPath << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    return EXIT_SUCCESS;
+}
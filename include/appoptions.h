@@ -0,0 +1,64 @@
+/* =============================================================================
+ * appoptions.h
+ * Masado Ishii
+ * v0.3 2026-10-19
+ *
+ * Description: Command line options shared by all backends.
+ *
+ * Attributions:
+ * =============================================================================
+ */
+
+#ifndef _APPOPTIONS_H
+#define _APPOPTIONS_H
+
+#include <string>
+
+#include "portalscene.h"
+
+
+/* ------------------------------------------------------------------
+ * AppOptions struct.
+ * ------------------------------------------------------------------
+ */
+struct AppOptions
+{
+    std::string backend;  // "vtk", "glx", "egl", "osmesa" or "soft".
+    int  width, height;
+    int  frames;          // Exit after this many frames; 0 runs until closed.
+    bool stats;
+    bool benchLights;
+    bool benchRays;
+    int  portalPairs;
+    int  numLights;
+    float viewQuality;    // Resolution of nested portal views, in (0, 1].
+    float eyeSeparation;  // Side-by-side stereo when > 0.
+    int  renderProcs;     // Render in strips across this many processes; 0 renders here.
+    PortalScene::LatchMode latch;  // When the frame loop samples camera input.
+    double inputRate;     // Synthetic camera steps per second; 0 for none.
+    double gpuBudgetMB;   // GL memory budget of the scene; 0 for none.
+    std::string modelPath;  // OBJ model to add; empty for none.
+    PortalScene::SweepMode sweep;
+    std::string capturePath;  // Empty: no capture.
+    bool captureDrop;         // Drop frames rather than wait for the writer.
+    bool frameGraph;          // Time the passes of each frame; print them on exit.
+    std::string recordPath;   // Camera path to record; empty for none.
+    std::string replayPath;   // Camera path to replay; empty for none.
+
+    double startTime;     // mishii_Seconds() on entry to main().
+
+    AppOptions();
+};
+
+
+/* ------------------------------------------------------------------
+ * Routines: ParseAppOptions(), ApplyAppOptions().
+ *
+ * ParseAppOptions() prints the usage and returns false on a bad argument.
+ * ------------------------------------------------------------------
+ */
+bool ParseAppOptions(int argc, char *argv[], AppOptions &opts);
+void ApplyAppOptions(const AppOptions &opts, PortalScene &scene);
+
+
+#endif /* _APPOPTIONS_H */
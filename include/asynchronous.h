@@ -31,6 +31,24 @@ void KeypressCallbackFunction (
   void* clientData,
   void* callData );
 
+/*
+ * CameraModifiedCallbackFunction, RenderEndCallbackFunction (prototypes)
+ *   Input to present latency: the camera's ModifiedEvent stamps input,
+ *   the render window's EndEvent (after the buffer swap) presents it.
+ *   clientData is the PortalScene.
+ */
+void CameraModifiedCallbackFunction (
+  vtkObject* caller,
+  long unsigned int eventId,
+  void* clientData,
+  void* callData );
+
+void RenderEndCallbackFunction (
+  vtkObject* caller,
+  long unsigned int eventId,
+  void* clientData,
+  void* callData );
+
 
 /*
  * vtkTimerCallback class
@@ -43,6 +61,15 @@ class vtkTimerCallback : public vtkCommand
     void   SetMapper(vtk441Mapper *m) { mapper = m; };
     void   SetRenderWindow(vtkRenderWindow *rw) { renWin = rw; };
     void   SetCamera(vtkCamera *c) { cam = c; };
+
+    /* The scene's camera path, if any, is recorded from or replayed into
+     *   the camera, a frame per timer tick; a replay exits at its end.
+     */
+    void   SetScene(PortalScene *s) { scene = s; };
+
+    /* Report startup after the first frame; exit after maxFrames (0: never). */
+    void   SetStartTime(double t) { startTime = t; };
+    void   SetMaxFrames(int n) { maxFrames = n; };
  
     virtual void Execute(vtkObject *vtkNotUsed(caller), unsigned long eventId,
                          void *vtkNotUsed(callData));
@@ -52,7 +79,10 @@ class vtkTimerCallback : public vtkCommand
     vtk441Mapper *mapper;
     vtkRenderWindow *renWin;
     vtkCamera *cam;
+    PortalScene *scene;
     float angle;
+    double startTime;
+    int maxFrames;
 };
 
 #endif /* _ASYNCHRONOUS_H */
@@ -0,0 +1,122 @@
+/* =============================================================================
+ * backend.h
+ * Masado Ishii
+ * v0.3 2026-10-19
+ *
+ * Description: Minimal GL hosts for the portal scene that do not need VTK:
+ *   an X11/GLX window, and headless EGL (surfaceless) or OSMesa contexts.
+ *   The soft backend rasterizes on the CPU and needs no GL context at all.
+ *   VTK remains available as its own backend (vtkapp.h). Any of them can
+ *   show frames drawn in tiles by other processes (tiledrender.h).
+ *
+ * Attributions:
+ * =============================================================================
+ */
+
+#ifndef _BACKEND_H
+#define _BACKEND_H
+
+#include <string>
+
+#include "camera.h"
+#include "portalplan.h"  // ScissorRect.
+
+struct AppOptions;
+class PortalScene;
+
+
+/* ------------------------------------------------------------------
+ * RenderBackend class.
+ *
+ * A GL context plus something to draw into, with depth and stencil.
+ * ------------------------------------------------------------------
+ */
+class RenderBackend
+{
+  public:
+    virtual ~RenderBackend() {}
+
+    virtual const char *Name() const = 0;
+    virtual bool Headless() const = 0;
+
+    /* Creates the drawable and makes its context current. Prints the
+     *   reason and returns false on failure.
+     */
+    virtual bool Open(int width, int height) = 0;
+    virtual void Close() = 0;
+
+    virtual int Width() const = 0;
+    virtual int Height() const = 0;
+
+    /* Handles pending window events, steering camera. Returns false once
+     *   the user has asked to quit.
+     */
+    virtual bool PollEvents(Camera &camera) { return true; }
+
+    /* Returns when (mishii_Seconds()) the oldest event that moved the
+     *   camera since the last call arrived, if any did.
+     */
+    virtual bool TakeCameraInput(double &time) { return false; }
+
+    /* Returns the window position (origin at lower left) of the next
+     *   pending pick request, if any.
+     */
+    virtual bool TakePick(int &x, int &y) { return false; }
+
+    /* Returns the next pending key meant for the scene (see
+     *   PortalScene::HandleKey()), if any.
+     */
+    virtual bool TakeKey(char &key) { return false; }
+
+    /* Draws one frame of scene from camera. By default, DrawView() over
+     *   the whole drawable.
+     */
+    virtual void DrawFrame(PortalScene &scene, const Camera &camera);
+
+    /* Draws scene into viewport of the drawable. By default the scene
+     *   draws itself with the backend's GL context.
+     */
+    virtual void DrawView(PortalScene &scene, const glm::mat4 &viewMat,
+            const glm::mat4 &projMat, const ScissorRect &viewport);
+
+    /* Copies rect of the last frame to rgba (bottom-up), whose rows are
+     *   rowPixels wide. By default with glReadPixels().
+     */
+    virtual void ReadPixels(const ScissorRect &rect, unsigned char *rgba, int rowPixels);
+
+    /* Replaces the drawable's content with a width x height RGBA frame
+     *   drawn elsewhere. By default with glDrawPixels().
+     */
+    virtual void ShowPixels(int width, int height, const unsigned char *rgba);
+
+    /* Shows the finished frame; headless backends only glFinish(). */
+    virtual void Present() = 0;
+};
+
+
+/* ------------------------------------------------------------------
+ * Backend routines.
+ * ------------------------------------------------------------------
+ */
+
+/* Returns NULL if the named backend was not built in. "vtk" is never
+ *   returned from here; it drives its own event loop (RunVTKApp()).
+ */
+RenderBackend *CreateRenderBackend(const std::string &name);
+
+const char *DefaultRenderBackend();
+const char *AvailableRenderBackends();
+
+/* Opens backend, then draws scene until the user quits or opts.frames
+ *   have been drawn. Returns an exit status.
+ */
+int RunRenderBackend(RenderBackend &backend, PortalScene &scene,
+        const AppOptions &opts);
+
+/* Prints time from process start and from main() to the first frame,
+ *   and the resident memory. Called once by each backend.
+ */
+void ReportStartup(const char *backendName, double mainStartTime);
+
+
+#endif /* _BACKEND_H */
@@ -0,0 +1,45 @@
+/* =============================================================================
+ * camera.h
+ * Masado Ishii
+ * v0.3 2026-10-19
+ *
+ * Description: A look-at camera for the backends that run without VTK,
+ *   with the same defaults as the vtkCamera set up for the VTK backend.
+ *
+ * Attributions:
+ * =============================================================================
+ */
+
+#ifndef _CAMERA_H
+#define _CAMERA_H
+
+#include "utility.h"
+
+
+/* ------------------------------------------------------------------
+ * Camera struct.
+ * ------------------------------------------------------------------
+ */
+struct Camera
+{
+    glm::vec3 position;
+    glm::vec3 focalPoint;
+    glm::vec3 viewUp;
+    float viewAngle;          // Vertical field of view, degrees.
+    float clipNear, clipFar;
+
+    Camera();
+
+    glm::mat4 ViewMatrix() const;
+    glm::mat4 ProjectionMatrix(float aspect) const;
+
+    /* Orbits about the focal point, like vtkCamera::Azimuth()/Elevation(). */
+    void Azimuth(float degrees);
+    void Elevation(float degrees);
+
+    /* Moves toward the focal point by factor (> 1 moves closer). */
+    void Dolly(float factor);
+};
+
+
+#endif /* _CAMERA_H */
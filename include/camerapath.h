@@ -0,0 +1,133 @@
+/* =============================================================================
+ * camerapath.h
+ * Masado Ishii
+ * v0.3 2026-10-19
+ *
+ * Description: Camera paths, for runs that can be repeated exactly. A
+ *   recording holds, for every frame, the camera pose it was drawn from,
+ *   the animation clock, and the scene keys handled before it; replaying
+ *   it draws the same frames, one per record, however long each takes.
+ *
+ * Attributions:
+ * =============================================================================
+ */
+
+#ifndef _CAMERAPATH_H
+#define _CAMERAPATH_H
+
+#include <cstdio>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "camera.h"
+
+
+/* ------------------------------------------------------------------
+ * CameraPathFrame struct.
+ * ------------------------------------------------------------------
+ */
+struct CameraPathFrame
+{
+    float time;          // Seconds from the first recorded frame.
+    float animTime;      // The scene's animation clock, once advanced for the frame.
+    glm::vec3 position;
+    glm::vec3 focalPoint;
+    glm::vec3 viewUp;
+    std::string keys;    // For PortalScene::HandleKey(), before drawing.
+
+    void ApplyTo(Camera &camera) const
+    {
+        camera.position = position;
+        camera.focalPoint = focalPoint;
+        camera.viewUp = viewUp;
+    }
+};
+
+
+/* ------------------------------------------------------------------
+ * CameraPathRecorder class.
+ *
+ * File: a header (magic, version, byte order, record size), then one
+ *   fixed size record per frame followed by its keys. Records are
+ *   written as frames are drawn, so a run that is killed keeps all but
+ *   its last frames. Like the model cache, files are for this machine.
+ * ------------------------------------------------------------------
+ */
+class CameraPathRecorder
+{
+  public:
+    // Bump when the file layout changes.
+    static const unsigned VERSION = 1;
+
+    CameraPathRecorder() : file(NULL), numFrames(0), startTime(0.0) {}
+   ~CameraPathRecorder() { Close(); }
+
+    /* Prints the reason and returns false if path cannot be written. */
+    bool Open(const std::string &path);
+
+    /* Finishes the file and prints a summary. */
+    void Close();
+
+    bool IsOpen() const { return file != NULL; }
+
+    /* A key the scene handled; goes with the next frame recorded. */
+    void NoteKey(char key) { keys += key; }
+
+    /* Call once per frame drawn, with the pose it was drawn from. */
+    void RecordFrame(const glm::vec3 &position, const glm::vec3 &focalPoint,
+            const glm::vec3 &viewUp, float animTime);
+
+  protected:
+    FILE *file;
+    std::string path;
+    std::string keys;  // Since the last frame.
+    int numFrames;
+    double startTime;  // mishii_Seconds() of the first frame.
+};
+
+
+/* ------------------------------------------------------------------
+ * CameraPathPlayer class.
+ *
+ * Hands out the recorded frames in order. The caller sets each frame's
+ *   camera, handles its keys, advances the animation once and draws,
+ *   then reports the frame's time and the animation clock with
+ *   EndFrame(). The animation advances a fixed step per frame, so the
+ *   clock matches the recording unless the frames do not.
+ * ------------------------------------------------------------------
+ */
+class CameraPathPlayer
+{
+  public:
+    CameraPathPlayer() : next(0), divergedAt(-1) {}
+
+    /* Reads the whole path; prints the reason and returns false if it
+     *   cannot be read or was written by another version.
+     */
+    bool Load(const std::string &path);
+
+    bool IsLoaded() const { return !frames.empty(); }
+    bool Done() const { return next >= frames.size(); }
+    int  NumFrames() const { return (int) frames.size(); }
+
+    /* The next frame to draw. Only while !Done(). */
+    const CameraPathFrame &NextFrame() { return frames[next++]; }
+
+    void EndFrame(double seconds, float animTime);
+
+    /* Prints "replay:" with the frame time distribution of the frames
+     *   played, for comparing builds.
+     */
+    void Report(std::ostream &out) const;
+
+  protected:
+    std::string path;
+    std::vector<CameraPathFrame> frames;
+    size_t next;
+    std::vector<double> frameSeconds;  // Of the frames played.
+    int divergedAt;  // First frame whose animation clock differs; -1 for none.
+};
+
+
+#endif /* _CAMERAPATH_H */
@@ -0,0 +1,138 @@
+/* =============================================================================
+ * clusteredlighting.h
+ * Masado Ishii
+ * v0.3 2026-10-19
+ *
+ * Description: Clustered forward shading for many dynamic point lights.
+ *   Lights are binned on the CPU into view-space clusters (screen tiles by
+ *   logarithmic depth slices), once per portal view. A fragment shader then
+ *   only evaluates the lights in its own cluster.
+ *
+ * Attributions:
+ * =============================================================================
+ */
+
+// Note: This file uses the GL api, but nothing from VTK.
+
+#ifndef _CLUSTEREDLIGHTING_H
+#define _CLUSTEREDLIGHTING_H
+
+#include <ostream>
+#include <vector>
+
+#include <GL/gl.h>
+
+#include "portalplan.h"  // PortalViewHook, ScissorRect.
+#include "gpuresources.h"
+#include "parallel.h"
+#include "utility.h"
+
+
+/* ------------------------------------------------------------------
+ * PointLight struct.
+ *
+ * World space. Intensity falls off to zero at radius.
+ * ------------------------------------------------------------------
+ */
+struct PointLight
+{
+    glm::vec3 position;
+    float radius;
+    glm::vec3 color;
+};
+
+
+/* ------------------------------------------------------------------
+ * LightClusterGrid class.
+ *
+ * CPU side of the clustering. Cluster (tx, ty, slice) has index
+ *   (slice * TILES_Y + ty) * TILES_X + tx.
+ * ------------------------------------------------------------------
+ */
+class LightClusterGrid
+{
+  public:
+    static const int TILES_X = 16;
+    static const int TILES_Y = 8;
+    static const int SLICES = 24;
+    static const int NUM_CLUSTERS = TILES_X * TILES_Y * SLICES;
+
+    // Outputs of Build().
+    std::vector<GLuint> clusterRanges;  // (offset, count) into lightIndices, per cluster.
+    std::vector<GLuint> lightIndices;
+    std::vector<glm::vec4> viewLights;  // Per light: (view position, radius), (color, 0).
+    float zNear, zFar, zLogScale;       // Slice s starts at zNear * exp(s / zLogScale).
+
+    LightClusterGrid() : zNear(1.0f), zFar(100.0f), zLogScale(1.0f) {}
+
+    /* Bins lights for one view. The near and far planes are read from the
+     *   perspective matrix projMat. Lights are split across pool's threads;
+     *   within a cluster they stay in index order.
+     */
+    void Build(const std::vector<PointLight> &lights, const glm::mat4 &viewMat,
+            const glm::mat4 &projMat, WorkerPool &pool);
+
+  protected:
+    // Per-chunk scratch space, kept between builds.
+    std::vector<std::vector<GLuint> > chunkPairs;   // (cluster, light) pairs.
+    std::vector<std::vector<GLuint> > chunkCounts;  // Per cluster.
+
+    void BinLights(const std::vector<PointLight> &lights, const glm::mat4 &projMat,
+            int begin, int end, int chunk);
+    int Slice(float dist) const;
+};
+
+
+/* ------------------------------------------------------------------
+ * ClusteredLighting class.
+ *
+ * GL side: uploads a LightClusterGrid for each portal view as it is drawn
+ *   and shades its content with the clustered light list. Falls back to
+ *   the fixed-function lights if the shaders cannot be built, or without
+ *   GpuResources to hold the light textures.
+ * ------------------------------------------------------------------
+ */
+class ClusteredLighting : public PortalViewHook
+{
+  public:
+    ClusteredLighting();
+    virtual ~ClusteredLighting();
+
+    void SetLights(const std::vector<PointLight> *l) { lights = l; }
+    void SetResources(GpuResources *r) { resources = r; }
+    virtual void SetProjection(const glm::mat4 &proj, const ScissorRect &vp)
+        { projMat = proj; viewport = vp; }
+
+    virtual void BeginDrawLevel(int level);
+    virtual void BeginDrawView(const PortalView &view, const glm::mat4 &viewMat);
+    virtual void EndDrawLevel(int level);
+
+    // Totals since the last ResetCounters(), for FrameStats.
+    double binSeconds;
+    long   lightRefs;  // Sum of cluster list lengths.
+    void ResetCounters() { binSeconds = 0.0; lightRefs = 0; }
+
+    /* Prints CPU binning times for 64 to 16384 lights. Needs no GL context. */
+    static void BenchmarkBinning(std::ostream &out);
+
+  protected:
+    // Row width of the index and light data textures.
+    static const int TEXTURE_ROW = 1024;
+
+    const std::vector<PointLight> *lights;
+    GpuResources *resources;  // Not owned.
+    glm::mat4 projMat;
+    ScissorRect viewport;
+    LightClusterGrid grid;
+
+    bool initialized, usable;
+    GLuint program;
+    GpuResources::Handle textures[3];  // Cluster ranges, light indices, light data.
+    GLint  uViewport, uGridSize, uZNear, uZLogScale;
+
+    bool Initialize();
+    void Upload();
+};
+
+
+#endif /* _CLUSTEREDLIGHTING_H */
@@ -0,0 +1,139 @@
+/* =============================================================================
+ * framecapture.h
+ * Masado Ishii
+ * v0.3 2026-10-19
+ *
+ * Description: Frame capture to a PNG sequence or a .y4m video, for demo
+ *   recordings and regression captures.
+ *
+ *   Each frame is read back into one of a ring of pixel buffer objects.
+ *   The readback is only mapped RING_SIZE frames later, by which time the
+ *   GPU has finished it, so the render thread never waits on the GPU. The
+ *   pixels then go through a bounded queue to a writer thread that encodes
+ *   and writes them. When the queue is full the render thread either waits
+ *   (backpressure, the default) or drops the frame; both are counted.
+ *
+ * Attributions:
+ * =============================================================================
+ */
+
+// Note: This file uses the GL api, but nothing from VTK.
+
+#ifndef _FRAMECAPTURE_H
+#define _FRAMECAPTURE_H
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <GL/gl.h>
+
+#include "imagefile.h"
+#include "portalplan.h"  // ScissorRect.
+#include "gpuresources.h"
+
+
+/* ------------------------------------------------------------------
+ * FrameCapture class.
+ * ------------------------------------------------------------------
+ */
+class FrameCapture
+{
+  public:
+    static const int RING_SIZE = 3;       // Pixel buffer objects in flight.
+    static const int QUEUE_CAPACITY = 8;  // Frames waiting for the writer.
+    static const int VIDEO_FPS = 100;     // Rate of the 10 ms frame timer.
+
+    FrameCapture();
+    ~FrameCapture();  // Close().
+
+    /* path ending in ".y4m" records a video. Otherwise path is a printf
+     *   pattern for PNG files if it contains '%' (e.g. "cap/f%04d.png"),
+     *   or else a prefix: path + "00000.png", ...  A pattern must have one
+     *   %d or %0Nd and may escape '%' as %%; false for any other. Starts
+     *   the writer thread.
+     */
+    bool Open(const std::string &path, bool dropWhenFull);
+    bool IsOpen() const { return open; }
+
+    /* Where the pixel buffers come from; needed by Capture(). */
+    void SetResources(GpuResources *r) { resources = r; }
+
+    /* Starts reading back rect of the current read buffer. Call after the
+     *   frame is drawn and before it is presented.
+     */
+    void Capture(const ScissorRect &rect);
+
+    /* Queues a frame that is already in memory (RGBA, bottom-up), such as
+     *   one drawn by the CPU rasterizer. No GL.
+     */
+    void CapturePixels(int width, int height, const unsigned char *rgba);
+
+    /* Hands the readbacks still in flight to the writer. Needs the GL
+     *   context; call before it goes away.
+     */
+    void Flush();
+
+    /* Waits for the writer to finish, then prints a summary line. No GL. */
+    void Close();
+
+    // Outcome of the last Capture(), for FrameStats.
+    int    lastDropped;      // 1 if the frame it collected was dropped.
+    int    lastBlocked;      // 1 if it had to wait for the writer.
+    double lastWaitSeconds;
+
+  protected:
+    struct Frame
+    {
+        long index;
+        int width, height;
+        std::vector<unsigned char> pixels;  // RGBA, bottom-up.
+    };
+
+    struct Slot
+    {
+        GpuResources::Handle buffer;
+        bool pending;
+        long index;
+    };
+
+    bool open;
+    bool dropWhenFull;
+    bool video;
+    std::string path;
+
+    // Render thread.
+    GpuResources *resources;  // Not owned.
+    Slot slots[RING_SIZE];
+    int  nextSlot;
+    int  ringWidth, ringHeight;
+    long numCaptured;
+
+    // Shared with the writer thread, under mutex.
+    std::mutex mutex;
+    std::condition_variable notEmpty, notFull;
+    std::deque<Frame *> queue;
+    std::vector<Frame *> freeFrames;
+    bool quit;
+    long numWritten, numFailed, numDropped, numBlocked;
+    double blockSeconds;
+
+    // Writer thread.
+    std::thread writer;
+    Y4MWriter y4m;
+    bool errorShown;
+
+    void Allocate(int width, int height);
+    void Release();
+    void Collect(Slot &slot);
+    Frame *AcquireFrame();
+    void QueueFrame(Frame *frame, bool valid);
+    void WriterLoop();
+    bool WriteFrame(const Frame &frame);
+};
+
+
+#endif /* _FRAMECAPTURE_H */
@@ -0,0 +1,140 @@
+/* =============================================================================
+ * framegraph.h
+ * Masado Ishii
+ * v0.3 2026-10-19
+ *
+ * Description: A frame as a graph of passes. Each pass declares the
+ *   resources (framebuffers, plans, offscreen targets, ...) it reads and
+ *   writes; the graph orders the passes from that, drops those whose
+ *   results go unused, runs passes sharing GL state back to back, and
+ *   assigns transient targets to shared slots. It can time every pass.
+ *
+ * Attributions:
+ * =============================================================================
+ */
+
+#ifndef _FRAMEGRAPH_H
+#define _FRAMEGRAPH_H
+
+#include <functional>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+
+/* ------------------------------------------------------------------
+ * FrameGraph class.
+ *
+ * Built anew for each frame: Clear(), add resources, state groups and
+ *   passes, Compile(), Execute(). A read sees the writes of the passes
+ *   added before it, so the order passes are added in is a valid order;
+ *   Compile() may move a pass earlier to join a run of its state group,
+ *   but never across a pass it depends on or that depends on it.
+ *
+ * A pass is kept if it writes an output, or something a kept pass reads.
+ *   Pass timings survive Clear(), keyed by pass name, and are averaged
+ *   over the frames since ResetTimings().
+ * ------------------------------------------------------------------
+ */
+class FrameGraph
+{
+  public:
+    typedef std::function<void()> PassFn;
+    typedef int Resource;
+
+    static const int NO_GROUP = -1;
+
+    FrameGraph() : timed(false), numSlots(0), numMerged(0), timedFrames(0) {}
+
+    void Clear();
+
+    /* Transient resources exist only between the first and last pass of
+     *   the frame using them; Slot() tells which of NumSlots() shared
+     *   targets each gets, those of disjoint lifetimes sharing one.
+     */
+    Resource AddResource(const std::string &name, bool transient = false);
+
+    /* Marks r as a result of the frame (shown, captured, ...). */
+    void SetOutput(Resource r) { resources[r].output = true; }
+
+    /* GL state shared by the passes of the group: enter() runs before a
+     *   run of them, leave() after it.
+     */
+    int AddStateGroup(const std::string &name, const PassFn &enter, const PassFn &leave);
+
+    int AddPass(const std::string &name, const PassFn &fn, int group = NO_GROUP);
+    void Reads(int pass, Resource r) { passes[pass].reads.push_back(r); }
+    void Writes(int pass, Resource r) { passes[pass].writes.push_back(r); }
+
+    /* Orders and culls the passes and assigns slots. */
+    void Compile();
+
+    /* Runs the compiled passes; times them if timing is on. */
+    void Execute();
+
+    int Slot(Resource r) const { return resources[r].slot; }
+    int NumSlots() const { return numSlots; }
+
+    /* Times each pass, calling sync() (e.g. glFinish()) after it so that
+     *   the GPU work it queued is charged to it.
+     */
+    void SetTiming(bool on, const PassFn &sync = PassFn()) { timed = on; timingSync = sync; }
+    void ResetTimings() { timings.clear(); timedFrames = 0; }
+
+    /* Prints the last compiled frame: passes in order, with their group,
+     *   resources and mean time, then the culled passes.
+     */
+    void Dump(std::ostream &out) const;
+
+  protected:
+    struct Pass
+    {
+        std::string name;
+        PassFn fn;
+        int group;
+        std::vector<Resource> reads, writes;
+        std::vector<int> deps;     // Passes that must run before.
+        std::vector<int> sources;  // Of deps, those whose writes it reads.
+        bool live;
+    };
+    struct ResourceInfo
+    {
+        std::string name;
+        bool transient, output;
+        int slot;         // -1 unless transient and used.
+        int first, last;  // Schedule positions using it.
+    };
+    struct Group
+    {
+        std::string name;
+        PassFn enter, leave;
+    };
+    struct Timing
+    {
+        double seconds;
+        int frames;
+    };
+
+    std::vector<Pass> passes;
+    std::vector<ResourceInfo> resources;
+    std::vector<Group> groups;
+    std::vector<int> schedule;  // Live passes in the order they run.
+
+    bool timed;
+    PassFn timingSync;
+    int numSlots;
+    int numMerged;     // Passes run without entering their group again.
+    std::map<std::string, Timing> timings;
+    int timedFrames;
+
+    void AddDependencies();
+    void Cull();
+    void Schedule();
+    void AssignSlots();
+    void PrintResources(std::ostream &out, const char *label,
+            const std::vector<Resource> &list) const;
+};
+
+
+#endif /* _FRAMEGRAPH_H */
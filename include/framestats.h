@@ -0,0 +1,79 @@
+/* =============================================================================
+ * framestats.h
+ * Masado Ishii
+ * v0.3 2026-10-19
+ *
+ * Description: Frame timing and per-frame counters, reported periodically
+ *   as one line of text.
+ *
+ * Attributions:
+ * =============================================================================
+ */
+
+#ifndef _FRAMESTATS_H
+#define _FRAMESTATS_H
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+
+/* ------------------------------------------------------------------
+ * FrameStats class.
+ *
+ * Frame times are measured between BeginFrame() and EndFrame(). Counters
+ *   are summed over the report window and printed as per-frame means;
+ *   samples are printed as the mean of the samples taken.
+ * ------------------------------------------------------------------
+ */
+class FrameStats
+{
+  public:
+    FrameStats();
+
+    void SetEnabled(bool e) { enabled = e; }
+    bool Enabled() const { return enabled; }
+    void SetReportInterval(int frames) { reportInterval = frames; }
+    void SetOutput(std::ostream *out) { output = out; }
+
+    void BeginFrame();
+    void EndFrame();  // Reports once every reportInterval frames.
+
+    /* Adds value to the named counter for the current frame. */
+    void Count(const char *name, double value);
+
+    /* Adds one sample of value to the named mean, whatever the frame. */
+    void Sample(const char *name, double value);
+
+    /* Prints the current window and starts a new one. */
+    void Report();
+
+    // Statistics of the last reported window.
+    double LastMeanFrameTime() const { return lastMean; }
+    int    LastNumFrames() const { return lastFrames; }
+
+  protected:
+    struct Counter
+    {
+        std::string name;
+        double sum;
+        int samples;  // 0 for a per-frame counter.
+    };
+
+    Counter &Find(const char *name);
+
+    bool enabled;
+    int reportInterval;
+    std::ostream *output;
+
+    double frameStart;
+    int    numFrames;
+    double sumTime, minTime, maxTime;
+    std::vector<Counter> counters;
+
+    double lastMean;
+    int    lastFrames;
+};
+
+
+#endif /* _FRAMESTATS_H */
@@ -0,0 +1,128 @@
+/* =============================================================================
+ * gpuresources.h
+ * Masado Ishii
+ * v0.3 2026-10-19
+ *
+ * Description: Ownership and accounting of the GL objects that hold memory:
+ *   display lists, buffers, textures and framebuffers. Objects are created
+ *   and deleted through the manager, which knows the bytes each holds, and
+ *   keeps the total under a budget by evicting the least recently used of
+ *   those that can be rebuilt. Rebuilding is spread over frames.
+ *
+ * Attributions:
+ * =============================================================================
+ */
+
+// Note: This file uses the GL api, but nothing from VTK.
+
+#ifndef _GPURESOURCES_H
+#define _GPURESOURCES_H
+
+#include <cstddef>
+#include <deque>
+#include <vector>
+
+#include <GL/gl.h>
+
+
+/* ------------------------------------------------------------------
+ * GpuResources class.
+ *
+ * Objects are named by handles, small integers; -1 is no object. Calls
+ *   that create or delete objects need the context current. The manager
+ *   deletes nothing on its own destruction: GL objects die with their
+ *   context, and Release() frees them earlier.
+ *
+ * An object created with an owner is evictable. At EndFrame(), if the
+ *   total is over budget, owners of objects not used (Touch()) this frame
+ *   are asked to Evict() them, least recently used first. An owner that
+ *   needs its objects again asks for a restore; queued restores run first
+ *   at EndFrame(), up to RESTORE_BYTES per frame and only while under the
+ *   budget, so that what they rebuild displaces what went unused.
+ * ------------------------------------------------------------------
+ */
+class GpuResources
+{
+  public:
+    enum Category { LISTS, BUFFERS, TEXTURES, FRAMEBUFFERS, NUM_CATEGORIES };
+    typedef int Handle;
+
+    // Restores stop after this many bytes in a frame (at least one runs).
+    static const size_t RESTORE_BYTES = 1 << 20;
+
+    /* Keeps what it needs to rebuild its evictable objects. */
+    class Owner
+    {
+      public:
+        virtual ~Owner() {}
+
+        /* Deletes all of its objects with Delete() and forgets their handles. */
+        virtual void Evict(GpuResources &resources) = 0;
+
+        /* Rebuilds them, after RequestRestore(). */
+        virtual void Restore(GpuResources &resources) {}
+    };
+
+    GpuResources();
+
+    /* Total bytes to keep to; 0 for no limit. */
+    void SetBudget(size_t bytes) { budget = bytes; }
+    size_t Budget() const { return budget; }
+
+    /* A new GL object of category c; evictable if owner is not NULL. */
+    Handle Create(Category c, Owner *owner = NULL);
+    void Delete(Handle h);
+
+    GLuint Name(Handle h) const { return entries[h].name; }
+
+    /* The bytes h holds, as allocated by its owner; display lists are
+     *   estimated from the data compiled into them.
+     */
+    void SetBytes(Handle h, size_t bytes);
+
+    /* Marks h used this frame. */
+    void Touch(Handle h) { entries[h].lastUse = frame; }
+
+    void RequestRestore(Owner *owner);
+    void CancelRestore(Owner *owner);
+
+    void BeginFrame() { frame++; }
+
+    /* Runs queued restores while under budget, then evicts down to it. */
+    void EndFrame();
+
+    /* Evicts everything evictable and deletes the rest. Call before the
+     *   context is destroyed; handles held elsewhere are void afterwards.
+     */
+    void Release();
+
+    size_t Bytes(Category c) const { return categoryBytes[c]; }
+    size_t TotalBytes() const;
+
+    // Counters of the last EndFrame(), for FrameStats.
+    int    numEvicted;     // Owners evicted.
+    size_t restoredBytes;
+    bool   overBudget;     // Still over after evicting all it could.
+
+  protected:
+    struct Entry
+    {
+        Category category;
+        GLuint name;         // 0 for a free entry.
+        size_t bytes;
+        Owner *owner;        // NULL if not evictable.
+        unsigned long lastUse;
+    };
+
+    std::vector<Entry> entries;
+    std::vector<Handle> freeHandles;
+    std::deque<Owner *> restores;
+    size_t categoryBytes[NUM_CATEGORIES];
+    size_t budget;
+    unsigned long frame;
+
+    void Evict(Owner *owner);
+};
+
+
+#endif /* _GPURESOURCES_H */
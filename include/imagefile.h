@@ -0,0 +1,76 @@
+/* =============================================================================
+ * imagefile.h
+ * Masado Ishii
+ * v0.3 2026-10-19
+ *
+ * Description: Dependency-free writers for captured frames: PNG images and
+ *   raw YUV4MPEG2 (.y4m) video.
+ *
+ * Attributions:
+ *   > PNG layout per the W3C PNG specification; deflate "stored" blocks per
+ *     RFC 1951, zlib framing per RFC 1950.
+ *   > YUV4MPEG2 layout as read by ffmpeg and mpv.
+ * =============================================================================
+ */
+
+#ifndef _IMAGEFILE_H
+#define _IMAGEFILE_H
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+
+/* ------------------------------------------------------------------
+ * Image routines.
+ *
+ * Pixels are RGBA, 8 bits per channel, rows stored bottom-up as read back
+ *   by glReadPixels(). Writers return false if the file could not be
+ *   written.
+ * ------------------------------------------------------------------
+ */
+
+/* Writes an RGB PNG (alpha is dropped). The image data is not compressed,
+ *   so files are about 3 bytes per pixel; they are meant to be compressed
+ *   or encoded to video afterwards.
+ */
+bool WritePNG(const std::string &path, int width, int height,
+        const unsigned char *rgba);
+
+/* Reads a PNG as WritePNG() writes them (8-bit RGB, stored deflate
+ *   blocks, no filtering) into rgba, alpha 255. Returns false for any
+ *   other PNG, or if the file could not be read.
+ */
+bool ReadPNG(const std::string &path, int &width, int &height,
+        std::vector<unsigned char> &rgba);
+
+
+/* ------------------------------------------------------------------
+ * Y4MWriter class.
+ *
+ * 4:2:0 video, full-range BT.601 (C420jpeg). Every frame must have the
+ *   size of the first.
+ * ------------------------------------------------------------------
+ */
+class Y4MWriter
+{
+  public:
+    Y4MWriter() : file(NULL), width(0), height(0), fps(0) {}
+    ~Y4MWriter() { Close(); }
+
+    bool Open(const std::string &path, int width, int height, int fps);
+    bool WriteFrame(const unsigned char *rgba);
+    void Close();
+
+    bool IsOpen() const { return file != NULL; }
+    int Width() const { return width; }
+    int Height() const { return height; }
+
+  protected:
+    FILE *file;
+    int width, height, fps;
+    std::string planes;  // Scratch: Y, then Cb, then Cr.
+};
+
+
+#endif /* _IMAGEFILE_H */
@@ -15,23 +15,90 @@
 #ifndef _MESH_H
 #define _MESH_H
 
+#include <vector>
+
 #include <GL/gl.h>
 
+#include "utility.h"  // glm types for bounds.
+#include "gpuresources.h"
+
+class PolygonMesh;
+
 /* ------------------------------------------------------------------
  * Mesh class.
+ *
+ * The model-space bounding box is optional. Meshes without bounds are
+ * treated conservatively (assumed to cover the whole screen) wherever
+ * bounds are used for culling.
  * ------------------------------------------------------------------
  */
 class Mesh
 {
   public:
+    glm::vec3 boundsMin, boundsMax;
+    bool hasBounds;
+
+    Mesh() : hasBounds(false) {}
+    virtual ~Mesh() {}
     virtual void Draw() = 0;
+
+    /* Geometry on the CPU side (ray casting), if the mesh keeps any. */
+    virtual const PolygonMesh *AsPolygonMesh() const { return NULL; }
+
+    void SetBounds(const glm::vec3 &bmin, const glm::vec3 &bmax)
+    {
+        boundsMin = bmin;
+        boundsMax = bmax;
+        hasBounds = true;
+    }
 };
 
 
-/* ----------------
- * PolygonMesh TBA.
- * ----------------
+/* ------------------------------------------------------------------
+ * PolygonMesh class.
+ *
+ * Colored triangles kept on the CPU, so that they can also be ray cast.
+ *   Front faces wind counterclockwise. Compiled into a display list of
+ *   the GpuResources on the first Draw(), which therefore needs a GL
+ *   context; building the mesh does not. Once the list is evicted, the
+ *   mesh is drawn from the CPU copy until the list is restored. Without
+ *   GpuResources it is always drawn that way.
+ * ------------------------------------------------------------------
  */
+class PolygonMesh : public Mesh, public GpuResources::Owner
+{
+  public:
+    std::vector<glm::vec3> positions;  // Per vertex.
+    std::vector<glm::vec3> colors;     // Per vertex.
+    std::vector<GLuint> triangles;     // Three vertex indices per triangle.
+
+    PolygonMesh() : resources(NULL), displayList(-1), evicted(false) {}
+    virtual ~PolygonMesh();  // Deletes the list; needs the context if there is one.
+
+    void SetResources(GpuResources *r) { resources = r; }
+
+    GLuint AddVertex(const glm::vec3 &position, const glm::vec3 &color);
+    void AddTriangle(GLuint a, GLuint b, GLuint c);
+    void AddQuad(GLuint a, GLuint b, GLuint c, GLuint d);  // As two triangles.
+    int NumTriangles() const { return (int) triangles.size() / 3; }
+
+    /* Sets the bounds to those of the vertices. */
+    void ComputeBounds();
+
+    void Draw();
+    virtual const PolygonMesh *AsPolygonMesh() const { return this; }
+
+    virtual void Evict(GpuResources &resources);
+    virtual void Restore(GpuResources &resources);
+
+  protected:
+    GpuResources *resources;  // Not owned.
+    GpuResources::Handle displayList;
+    bool evicted;             // Waiting for a restore.
+
+    void Compile();
+    void DrawImmediate() const;
+};
 
 
 /* ------------------------------------------------------------------
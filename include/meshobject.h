@@ -23,6 +23,7 @@
  * ------------------------------------------------------------------
  */
 class MeshObject;
+class PortalObject;
 typedef std::list<MeshObject *> MeshObjList;
 
 
@@ -40,7 +41,11 @@ class MeshObject
             : mesh(mesh), modelMat(modelMat) {}
     virtual ~MeshObject() {};
     virtual void Draw() const;
-    //void Draw() const;   // DEBUG hack: switch these to enable/disable portals.
+
+    /* Lets the portal frame planner tell portals apart from plain
+     *   objects without a dynamic_cast per object per view.
+     */
+    virtual const PortalObject *AsPortal() const { return NULL; }
     
     static void DrawList(MeshObjList &l);
 };
@@ -50,18 +55,14 @@ class MeshObject
  * PortalObject class.
  *
  * Rays go into the +Z side and come out of the +Z side.
+ *
+ * Recursive rendering through portals is planned and executed by
+ *   PortalFramePlanner / PortalFrameRenderer (portalplan.h). On its
+ *   own, a PortalObject draws as an opaque surface.
  * ------------------------------------------------------------------
  */
 class PortalObject : public MeshObject
 {
-  protected:
-    // An internal mechanism to count and limit the portal recursion depth.
-    static const int MAX_PORTAL_RECURSION_DEPTH = 2;
-    static int currentPortalRecursionDepth;  // Must be class-level so that child implementations of Draw() can access.
-             // Initialization of currentPortalRecursionDepth is in class implementation.
-    static PortalObject *oldDestPortal;
-             // Initialization of oldDestPortal is in class implementation.
-
   public:
     MeshObjList *parentScene;
     PortalObject *destPortal;
@@ -69,7 +70,8 @@ class PortalObject : public MeshObject
     /* Constructor */
     PortalObject(Mesh *mesh, MeshObjList *scene, PortalObject *portal = NULL,
             glm::mat4 modelMat = glm::mat4(1.0))
-            : MeshObject(mesh, modelMat), parentScene(scene), destPortal(portal) {}
+            : MeshObject(mesh, modelMat), parentScene(scene), destPortal(portal),
+              version(NextVersion()) {}
 
     /* Establishes one direction of the portal link.
      * Currently no way to check that two portals are pointed at each other.
@@ -78,13 +80,30 @@ class PortalObject : public MeshObject
      * Returns true if portal link was set, false otherwise.
      */
     bool SetDestPortal(PortalObject *portal);
-    
-    /* Overrides MeshObject::Draw, rendering scene from perspective of the
-     *   destination portal.
-     * Will render through additional portals on the other side if visible,
-     *   up to MAX_PORTAL_RECURSION_DEPTH.
+
+    /* The transform taking the view through this portal to the view
+     *   from behind destPortal:  modelMat * aboutFace * inverse(dest).
+     * A view matrix C seen through this portal becomes C * LinkMatrix().
      */
-    virtual void Draw() const;
+    glm::mat4 LinkMatrix() const;
+
+    /* Call after changing modelMat, so that transforms cached from it
+     *   (PortalTransformCache) are recomputed. SetDestPortal() calls it.
+     */
+    void Moved() { version = NextVersion(); }
+
+    /* Changes whenever the portal is moved or relinked. Values come from
+     *   one process-wide counter, so no two portals ever share one, even
+     *   at the same address.
+     */
+    unsigned long Version() const { return version; }
+
+    virtual const PortalObject *AsPortal() const { return this; }
+
+  protected:
+    unsigned long version;
+
+    static unsigned long NextVersion();
 };
 
 
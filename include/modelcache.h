@@ -0,0 +1,80 @@
+/* =============================================================================
+ * modelcache.h
+ * Masado Ishii
+ * v0.3 2026-10-19
+ *
+ * Description: Imported models. Wavefront OBJ files are parsed once into a
+ *   binary cache file beside them, holding each object's vertex and index
+ *   arrays in the layout PolygonMesh keeps, its bounds, and a table of the
+ *   objects; later runs map the cache instead of parsing.
+ *
+ * Attributions:
+ *   > OBJ subset per the Wavefront "Object Files (.obj)" appendix: v, f, o
+ *     and g statements; "v x y z r g b" vertex colors as written by
+ *     MeshLab and Blender.
+ * =============================================================================
+ */
+
+#ifndef _MODELCACHE_H
+#define _MODELCACHE_H
+
+#include <string>
+#include <vector>
+
+#include "mesh.h"
+
+
+/* ------------------------------------------------------------------
+ * ModelCache class.
+ *
+ * Load() reads the model at path into one PolygonMesh per object, with
+ *   bounds set. The cache, path + ".fvc", is used if its header matches
+ *   this build (version, sizes, byte order) and the hash of the source
+ *   file's contents; otherwise the OBJ is parsed and the cache rewritten.
+ *   A cache that cannot be written only costs the next run a parse.
+ *
+ * Mapped arrays are copied into the meshes whole, one copy per array:
+ *   the meshes keep a CPU copy for ray casting and the software
+ *   rasterizer, and compile their display lists from it.
+ * ------------------------------------------------------------------
+ */
+class ModelCache
+{
+  public:
+    // Bump when the file layout or the parse changes.
+    static const unsigned VERSION = 1;
+
+    enum Source { NONE, PARSED, CACHED };
+
+    struct Object
+    {
+        std::string name;
+        PolygonMesh *mesh;  // Owned by the caller after Load().
+    };
+
+    ModelCache() : source(NONE), seconds(0.0), hashSeconds(0.0), cacheBytes(0) {}
+
+    /* Appends the model's objects to objects; false if it could not be
+     *   read (reported on std::cerr).
+     */
+    bool Load(const std::string &path, std::vector<Object> &objects);
+
+    static std::string CachePath(const std::string &path) { return path + ".fvc"; }
+
+    // Of the last Load().
+    Source source;
+    double seconds;       // All of Load().
+    double hashSeconds;   // Hashing the source, within seconds.
+    size_t cacheBytes;
+
+  protected:
+    bool ReadCache(const std::string &cachePath, unsigned long long sourceHash,
+            std::vector<Object> &objects);
+    bool WriteCache(const std::string &cachePath, unsigned long long sourceHash,
+            const std::vector<Object> &objects);
+    static bool ParseOBJ(const std::string &path, const char *text, size_t n,
+            std::vector<Object> &objects);
+};
+
+
+#endif /* _MODELCACHE_H */
@@ -0,0 +1,134 @@
+/* =============================================================================
+ * parallel.h
+ * Masado Ishii
+ * v0.3 2026-10-19
+ *
+ * Description: Worker threads for the CPU side of the renderer: a pool for
+ *   evenly sized data-parallel loops, and a work-stealing scheduler for
+ *   tasks of uneven cost.
+ *
+ * Attributions:
+ * =============================================================================
+ */
+
+#ifndef _PARALLEL_H
+#define _PARALLEL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+/* ------------------------------------------------------------------
+ * WorkerPool class.
+ *
+ * ParallelFor() splits [0, n) into one contiguous chunk per thread and
+ *   blocks until all chunks are done. The calling thread runs chunk 0.
+ *   Not reentrant: call it from one thread at a time.
+ * ------------------------------------------------------------------
+ */
+class WorkerPool
+{
+  public:
+    // fn(begin, end, chunk) processes items [begin, end).
+    typedef std::function<void(int, int, int)> RangeFn;
+
+    /* numThreads counts the calling thread; 0 picks one per core. */
+    explicit WorkerPool(int numThreads = 0);
+    ~WorkerPool();
+
+    int NumThreads() const { return (int) workers.size() + 1; }
+
+    void ParallelFor(int n, const RangeFn &fn);
+
+    /* Process-wide pool, created on first use. */
+    static WorkerPool &Shared();
+
+    /* In a child after fork(), gives Shared() new threads; references to
+     *   the old pool must not be used.
+     */
+    static void RestartShared();
+
+  protected:
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake, done;
+
+    const RangeFn *job;
+    int jobSize;
+    unsigned long generation;
+    int pending;
+    bool quit;
+
+    void WorkerLoop(int chunk);
+    void RunChunk(int chunk);
+};
+
+
+/* ------------------------------------------------------------------
+ * TaskScheduler class.
+ *
+ * Run() executes tasks [0, n) and blocks until all are done. The tasks
+ *   are dealt out as one contiguous range per thread; a thread runs its
+ *   range from the front, and once it is empty steals the back half of
+ *   another thread's. So tasks of uneven cost still finish together, and
+ *   neighbouring tasks mostly run on the same thread. The calling thread
+ *   is thread 0. Not reentrant: call it from one thread at a time.
+ * ------------------------------------------------------------------
+ */
+class TaskScheduler
+{
+  public:
+    // fn(task, thread) runs one task; thread is in [0, NumThreads()).
+    typedef std::function<void(int, int)> TaskFn;
+
+    /* numThreads counts the calling thread; 0 picks one per core. */
+    explicit TaskScheduler(int numThreads = 0);
+    ~TaskScheduler();
+
+    int NumThreads() const { return (int) workers.size() + 1; }
+
+    void Run(int numTasks, const TaskFn &fn);
+
+    /* Ranges stolen during the last Run(). */
+    long NumSteals() const { return numSteals; }
+
+    /* Process-wide scheduler, created on first use. */
+    static TaskScheduler &Shared();
+
+    /* As WorkerPool::RestartShared(). */
+    static void RestartShared();
+
+  protected:
+    // Tasks [begin, end) not yet started by their owner.
+    struct Queue
+    {
+        std::mutex mutex;
+        int begin, end;
+        char pad[64];  // Keeps the next queue's lock off this cache line.
+
+        Queue() : begin(0), end(0) {}
+    };
+
+    std::vector<std::thread> workers;
+    std::vector<Queue> queues;  // One per thread.
+    std::mutex mutex;
+    std::condition_variable wake, done;
+
+    const TaskFn *job;
+    unsigned long generation;
+    int pending;
+    bool quit;
+    std::atomic<long> numSteals;
+
+    void WorkerLoop(int thread);
+    void RunTasks(int thread);
+    bool Pop(int thread, int &task);
+    bool Steal(int thread);
+};
+
+
+#endif /* _PARALLEL_H */
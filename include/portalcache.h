@@ -0,0 +1,124 @@
+/* =============================================================================
+ * portalcache.h
+ * Masado Ishii
+ * v0.3 2026-10-19
+ *
+ * Description: Camera-independent transforms of the portal graph, kept
+ *   from frame to frame. Portals rarely move, so the frame planner looks
+ *   up each portal's link and each portal chain's composed transform here
+ *   instead of recomputing them, and only applies the camera every frame.
+ *
+ * Attributions:
+ * =============================================================================
+ */
+
+#ifndef _PORTALCACHE_H
+#define _PORTALCACHE_H
+
+#include <cstddef>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "meshobject.h"
+#include "utility.h"
+
+
+/* ------------------------------------------------------------------
+ * PortalTransformCache class.
+ *
+ * Holds each portal's LinkMatrix() and inverse model matrix, and for each
+ *   chain of portals (A -> B -> A ...) the product of their links and its
+ *   inverse. A chain is named by an id: ROOT is the empty chain, and
+ *   Extend() names its parent chain followed by one more portal. Entries
+ *   remember the Version() of the portals they came from (each portal and
+ *   its destination) and the parent chain's, so moving or relinking a
+ *   portal recomputes only what depends on it.
+ * ------------------------------------------------------------------
+ */
+class PortalTransformCache
+{
+  public:
+    static const int ROOT = 0;
+
+    // BeginFrame() drops everything once there are more chains or links
+    //   than this, so that ones no longer seen do not pile up.
+    static const int MAX_CHAINS = 1 << 16;
+
+    struct Link
+    {
+        glm::mat4 linkMat;      // portal->LinkMatrix().
+        glm::mat4 invModelMat;  // inverse(portal->modelMat).
+    };
+
+    struct Chain
+    {
+        glm::mat4 chainMat;     // Product of the links, root first.
+        glm::mat4 invChainMat;
+    };
+
+    PortalTransformCache();
+
+    /* Resets the counters. Chain ids from earlier frames are invalid. */
+    void BeginFrame();
+
+    /* Link of portal, which must have a destPortal. The reference stays
+     *   valid until the portal changes.
+     */
+    const Link &GetLink(const PortalObject *portal);
+
+    /* Id of chain parent followed by portal, which must have a destPortal. */
+    int Extend(int parent, const PortalObject *portal);
+
+    /* Chain id; the reference is only valid until the next Extend(). */
+    const Chain &GetChain(int id) const { return chains[id].chain; }
+
+    void Clear();
+    int NumChains() const { return (int) chains.size() - 1; }
+
+    // Lookups since BeginFrame().
+    long linkHits, linkMisses;
+    long chainHits, chainMisses;
+
+    /* Share of the lookups since BeginFrame() that hit, in [0, 1]. */
+    double HitRate() const;
+
+  protected:
+    struct LinkEntry
+    {
+        Link link;
+        const PortalObject *dest;
+        unsigned long version, destVersion;
+
+        LinkEntry() : dest(NULL), version(0), destVersion(0) {}
+    };
+
+    struct ChainEntry
+    {
+        Chain chain;
+        const PortalObject *dest;
+        unsigned long version, destVersion;
+        unsigned long stamp;        // New each time chain is computed.
+        unsigned long parentStamp;  // The parent's, when this was computed.
+
+        ChainEntry()
+            : dest(NULL), version(0), destVersion(0), stamp(0), parentStamp(0) {}
+    };
+
+    typedef std::pair<int, const PortalObject *> ChainKey;
+    struct ChainKeyHash
+    {
+        size_t operator()(const ChainKey &k) const
+        {
+            return std::hash<const void *>()(k.second) ^ ((size_t) k.first * 0x9E3779B9u);
+        }
+    };
+
+    std::unordered_map<const PortalObject *, LinkEntry> links;
+    std::unordered_map<ChainKey, int, ChainKeyHash> chainIds;
+    std::vector<ChainEntry> chains;  // By id; chains[ROOT] is the identity.
+    unsigned long nextStamp;
+};
+
+
+#endif /* _PORTALCACHE_H */
@@ -0,0 +1,487 @@
+/* =============================================================================
+ * portalplan.h
+ * Masado Ishii
+ * v0.3 2026-10-19
+ *
+ * Description: Breadth-first frame planning for portal rendering. The
+ *   planner walks the portal graph once per frame and produces an explicit
+ *   list of views (portal chain, stencil ref, scissor rectangle), grouped by
+ *   recursion depth. The renderer then draws each depth level as a batch.
+ *
+ * Stencil scheme:
+ *   Every view owns a stencil value. The root view owns 0 (the cleared
+ *   value). A child view is marked by drawing its portal silhouette where
+ *   stencil == parent value, flipping exactly the bits (parent ^ child) with
+ *   GL_INVERT, so any pair of values can be nested. Sibling portals are
+ *   marked nearest-first so the nearer one keeps the overlap.
+ *
+ *   Values come from a StencilAllocator. Once every value is taken, a value
+ *   is shared between views whose scissor rectangles are disjoint; every
+ *   pass is scissored to its view, so those views cannot see each other's
+ *   pixels. A portal that still gets no value is drawn as a surface.
+ *
+ * Resolution scaling:
+ *   Nested views may be drawn offscreen at a fraction of window resolution,
+ *   then upsampled into their portal region with their depth (viewscaling.h).
+ *   The fraction falls with depth as quality^depth, but a view keeps at
+ *   least MIN_SCALED_PIXELS, so small portals stay sharp.
+ *
+ * Multi-view (stereo):
+ *   PlanMultiView() walks the portal graph once for several eyes, culling
+ *   against a shared frustum that contains all of theirs, and records for
+ *   every view each eye's modelview and scissor rectangle. The renderer
+ *   then draws each level once per eye, into the eye's own viewport of the
+ *   same framebuffer. A stencil value is only shared between views that
+ *   are disjoint in every eye. Views are not resolution-scaled.
+ *
+ * Draw lists:
+ *   Once the views are known, every view's objects are culled against its
+ *   scissor rectangle and gathered, sorted by mesh, into its draw list,
+ *   with their modelviews and the runs of one mesh as draw commands. This
+ *   is split into tasks of a view and a slice of its scene, which run on
+ *   a TaskScheduler, so the GL thread only replays the commands.
+ *
+ * Attributions:
+ * =============================================================================
+ */
+
+// Note: This file uses the GL api, but nothing from VTK.
+
+#ifndef _PORTALPLAN_H
+#define _PORTALPLAN_H
+
+#include <vector>
+
+#include "mesh.h"
+#include "meshobject.h"
+#include "parallel.h"
+#include "portalcache.h"
+#include "utility.h"
+
+
+/* ------------------------------------------------------------------
+ * ScissorRect struct.
+ *
+ * Window coordinates, origin at lower left, as for glScissor().
+ * ------------------------------------------------------------------
+ */
+struct ScissorRect
+{
+    int x, y, width, height;
+
+    ScissorRect() : x(0), y(0), width(0), height(0) {}
+    ScissorRect(int x, int y, int w, int h) : x(x), y(y), width(w), height(h) {}
+
+    bool Empty() const { return width <= 0 || height <= 0; }
+    ScissorRect Intersect(const ScissorRect &o) const;
+    ScissorRect Union(const ScissorRect &o) const;  // Bounding rect; ignores empty ones.
+    bool Overlaps(const ScissorRect &o) const { return !Intersect(o).Empty(); }
+};
+
+
+/* ------------------------------------------------------------------
+ * StencilAllocator class.
+ *
+ * Hands out stencil values to views within a budget of stencil bits.
+ * ------------------------------------------------------------------
+ */
+class StencilAllocator
+{
+  public:
+    static const int MAX_STENCIL_BITS = 8;
+    static const int MAX_VALUES = 1 << MAX_STENCIL_BITS;
+
+    StencilAllocator() : numValues(MAX_VALUES), nextFresh(1), numShared(0) {}
+
+    /* Frees all values, then gives value 0 to the root view. */
+    void Reset(const ScissorRect &rootRect, int stencilBits = MAX_STENCIL_BITS);
+
+    /* Returns a value no other view with an overlapping rect holds,
+     *   or -1 if there is none.
+     */
+    GLint Allocate(const ScissorRect &rect);
+
+    int NumShared() const { return numShared; }
+    int NumFresh() const { return nextFresh; }
+
+  protected:
+    // Past this many holders a value is not considered for sharing, to
+    //   bound the cost of a failed search.
+    static const int MAX_SHARED_HOLDERS = 16;
+
+    int numValues;
+    int nextFresh;
+    int numShared;
+    std::vector<ScissorRect> holders[MAX_VALUES];
+    ScissorRect holderBounds[MAX_VALUES];  // Union of holders' rects.
+
+    void Hold(GLint value, const ScissorRect &rect);
+};
+
+
+/* ------------------------------------------------------------------
+ * DrawCommand struct.
+ *
+ * A run of a view's draw list that shares one mesh: entries
+ *   [first, first + count) of drawList and modelViews.
+ * ------------------------------------------------------------------
+ */
+struct DrawCommand
+{
+    Mesh *mesh;
+    int first, count;
+};
+
+
+/* ------------------------------------------------------------------
+ * PortalView struct.
+ *
+ * One rendering of a scene, as seen through a chain of portals.
+ * ------------------------------------------------------------------
+ */
+struct PortalView
+{
+    int parent;                      // Index of the enclosing view; -1 for the root.
+    int depth;                       // Portal recursion depth; the root is 0.
+    const PortalObject *portal;      // Portal (drawn in the parent view) we look through.
+    const PortalObject *skipPortal;  // portal->destPortal; not drawn inside this view.
+    MeshObjList *scene;
+
+    glm::mat4 chainMat;  // Product of LinkMatrix() along the portal chain.
+    glm::mat4 viewMat;   // Modelview for this view: rootView * chainMat.
+
+    GLint stencilRef;
+    ScissorRect scissor;
+    float resolutionScale;  // Fraction of window resolution to draw at; 1 for all of it.
+
+    std::vector<const MeshObject *> drawList;  // Drawn as surfaces, sorted by mesh;
+                                               //   none outside scissor.
+    std::vector<glm::mat4> modelViews;         // viewMat * modelMat of each drawList entry.
+    std::vector<DrawCommand> commands;         // drawList in runs of one mesh.
+    std::vector<int> children;                 // Child views, nearest first.
+};
+
+
+/* ------------------------------------------------------------------
+ * EyeCamera struct.
+ *
+ * Camera of one eye of a multi-view frame, and its part of the framebuffer.
+ *   Eyes are expected to share their orientation, as in off-axis stereo.
+ * ------------------------------------------------------------------
+ */
+struct EyeCamera
+{
+    glm::mat4 viewMat, projMat;
+    ScissorRect viewport;
+};
+
+
+/* ------------------------------------------------------------------
+ * PortalEye struct.
+ *
+ * The views of a plan as one eye sees them; indexed like plan.views.
+ * ------------------------------------------------------------------
+ */
+struct PortalEye
+{
+    static const int MAX_EYES = 4;
+
+    EyeCamera camera;
+    std::vector<glm::mat4>   viewMats;  // camera.viewMat * chainMat.
+    std::vector<ScissorRect> scissors;  // Empty where this eye cannot see the view.
+};
+
+
+/* ------------------------------------------------------------------
+ * PortalFramePlan class.
+ *
+ * Views are stored breadth-first, so that each recursion depth is a
+ *   contiguous range [LevelBegin(d), LevelEnd(d)).
+ * ------------------------------------------------------------------
+ */
+class PortalFramePlan
+{
+  public:
+    std::vector<PortalView> views;
+    std::vector<int> levelBegin;  // One entry per level, plus an end sentinel.
+    std::vector<PortalEye> eyes;  // Empty unless planned with PlanMultiView().
+
+    int numCulled;   // Portals skipped as back-facing or off-screen.
+    int numDemoted;  // Portals drawn as surfaces for lack of a stencil value.
+    int numShared;   // Views given a stencil value shared with a disjoint view.
+    int numScaled;   // Views to be drawn below full resolution.
+    int numObjectsCulled;  // Objects left out of a view's draw list as off-screen.
+    int numCommands;       // Draw commands of all views.
+
+    PortalFramePlan()
+        : numCulled(0), numDemoted(0), numShared(0), numScaled(0),
+          numObjectsCulled(0), numCommands(0) {}
+
+    void Clear();
+    int NumLevels() const { return levelBegin.empty() ? 0 : (int) levelBegin.size() - 1; }
+    int LevelBegin(int d) const { return levelBegin[d]; }
+    int LevelEnd(int d) const { return levelBegin[d+1]; }
+};
+
+
+/* ------------------------------------------------------------------
+ * PortalFramePlanner class.
+ * ------------------------------------------------------------------
+ */
+class PortalFramePlanner
+{
+  public:
+    // Views through portals are nested at most this deep. Portals seen
+    //   inside the deepest views are drawn as surfaces.
+    static const int MAX_PORTAL_RECURSION_DEPTH = 2;
+
+    // Resolution scaling never takes a view below this many pixels, nor
+    //   below MIN_RESOLUTION_SCALE of its window size.
+    static const int MIN_SCALED_PIXELS = 96 * 96;
+    static const float MIN_RESOLUTION_SCALE;
+
+    // Objects per draw list task.
+    static const int CULL_TASK_OBJECTS = 256;
+
+    PortalFramePlanner()
+        : stencilBits(StencilAllocator::MAX_STENCIL_BITS), viewQuality(1.0f),
+          scheduler(&TaskScheduler::Shared()), buildSeconds(0.0), numScenes(0) {}
+
+    /* Number of stencil bits the allocator may use (at most 8). */
+    void SetStencilBits(int bits) { stencilBits = bits; }
+
+    /* Resolution of nested views, in (0, 1]: a view at depth d is drawn
+     *   at quality^d of window resolution. 1 draws everything at full size.
+     */
+    void SetViewQuality(float q) { viewQuality = q; }
+    float ViewQuality() const { return viewQuality; }
+
+    /* Where draw lists are built; the shared scheduler by default. */
+    void SetScheduler(TaskScheduler *s) { scheduler = s; }
+
+    /* Time the last Plan() or Reproject() spent building draw lists. */
+    double BuildSeconds() const { return buildSeconds; }
+
+    /* Portal links and chains kept across frames; its counters are the
+     *   last Plan()'s.
+     */
+    const PortalTransformCache &Transforms() const { return transforms; }
+
+    /* Walks the portal graph breadth-first from the root view and fills
+     *   plan. projMat and viewport are used to compute scissor rectangles
+     *   and to cull portals that cannot be seen.
+     */
+    void Plan(MeshObjList &scene, const glm::mat4 &viewMat,
+            const glm::mat4 &projMat, const ScissorRect &viewport,
+            PortalFramePlan &plan);
+
+    /* As Plan(), once for all of cameras (at most PortalEye::MAX_EYES),
+     *   filling plan.eyes. The root view holds the shared camera.
+     */
+    void PlanMultiView(MeshObjList &scene, const std::vector<EyeCamera> &cameras,
+            PortalFramePlan &plan);
+
+    /* Camera at the eyes' mean position whose frustum contains every
+     *   eye's, with a viewport the size of the first eye's.
+     */
+    static EyeCamera SharedCamera(const std::vector<EyeCamera> &cameras);
+
+    /* Moves a planned frame to the camera viewMat without walking the
+     *   portal graph again: every view's modelview and scissor rectangle
+     *   are recomputed, and its draw lists rebuilt; its portals are kept.
+     *   Portals that come into sight are not added until the next Plan().
+     *   plan must be the last one this planner made. Returns false,
+     *   changing nothing, unless CanReproject(plan).
+     */
+    bool Reproject(PortalFramePlan &plan, const glm::mat4 &viewMat,
+            const glm::mat4 &projMat, const ScissorRect &viewport);
+
+    /* Plans that share stencil values or have eyes depend on their planned
+     *   rectangles for correctness, and cannot be reprojected.
+     */
+    static bool CanReproject(const PortalFramePlan &plan)
+        { return plan.numShared == 0 && plan.eyes.empty() && !plan.views.empty(); }
+
+    /* Screen rectangle covered by obj's mesh bounds under viewMat, clipped
+     *   to clip. Returns an empty rectangle if the bounds are entirely off
+     *   screen. Meshes without bounds, or bounds crossing the near plane,
+     *   conservatively get all of clip.
+     */
+    static ScissorRect ProjectBounds(const MeshObject &obj,
+            const glm::mat4 &viewMat, const glm::mat4 &projMat,
+            const ScissorRect &viewport, const ScissorRect &clip);
+
+    /* Resolution scale of a view at depth covering rect. */
+    static float ResolutionScale(int depth, const ScissorRect &rect, float quality);
+
+  protected:
+    // A scene's objects, in list order, for the frame being planned.
+    struct SceneIndex
+    {
+        MeshObjList *scene;
+        std::vector<const MeshObject *> objects;
+        std::vector<int> portals;  // Indices of objects that are linked portals.
+    };
+
+    // Objects of one view, in scene order, to be sorted into its draw list.
+    struct CullTask
+    {
+        int view;
+        int begin, end;          // Range of the scene's objects culled.
+        std::vector<int> shown;  // Those passing; for the first task of a view,
+                                 //   then all of the view's draw list.
+        int numCulled;
+    };
+
+    int stencilBits;
+    float viewQuality;
+    StencilAllocator stencilAllocator;
+    TaskScheduler *scheduler;  // Not owned.
+    double buildSeconds;
+    PortalTransformCache transforms;
+
+    // Reused from frame to frame.
+    std::vector<SceneIndex> sceneIndex;
+    int numScenes;                             // Entries of sceneIndex in use.
+    std::vector<int> viewScene;                // sceneIndex entry of each view.
+    std::vector<int> viewChain;                // transforms chain of each view.
+    std::vector<std::pair<int, int> > demoted;  // (view, object index), by view.
+    std::vector<CullTask> cullTasks;
+    std::vector<int> firstTask;                // Of each view, plus a sentinel.
+
+    void PlanViews(MeshObjList &scene, const glm::mat4 &viewMat,
+            const glm::mat4 &projMat, const ScissorRect &viewport,
+            PortalFramePlan &plan);
+
+    /* Entry of sceneIndex for scene, filled on first use in a frame. */
+    int IndexScene(MeshObjList *scene);
+
+    /* Fills every view's drawList, modelViews and commands. */
+    void BuildDrawLists(PortalFramePlan &plan, const glm::mat4 &projMat,
+            const ScissorRect &viewport);
+    void CullObjects(const PortalFramePlan &plan, CullTask &task,
+            const glm::mat4 &projMat, const ScissorRect &viewport) const;
+    void SortDrawList(PortalFramePlan &plan, int vi);
+
+    /* Whether any of eyes sees the front of a portal, given the eyes in
+     *   the portal's scene and the inverse of its model matrix.
+     */
+    static bool FacesViewer(const glm::mat4 &invModelMat, const glm::vec4 *eyes,
+            int numEyes);
+};
+
+
+/* ------------------------------------------------------------------
+ * PortalViewHook class.
+ *
+ * Lets per-view state (shaders, light clusters, ...) follow the renderer
+ *   as it draws the content of each view.
+ * ------------------------------------------------------------------
+ */
+class PortalViewHook
+{
+  public:
+    virtual ~PortalViewHook() {}
+    virtual void BeginDrawLevel(int level) {}
+    /* viewMat is view.viewMat as seen by the eye being drawn. */
+    virtual void BeginDrawView(const PortalView &view, const glm::mat4 &viewMat) {}
+    virtual void EndDrawLevel(int level) {}
+
+    /* The renderer moves scaled views to an offscreen viewport, and each
+     *   eye to its own; called before BeginDrawLevel() with the projection
+     *   in effect.
+     */
+    virtual void SetProjection(const glm::mat4 &projMat, const ScissorRect &viewport) {}
+};
+
+
+/* ------------------------------------------------------------------
+ * PortalFrameRenderer class.
+ *
+ * Executes a PortalFramePlan with the GL. Expects depth and stencil tests
+ *   enabled, the stencil cleared to the root view's value, and the
+ *   modelview matrix stack current. A multi-view plan is drawn level by
+ *   level, each level once per eye.
+ * ------------------------------------------------------------------
+ */
+class ScaledViewTarget;
+
+class PortalFrameRenderer
+{
+  public:
+    PortalFrameRenderer();
+    ~PortalFrameRenderer();
+
+    void SetHook(PortalViewHook *h) { hook = h; }
+
+    /* Where offscreen targets for scaled views come from; without it,
+     *   every view is drawn at full resolution.
+     */
+    void SetResources(GpuResources *r) { resources = r; }
+
+    /* The frame's projection; needed to draw views below full resolution. */
+    void SetProjection(const glm::mat4 &proj, const ScissorRect &vp)
+        { projMat = proj; viewport = vp; }
+
+    /* Counts samples written by the content passes (fillSamples). Costs
+     *   a wait for the GPU at the end of Render().
+     */
+    void SetCountFill(bool on) { countFill = on; }
+
+    void Render(const PortalFramePlan &plan);
+
+    /* Render() in steps, for callers scheduling each level as a pass of
+     *   their own: BeginRender(), RenderLevel() for every level in order,
+     *   then EndRender(), with the same plan and no GL state changed in
+     *   between.
+     */
+    void BeginRender(const PortalFramePlan &plan);
+    void RenderLevel(const PortalFramePlan &plan, int level);
+    void EndRender(const PortalFramePlan &plan);
+
+    // Counters of the last Render(), for FrameStats.
+    long fillSamples;    // Samples passing depth and stencil in content passes.
+    long nestedPixels;   // Pixels of nested view regions, at the resolution drawn.
+    long savedPixels;    // Pixels not drawn thanks to resolution scaling.
+
+  protected:
+    PortalViewHook *hook;
+    GpuResources *resources;         // Not owned.
+    glm::mat4 projMat;
+    ScissorRect viewport;
+    ScaledViewTarget *scaledTarget;  // Created on first use.
+    bool scaleViews;                 // This frame; false if the GL cannot.
+    std::vector<int> scaledViews;    // Of the level being drawn.
+    GLint depthFunc;                 // As found at the start of Render().
+    int eye;                         // Being drawn; -1 for a single-view plan.
+    GLint prevViewport[4];           // Restored after a multi-view plan.
+
+    bool countFill;
+    std::vector<GLuint> queries;  // One per content pass, reused.
+    int numQueries;               // Used by this frame.
+
+    void ResetLevel(const PortalFramePlan &plan, int level);
+    void DrawLevel(const PortalFramePlan &plan, int level);
+    void DrawScaledViews(const PortalFramePlan &plan, int level);
+    void DrawView(const PortalView &view, int level);
+    void DrawContent(const PortalView &view);
+    void BeginEye(const PortalFramePlan &plan, int e);
+    bool Scaled(const PortalView &view) const
+        { return scaleViews && view.resolutionScale < 1.0f; }
+    void MarkLevel(const PortalFramePlan &plan, int level);
+
+    // View vi as seen by the current eye.
+    const glm::mat4 &ViewMat(const PortalFramePlan &plan, int vi) const
+        { return eye < 0 ? plan.views[vi].viewMat : plan.eyes[eye].viewMats[vi]; }
+    const ScissorRect &Scissor(const PortalFramePlan &plan, int vi) const
+        { return eye < 0 ? plan.views[vi].scissor : plan.eyes[eye].scissors[vi]; }
+
+    void BeginCount();
+    void EndCount();
+
+    static void SetScissor(const ScissorRect &r)
+        { glScissor(r.x, r.y, r.width, r.height); }
+};
+
+
+#endif /* _PORTALPLAN_H */
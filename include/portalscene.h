@@ -0,0 +1,295 @@
+/* =============================================================================
+ * portalscene.h
+ * Masado Ishii
+ * v0.1 2016-12-26
+ * v0.2 2017-08-04 - New scene content.
+ * v0.3 2026-10-19 - Split out of scenemapper.h; no longer depends on VTK.
+ *
+ * Description: Definitions of scene and animations, and the per-frame GL
+ *   setup for drawing them.
+ *
+ * Attributions:
+ *   > Modeled on code by Hank Childs, presumably derivative
+ *     of Kitware coders K.Martin, W.Schroeder, and B.Lorensen.
+ * =============================================================================
+ */
+
+// Note: This file uses the GL api, but nothing from VTK.
+
+#ifndef _PORTALSCENE_H
+#define _PORTALSCENE_H
+
+#include <list>
+#include <utility>
+#include <vector>
+
+#include "mesh.h"        // For populating the scene.
+#include "meshobject.h"  //
+#include "portalplan.h"  // Per-frame portal view planning.
+#include "framestats.h"  // Frame timing.
+#include "clusteredlighting.h"  // Many point lights.
+#include "framecapture.h"       // Recording frames.
+#include "raycast.h"            // Picking.
+#include "softraster.h"         // Drawing without a GL context.
+#include "gpuresources.h"       // GL memory.
+#include "modelcache.h"         // Imported models.
+#include "framegraph.h"         // Passes of a frame.
+#include "camerapath.h"         // Recorded camera paths.
+
+
+/* ------------------------------------------------------------------
+ * PoseSource class.
+ *
+ * Camera input sampled from inside a frame (late latching), so input that
+ *   arrives while the frame loop is busy still makes the frame in progress.
+ * ------------------------------------------------------------------
+ */
+class PoseSource
+{
+  public:
+    virtual ~PoseSource() {}
+
+    /* Takes the input that arrived since the last call. If it moved the
+     *   camera, sets viewMat to the newest pose and inputTime to when the
+     *   oldest of it arrived (mishii_Seconds()), and returns true.
+     */
+    virtual bool LatchPose(glm::mat4 &viewMat, double &inputTime) = 0;
+};
+
+
+/* ------------------------------------------------------------------
+ * PortalScene class.
+ *
+ * Owns the meshes and objects of the scene, and draws it with whatever
+ *   GL context is current. Hosted by the VTK mapper or by a RenderBackend.
+ * ------------------------------------------------------------------
+ */
+class PortalScene
+{
+  protected:
+    GpuResources resources;  // First, so it outlives everything holding GL objects.
+
+    bool   initialized;
+    float  animTime;
+
+    std::list<PolygonMesh *> meshes;
+    std::list<MeshObject *> meshObjects;
+
+    PolygonMesh *squareMesh, *frameMesh, *octahedronMesh, *coneMesh;
+
+    std::string modelPath;                      // Empty for no imported model.
+    std::vector<ModelCache::Object> modelObjects;  // Meshes also in meshes.
+    glm::mat4 modelTransform;                   // Stands the model on the ground.
+
+    MeshObject *animationTarget;
+
+    int  portalPairs;   // 0 for the default scene, else a grid of portal pairs.
+    int  numLights;     // 0 for the fixed-function light, else clustered point lights.
+
+    std::vector<PointLight> lights;
+    ClusteredLighting lighting;
+
+  public:
+    enum SweepMode { SWEEP_NONE, SWEEP_PORTALS, SWEEP_LIGHTS };
+
+  protected:
+    SweepMode sweepMode;  // Grow the portal grid or the light count and time each size.
+    int  sweepFrames;
+    std::vector<std::pair<int, double> > sweepResults;  // (size, mean seconds)
+
+    float eyeSeparation;                // Side-by-side stereo when > 0.
+    std::vector<EyeCamera> eyeCameras;  // Of the last stereo frame.
+
+  public:
+    enum LatchMode { LATCH_NONE, LATCH_FRAME, LATCH_VIEW };
+
+  protected:
+    PoseSource *poseSource;  // Not owned; NULL to take the caller's camera as is.
+    LatchMode latchMode;
+    double inputTime;        // Oldest input not yet presented; < 0 for none.
+
+    FrameStats stats;
+    FrameCapture *capture;  // Not owned; NULL when not recording.
+    CameraPathRecorder *pathRecorder;  // Not owned; NULL when not recording.
+    CameraPathPlayer   *pathPlayer;    // Not owned; NULL when not replaying.
+
+    PortalFramePlanner  framePlanner;
+    PortalFramePlan     framePlan;     // Kept between frames to reuse storage.
+    PortalFrameRenderer frameRenderer;
+    FrameGraph          frameGraph;    // Of the last frame drawn with the GL.
+
+    // Camera of the last frame, for picking.
+    glm::mat4   lastViewMat, lastProjMat;
+    ScissorRect lastViewport;
+    PortalRayCaster rayCaster;
+
+  public:
+    PortalScene() : initialized(false), animTime(0.0), animationTarget(NULL),
+            portalPairs(0), numLights(0), sweepMode(SWEEP_NONE), sweepFrames(0),
+            eyeSeparation(0.0f), poseSource(NULL), latchMode(LATCH_NONE),
+            inputTime(-1.0), capture(NULL), pathRecorder(NULL), pathPlayer(NULL)
+    {
+        lighting.SetResources(&resources);
+        frameRenderer.SetResources(&resources);
+    }
+   ~PortalScene();
+
+    /* Stress scene: a grid of n linked portal pairs instead of the default two portals. */
+    void SetPortalPairs(int n) { portalPairs = n; }
+
+    /* Imports the OBJ model at path (see modelcache.h) on the first frame,
+     *   and stands it on the ground beside the cone, 4 units tall or wide,
+     *   turned from +Y up to +Z up. Prints a "model:" line with the load
+     *   time; a model that cannot be read is left out.
+     */
+    void SetModel(const std::string &path) { modelPath = path; }
+
+    /* n point lights over the ground, shaded with clustered lighting. */
+    void SetNumLights(int n) { numLights = n; }
+
+    /* SWEEP_PORTALS times the portal grid at 4, 8, ..., 256 portals;
+     *   SWEEP_LIGHTS times 64, 256, ..., 16384 lights. Prints a summary.
+     */
+    void SetSweep(SweepMode m) { sweepMode = m; }
+
+    /* Resolution of nested portal views, in (0, 1]; see portalplan.h. */
+    void SetViewQuality(float q) { framePlanner.SetViewQuality(q); }
+
+    /* Where the frame planner builds draw lists; see portalplan.h. */
+    void SetScheduler(TaskScheduler *s) { framePlanner.SetScheduler(s); }
+
+    /* Draws the left and right eye side by side, each in half of the
+     *   viewport, with eyes separation apart; 0 turns stereo off. Both
+     *   eyes share one portal plan (see PlanMultiView()). The software
+     *   path draws a single view.
+     */
+    void SetStereo(float separation) { eyeSeparation = separation; }
+
+    /* Late latching. LATCH_FRAME replaces the camera passed to a frame by
+     *   source's newest pose, just before the frame's view matrix is
+     *   loaded. LATCH_VIEW also latches once the portal views are planned,
+     *   and moves the plan to the new pose (PortalFramePlanner::Reproject())
+     *   rather than planning again; portals coming into sight then appear
+     *   a frame late. Stereo frames and plans sharing stencil values skip
+     *   the second latch. LATCH_NONE, or a NULL source, turns it off.
+     */
+    void SetPoseSource(PoseSource *source, LatchMode mode)
+        { poseSource = source; latchMode = mode; }
+
+    /* Input that moved the camera arrived at time (mishii_Seconds()), to
+     *   be shown by the next frame drawn. For hosts without a PoseSource.
+     */
+    void NoteInput(double time);
+
+    /* Call once the last frame drawn is on screen: samples the input to
+     *   present latency ("input_ms") of any input it showed and, given
+     *   when the camera input was last read (poseTime), the age of the pose
+     *   it showed ("pose_ms").
+     */
+    void FramePresented(double poseTime = -1.0);
+
+    /* Keys the scene handles itself: '[' and ']' lower and raise the
+     *   view quality. Others are ignored.
+     */
+    void HandleKey(char key);
+
+    FrameStats &GetStats() { return stats; }
+
+    /* The portal views planned for the last frame. */
+    const PortalFramePlan &GetFramePlan() const { return framePlan; }
+
+    /* Reads back every frame drawn into c. */
+    void SetCapture(FrameCapture *c)
+    {
+        capture = c;
+        if (c != NULL)
+            c->SetResources(&resources);
+    }
+    FrameCapture *GetCapture() { return capture; }
+
+    /* The camera path the frame loop records to or replays from; see
+     *   camerapath.h. Keys handled are noted in the recording.
+     */
+    void SetPathRecorder(CameraPathRecorder *r) { pathRecorder = r; }
+    CameraPathRecorder *GetPathRecorder() { return pathRecorder; }
+    void SetPathPlayer(CameraPathPlayer *p) { pathPlayer = p; }
+    CameraPathPlayer *GetPathPlayer() { return pathPlayer; }
+
+    /* Passes the frames still being read back to the capture. Call while
+     *   the GL context is still current, before it is destroyed.
+     */
+    void FlushCapture() { if (capture != NULL) capture->Flush(); }
+
+    /* Bytes of GL memory to keep to, evicting display lists and offscreen
+     *   targets not drawn lately; 0 for no limit. See gpuresources.h.
+     */
+    void SetGpuBudget(size_t bytes) { resources.SetBudget(bytes); }
+
+    /* Times each pass of the frames drawn with the GL, waiting for the
+     *   GPU after each; DumpFrameGraph() prints the passes of the last
+     *   frame with their mean times.
+     */
+    void SetFrameGraphTiming(bool on)
+        { frameGraph.SetTiming(on, on ? FrameGraph::PassFn(glFinish) : FrameGraph::PassFn()); }
+    void DumpFrameGraph(std::ostream &out) const { frameGraph.Dump(out); }
+
+    /* Frees the scene's GL objects. Call while the context is still
+     *   current, after FlushCapture(); otherwise they die with it.
+     */
+    void ReleaseGpuResources() { resources.Release(); }
+
+  protected:
+    // Sweep steps: portal pairs double, lights quadruple.
+    static const int SWEEP_FIRST_PAIRS = 2;
+    static const int SWEEP_LAST_PAIRS = 128;
+    static const int SWEEP_FIRST_LIGHTS = 64;
+    static const int SWEEP_LAST_LIGHTS = 16384;
+    static const int SWEEP_STEP_FRAMES = 200;
+
+    void InitializeScene();
+    void ClearScene();
+    void BuildScene();
+    void LoadModel();
+    void AddPortalPair(const glm::mat4 &transform1, const glm::mat4 &transform2);
+    void AddPortalGrid(int numPairs);
+    void BuildLights();
+    void AdvanceSweep();
+
+    void SetupLight(void);
+    void ClearFrame(const glm::mat4 &viewMat, const glm::mat4 &projMat,
+            const ScissorRect &viewport);
+    bool LatchPose(glm::mat4 &viewMat);
+    void PrepareFrame();
+    void FinishFrame();
+    void BuildEyeCameras(const glm::mat4 &viewMat, const glm::mat4 &projMat,
+            const ScissorRect &viewport);
+    const char *ObjectName(const MeshObject *obj) const;
+
+  public:
+    /* Draws one frame from the camera viewMat. Loads the matrices and
+     *   viewport into the GL and clears the framebuffer first.
+     */
+    void RenderFrame(const glm::mat4 &viewMat, const glm::mat4 &projMat,
+            const ScissorRect &viewport);
+
+    /* As RenderFrame(), but rasterized on the CPU into fb, with the
+     *   fixed-function light only. Needs no GL context.
+     */
+    void RenderFrameSoftware(const glm::mat4 &viewMat, const glm::mat4 &projMat,
+            const ScissorRect &viewport, SoftRasterizer &raster, SoftFramebuffer &fb);
+    void AdvanceAnimation();
+    float AnimationTime() const { return animTime; }
+
+    /* Casts a ray through window pixel (x, y) of the last frame, across
+     *   portals, and prints what it hits. Returns false on a miss. In
+     *   stereo, the ray is cast from the eye whose half holds the pixel.
+     */
+    bool Pick(int x, int y, std::ostream &out);
+
+    /* Prints ray casting throughput for the scene as configured (default:
+     *   128 portal pairs), from the default camera. Needs no GL context.
+     */
+    void BenchmarkRays(std::ostream &out);
+};
+
+#endif /* _PORTALSCENE_H */
@@ -0,0 +1,154 @@
+/* =============================================================================
+ * raycast.h
+ * Masado Ishii
+ * v0.3 2026-10-19
+ *
+ * Description: Ray casting through the scene and across portal links, for
+ *   picking, teleport targeting and other queries on what a ray hits.
+ *
+ *   Each scene gets a bounding volume hierarchy over its triangles in world
+ *   space. A ray that enters a portal from its front (+Z) side continues
+ *   from the destination portal, transformed by the inverse of the
+ *   portal's LinkMatrix() (the renderer's aboutFace transform), up to a
+ *   hop limit. Back faces are not hit, as they are culled when rendering.
+ *
+ * Attributions:
+ *   > Ray-triangle test after T. Moller and B. Trumbore, "Fast, Minimum
+ *     Storage Ray/Triangle Intersection", 1997.
+ * =============================================================================
+ */
+
+#ifndef _RAYCAST_H
+#define _RAYCAST_H
+
+#include <map>
+#include <ostream>
+#include <vector>
+
+#include "meshobject.h"
+#include "parallel.h"
+#include "portalplan.h"  // ScissorRect.
+#include "utility.h"
+
+
+/* ------------------------------------------------------------------
+ * Ray, RayHit structs.
+ * ------------------------------------------------------------------
+ */
+struct Ray
+{
+    glm::vec3 origin;
+    glm::vec3 direction;  // Need not be normalized.
+
+    Ray() {}
+    Ray(const glm::vec3 &o, const glm::vec3 &d) : origin(o), direction(d) {}
+};
+
+struct RayHit
+{
+    const MeshObject *object;  // NULL if the ray hit nothing.
+    int triangle;              // Index into the object's PolygonMesh.
+    const MeshObjList *scene;  // Scene the hit is in.
+    glm::vec3 position;        // World space of that scene.
+    glm::vec3 normal;          // Unit front-face normal, same space.
+    float distance;            // Length of the path, summed over its segments.
+    int hops;                  // Portals passed through.
+    bool hopLimited;           // object is a portal the ray could not enter.
+
+    // Maps root scene coordinates to the hit scene's: the product of the
+    //   inverse link matrices along the path.
+    glm::mat4 pathMat;
+
+    RayHit() : object(NULL), triangle(-1), scene(NULL), distance(0.0f), hops(0),
+            hopLimited(false) {}
+};
+
+
+/* ------------------------------------------------------------------
+ * PortalRayCaster class.
+ *
+ * Build() snapshots the scene; cast queries are then read-only and safe
+ *   to run from several threads. Build again after objects move.
+ * ------------------------------------------------------------------
+ */
+class PortalRayCaster
+{
+  public:
+    static const int DEFAULT_MAX_HOPS = 8;
+
+    PortalRayCaster() {}
+    ~PortalRayCaster();
+
+    /* Indexes root and every scene reachable from it through portals.
+     *   Objects without a PolygonMesh are not hit.
+     */
+    void Build(const MeshObjList &root);
+    void Clear();
+
+    int NumTriangles() const;
+
+    /* Nearest hit along ray from the root scene. Returns hit.object != NULL. */
+    bool Cast(const Ray &ray, RayHit &hit, int maxHops = DEFAULT_MAX_HOPS) const;
+
+    /* Casts rays split across pool's threads. */
+    void CastBatch(const std::vector<Ray> &rays, std::vector<RayHit> &hits,
+            WorkerPool &pool, int maxHops = DEFAULT_MAX_HOPS) const;
+
+    /* Ray from the near plane through the center of window pixel (x, y). */
+    static Ray PickRay(int x, int y, const glm::mat4 &viewMat,
+            const glm::mat4 &projMat, const ScissorRect &viewport);
+
+    /* Prints build time and rays per second at 1, 2, 4, ... threads, for
+     *   one primary ray per pixel of a width x height view of root.
+     */
+    static void Benchmark(std::ostream &out, const MeshObjList &root,
+            const glm::mat4 &viewMat, const glm::mat4 &projMat,
+            int width, int height);
+
+  protected:
+    struct Triangle
+    {
+        glm::vec3 v0, e1, e2;  // World space; front faces wind v0, v0+e1, v0+e2.
+        int object;            // Index into SceneIndex::objects.
+        int index;             // Triangle in the object's mesh.
+    };
+
+    struct Node
+    {
+        glm::vec3 bmin, bmax;
+        int first;   // Leaf: first triangle. Inner: left child (right is first+1).
+        int count;   // Triangles in a leaf; 0 for an inner node.
+    };
+
+    struct ObjectEntry
+    {
+        const MeshObject *object;
+        const PortalObject *portal;  // Non-NULL if the ray may pass through.
+        glm::mat4 hopMat;            // inverse(portal->LinkMatrix()).
+        int destScene;               // Index of destPortal's scene.
+    };
+
+    struct SceneIndex
+    {
+        const MeshObjList *scene;
+        std::vector<ObjectEntry> objects;
+        std::vector<Triangle> triangles;
+        std::vector<Node> nodes;
+    };
+
+    static const int LEAF_SIZE = 4;
+
+    std::vector<SceneIndex *> scenes;  // Root first.
+
+    int SceneFor(const MeshObjList *scene, std::map<const MeshObjList *, int> &known);
+    void BuildNodes(SceneIndex &index);
+
+    /* Nearest triangle along origin + t*dir with t in (0, tMax), ignoring
+     *   triangles of skip. Returns its index or -1.
+     */
+    int Intersect(const SceneIndex &index, const glm::vec3 &origin, const glm::vec3 &dir,
+            const MeshObject *skip, float &tMax) const;
+};
+
+
+#endif /* _RAYCAST_H */
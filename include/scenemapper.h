@@ -3,9 +3,9 @@
  * Masado Ishii
  * v0.1 2016-12-26
  * v0.2 2017-08-04 - New scene content.
+ * v0.3 2026-10-19 - Scene moved to portalscene.h.
  *
- * Description: Initialization of the GL environment; definitions of scene 
- *   and animations.
+ * Description: Hook of the portal scene into the VTK pipeline.
  *
  * Attributions:
  *   > Modeled on code by Hank Childs, presumably derivative
@@ -18,8 +18,7 @@
 
 #include "vtkOpenGLPolyDataMapper.h"  // Inherit mapper from this.
 
-#include "mesh.h"        // For populating the scene.
-#include "meshobject.h"  //
+#include "portalscene.h"  // The scene drawn by vtk441MapperMishii.
 
 
 /* ------------------------------------------------------------------
@@ -41,7 +40,6 @@ class vtk441Mapper : public vtkOpenGLPolyDataMapper
    virtual void AdvanceAnimation();
 
    void RemoveVTKOpenGLStateSideEffects();
-   void SetupLight(void);
 };
 
 
@@ -53,24 +51,15 @@ class vtk441Mapper : public vtkOpenGLPolyDataMapper
 class vtk441MapperMishii : public vtk441Mapper
 {
   protected:
-    GLuint shapes; // Display lists.
-    bool   initialized;
-
-    std::list<DisplayListMesh *> meshes;
-    std::list<MeshObject *> meshObjects;
-
-    MeshObject *animationTarget;
+    PortalScene *scene;  // Not owned.
 
   public:
     static vtk441MapperMishii *New();
 
-    vtk441MapperMishii() : initialized(false), animationTarget(NULL) {}
-   ~vtk441MapperMishii();
+    vtk441MapperMishii() : scene(NULL) {}
 
-  protected:
-    void InitializeScene();
+    void SetScene(PortalScene *s) { scene = s; }
 
-  public:
     virtual void RenderPiece(vtkRenderer *ren, vtkActor *act);
     virtual void AdvanceAnimation();
 };
@@ -0,0 +1,135 @@
+/* =============================================================================
+ * softraster.h
+ * Masado Ishii
+ * v0.3 2026-10-19
+ *
+ * Description: Tile-based, multithreaded CPU rasterizer that executes a
+ *   PortalFramePlan without a GL context, for hosts without a GPU.
+ *
+ *   The frame's passes (ResetLevel, DrawLevel and MarkLevel, as in
+ *   PortalFrameRenderer) are recorded as a list of set-up triangles, each
+ *   with its stencil, depth and color state. The triangles are binned to
+ *   screen tiles in submission order, and the tiles are then rasterized in
+ *   parallel. Within a tile every triangle is processed in order, so the
+ *   stencil and depth results match the GL's sequential semantics.
+ *
+ *   Edge functions and depth are evaluated four pixels at a time with SSE2
+ *   where available. Shading follows the scene's fixed-function setup: one
+ *   directional light, color material, default normal (0, 0, 1).
+ *
+ * Attributions:
+ *   > Edge functions after J. Pineda, "A Parallel Algorithm for Polygon
+ *     Rasterization", SIGGRAPH 1988.
+ * =============================================================================
+ */
+
+#ifndef _SOFTRASTER_H
+#define _SOFTRASTER_H
+
+#include <vector>
+
+#include "portalplan.h"
+#include "parallel.h"
+#include "utility.h"
+
+
+/* ------------------------------------------------------------------
+ * SoftFramebuffer class.
+ *
+ * Color (RGBA8), depth (float, [0,1]) and 8-bit stencil. Rows are stored
+ *   bottom-up, as glReadPixels() returns them.
+ * ------------------------------------------------------------------
+ */
+class SoftFramebuffer
+{
+  public:
+    int width, height;
+    std::vector<unsigned int>  color;  // Bytes R, G, B, A in memory order.
+    std::vector<float>         depth;
+    std::vector<unsigned char> stencil;
+
+    SoftFramebuffer() : width(0), height(0) {}
+
+    void Resize(int w, int h);
+    void Clear(const glm::vec4 &clearColor, float clearDepth, unsigned char clearStencil);
+
+    const unsigned char *Pixels() const
+        { return (const unsigned char *) &color[0]; }
+};
+
+
+/* ------------------------------------------------------------------
+ * SoftLight struct.
+ *
+ * The fixed-function light, already summed: color = material *
+ *   (ambient + diffuse * max(0, n . direction)), n in eye space and not
+ *   normalized (GL_NORMALIZE is off).
+ * ------------------------------------------------------------------
+ */
+struct SoftLight
+{
+    glm::vec3 direction;  // Eye space, unit length, toward the light.
+    float ambient;        // Global plus light ambient.
+    float diffuse;
+};
+
+
+/* ------------------------------------------------------------------
+ * SoftRasterizer class.
+ * ------------------------------------------------------------------
+ */
+class SoftRasterizer
+{
+  public:
+    static const int TILE_SIZE = 64;
+
+    explicit SoftRasterizer(WorkerPool &pool = WorkerPool::Shared());
+
+    void SetLight(const SoftLight &l) { light = l; }
+
+    /* Draws plan into fb, which should already be cleared: stencil to the
+     *   root view's value, depth to 1. Uses GL_LESS as the depth test.
+     */
+    void Render(const PortalFramePlan &plan, const glm::mat4 &projMat,
+            const ScissorRect &viewport, SoftFramebuffer &fb);
+
+    // Counters of the last Render(), for FrameStats.
+    int    numTriangles;   // Set up, after clipping and culling.
+    long   numBinned;      // Triangle references over all tiles.
+    double setupSeconds, rasterSeconds;
+
+  protected:
+    enum Mode { MODE_RESET, MODE_DRAW, MODE_MARK };
+
+    struct Triangle
+    {
+        float edgeA[3], edgeB[3], edgeC[3];  // Edge i: A*x + B*y + C >= 0 inside.
+        bool  edgeTopLeft[3];                // Whether pixels exactly on edge i are in.
+        float zA, zB, zC;                    // Window depth plane.
+        float rgbA[3], rgbB[3], rgbC[3];     // Color planes, 0..255.
+        int   x0, y0, x1, y1;                // Pixel bounds [x0, x1) x [y0, y1), scissored.
+        unsigned char mode, ref, writeMask;
+    };
+
+    WorkerPool &pool;
+    SoftLight light;
+
+    glm::mat4 projMat;
+    ScissorRect viewport;
+    ScissorRect bounds;  // viewport within the framebuffer.
+
+    std::vector<Triangle> triangles;
+    std::vector<glm::vec4> clipVerts;   // Scratch for Submit(): per mesh vertex.
+    std::vector<glm::vec3> litColors;   //
+    int tilesX, tilesY;
+    std::vector<std::vector<int> > bins;  // Per tile, indices into triangles.
+
+    void Submit(const MeshObject &obj, const glm::mat4 &viewMat, Mode mode,
+            GLint ref, GLint writeMask, const ScissorRect &scissor);
+    void SetupTriangle(const glm::vec4 clip[3], const glm::vec3 color[3],
+            Mode mode, GLint ref, GLint writeMask, const ScissorRect &scissor);
+    void RasterTile(int tile, SoftFramebuffer &fb) const;
+};
+
+
+#endif /* _SOFTRASTER_H */
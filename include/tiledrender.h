@@ -0,0 +1,137 @@
+/* =============================================================================
+ * tiledrender.h
+ * Masado Ishii
+ * v0.3 2026-10-19
+ *
+ * Description: Sort-first rendering across processes on one machine. Each
+ *   render process draws a horizontal strip of the frame from the same
+ *   camera, with a projection cropped to its strip, so portal culling and
+ *   scissors are limited to it. Strips are written into shared memory; a
+ *   Unix socket per process carries the frame commands and the replies.
+ *   The compositor (the parent process) shows the assembled frame with its
+ *   own backend, and moves strip boundaries toward equal render times.
+ *
+ * Attributions:
+ * =============================================================================
+ */
+
+#ifndef _TILEDRENDER_H
+#define _TILEDRENDER_H
+
+#include <string>
+#include <vector>
+
+#include <sys/types.h>
+
+#include "backend.h"
+
+
+/* ------------------------------------------------------------------
+ * TileBalancer class.
+ *
+ * Splits the rows of a frame into strips, one per render process, and
+ *   moves the boundaries so that each strip's cost matches. A strip's cost
+ *   is assumed spread evenly over its rows.
+ * ------------------------------------------------------------------
+ */
+class TileBalancer
+{
+  public:
+    // Strips never get fewer rows than this.
+    static const int MIN_ROWS = 8;
+
+    TileBalancer() : height(0) {}
+
+    /* Equal strips of height rows. */
+    void Reset(int height, int numTiles);
+
+    int NumTiles() const { return (int) bounds.size() - 1; }
+    int Begin(int t) const { return bounds[t]; }
+    int Rows(int t) const { return bounds[t+1] - bounds[t]; }
+
+    /* Moves boundaries halfway toward equal cost, given each strip's
+     *   time for the last frame.
+     */
+    void Update(const std::vector<double> &seconds);
+
+  protected:
+    int height;
+    std::vector<int> bounds;  // Row boundaries, NumTiles() + 1 of them.
+};
+
+
+/* ------------------------------------------------------------------
+ * TiledRenderBackend class.
+ *
+ * Wraps the backend that shows frames. Open() forks the render processes
+ *   before the display backend creates its context; each opens its own
+ *   headless backend and a copy of the scene, and never returns.
+ *   Picks and scene keys are not passed on to the render processes.
+ * ------------------------------------------------------------------
+ */
+class TiledRenderBackend : public RenderBackend
+{
+  public:
+    /* Takes ownership of display. Render processes use the backend named
+     *   workerBackend.
+     */
+    TiledRenderBackend(RenderBackend *display, PortalScene &scene,
+            const std::string &workerBackend, int numProcs);
+    virtual ~TiledRenderBackend();
+
+    virtual const char *Name() const { return display->Name(); }
+    virtual bool Headless() const { return display->Headless(); }
+    virtual bool Open(int width, int height);
+    virtual void Close();
+    virtual int Width() const { return width; }
+    virtual int Height() const { return height; }
+    virtual bool PollEvents(Camera &camera) { return !failed && display->PollEvents(camera); }
+    virtual bool TakeCameraInput(double &time) { return display->TakeCameraInput(time); }
+    virtual void DrawFrame(PortalScene &scene, const Camera &camera);
+    virtual void Present() { display->Present(); }
+
+    /* Headless backend for the render processes when showing on display:
+     *   display itself if headless, else egl, osmesa or soft as built in.
+     */
+    static const char *WorkerBackend(const std::string &display);
+
+  protected:
+    // Fixed-size messages over the sockets.
+    struct Command
+    {
+        int frame;  // -1 asks the process to exit.
+        int width, height;
+        int tileY, tileRows;
+        float viewMat[16], projMat[16];
+    };
+    struct Reply
+    {
+        int frame;
+        double seconds;  // Drawing and reading back the strip.
+    };
+
+    RenderBackend *display;
+    PortalScene *scene;
+    std::string workerBackend;
+    int numProcs;
+
+    int width, height;
+    unsigned char *pixels;  // Shared frame, RGBA bottom-up.
+    size_t pixelBytes;
+    std::vector<int> sockets;
+    std::vector<pid_t> children;
+
+    TileBalancer balancer;
+    std::vector<double> tileSeconds;
+    int frame;
+    bool failed;  // A render process went away; the frame loop stops.
+
+    void RunWorker(int socket);
+    void StopWorkers();
+
+    static bool WriteAll(int fd, const void *data, size_t n);
+    static bool ReadAll(int fd, void *data, size_t n);
+};
+
+
+#endif /* _TILEDRENDER_H */
@@ -42,4 +42,25 @@ namespace glm_mishii_matrix_transforms
 void mishii_PrintMatrix(std::ostream &out, const float *mat, int num_rows, int num_cols);
 
 
+/* ------------------------------------------------------------------
+ * Utility routine: mishii_Seconds().
+ *
+ * Monotonic wall clock in seconds, for timing frames and passes.
+ * ------------------------------------------------------------------
+ */
+double mishii_Seconds();
+
+
+/* ------------------------------------------------------------------
+ * Utility routines: mishii_ProcessAge(), mishii_ResidentKB().
+ *
+ * Read from /proc (Linux). ProcessAge() is the time since exec, at clock
+ *   tick resolution (usually 10 ms). ResidentKB() is the current resident
+ *   set, or its high-water mark if peak. Both return -1 if unavailable.
+ * ------------------------------------------------------------------
+ */
+double mishii_ProcessAge();
+long mishii_ResidentKB(bool peak = false);
+
+
 #endif /* _UTILITY_H */
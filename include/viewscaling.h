@@ -0,0 +1,120 @@
+/* =============================================================================
+ * viewscaling.h
+ * Masado Ishii
+ * v0.3 2026-10-19
+ *
+ * Description: Offscreen target for portal views drawn at reduced
+ *   resolution. The views of one recursion level are packed into a single
+ *   framebuffer object (an atlas), drawn there, then upsampled into their
+ *   portal silhouettes together with their depth, so the passes that
+ *   follow see the same depth they would at full resolution. The composite
+ *   writes every pixel of the silhouette, so it also takes the place of
+ *   the view's reset pass.
+ *
+ * Attributions:
+ * =============================================================================
+ */
+
+// Note: This file uses the GL api, but nothing from VTK.
+
+#ifndef _VIEWSCALING_H
+#define _VIEWSCALING_H
+
+#include <vector>
+
+#include <GL/gl.h>
+
+#include "portalplan.h"  // ScissorRect.
+#include "gpuresources.h"
+#include "utility.h"
+
+
+/* ------------------------------------------------------------------
+ * ScaledViewTarget class.
+ *
+ * Usage, once per batch of views:
+ *   BeginBatch(), AddSlot() per view, then Bind(); BeginSlot() and draw per
+ *   view; Unbind(); then per view BeginComposite() and draw its portal
+ *   under its stencil test; EndComposite().
+ *   Switching framebuffers twice per batch rather than per view matters
+ *   on tiled and software GL, which flush at each switch.
+ *
+ * The atlas grows to the largest batch so far and is reused. It is
+ *   evictable: once evicted, the next Bind() allocates it again.
+ * ------------------------------------------------------------------
+ */
+class ScaledViewTarget : public GpuResources::Owner
+{
+  public:
+    explicit ScaledViewTarget(GpuResources &resources);
+    ~ScaledViewTarget();
+
+    /* Starts a batch drawn with projMat into viewport (window coordinates). */
+    void BeginBatch(const glm::mat4 &projMat, const ScissorRect &viewport);
+
+    /* Reserves a slot of rect's size times scale; returns its index. */
+    int AddSlot(const ScissorRect &rect, float scale);
+
+    /* Whether the GL has what the target needs (framebuffer objects and
+     *   shaders). The first call needs a current context.
+     */
+    bool Available();
+
+    /* Redirects drawing to the atlas and clears it to black and far depth.
+     *   The stencil test is off until Unbind(). Returns false, changing
+     *   nothing, if the target is not Available().
+     */
+    bool Bind();
+
+    /* Sets the viewport, scissor and projection to draw slot's view, and
+     *   returns them for hooks that need them.
+     */
+    void BeginSlot(int slot, glm::mat4 &subProj, ScissorRect &subViewport);
+
+    /* Returns to the framebuffer, viewport and projection from before Bind(). */
+    void Unbind();
+
+    /* Until EndComposite(), geometry drawn with the window's projection
+     *   takes its color and depth from slot, upsampled to the slot's rect.
+     */
+    void BeginComposite(int slot);
+    void EndComposite();
+
+    /* Sub-projection showing the part rect of viewport in a full frame. */
+    static glm::mat4 SubProjection(const glm::mat4 &projMat,
+            const ScissorRect &viewport, const ScissorRect &rect);
+
+    virtual void Evict(GpuResources &resources);
+
+  protected:
+    struct Slot
+    {
+        ScissorRect rect;   // Window region of the view.
+        ScissorRect atlas;  // Where it is drawn in the atlas.
+    };
+
+    GpuResources &resources;
+    bool initialized, usable;
+    GpuResources::Handle framebuffer;  // -1 while evicted.
+    GpuResources::Handle colorTexture, depthTexture;
+    int capacityW, capacityH;  // Allocated texture size.
+    GLuint program;
+    GLint  uSlotMap;
+
+    // Current batch. Slots are packed on shelves across the viewport width.
+    glm::mat4 projMat;
+    ScissorRect viewport;
+    std::vector<Slot> slots;
+    int shelfX, shelfY, shelfH;
+    int usedW, usedH;
+
+    GLint prevFramebuffer;
+    GLint prevViewport[4];
+
+    bool Initialize();
+    bool CreateAtlas();
+    void Reserve(int w, int h);
+};
+
+
+#endif /* _VIEWSCALING_H */
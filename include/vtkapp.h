@@ -0,0 +1,23 @@
+/* =============================================================================
+ * vtkapp.h
+ * Masado Ishii
+ * v0.3 2026-10-19
+ *
+ * Description: The VTK backend. Hosts the portal scene in a VTK render
+ *   window through vtk441MapperMishii and runs VTK's event loop.
+ *
+ * Attributions:
+ *   > Modified from Hank Childs's pipeline harness.
+ * =============================================================================
+ */
+
+#ifndef _VTKAPP_H
+#define _VTKAPP_H
+
+struct AppOptions;
+class PortalScene;
+
+/* Returns an exit status. */
+int RunVTKApp(PortalScene &scene, const AppOptions &opts);
+
+#endif /* _VTKAPP_H */
@@ -0,0 +1,272 @@
+/* =============================================================================
+ * appoptions.cxx
+ * Masado Ishii
+ * v0.3 2026-10-19
+ *
+ * Description: Command line options shared by all backends.
+ *
+ * Attributions:
+ * =============================================================================
+ */
+
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include "../include/appoptions.h"
+#include "../include/backend.h"  // DefaultRenderBackend()
+
+
+namespace
+{
+
+// Parses value as a whole decimal N >= 0, unlike atoi(), which reads
+//   "-5" as -5 and "abc" as 0.
+bool ParseCount(const char *value, int &n)
+{
+    char *end;
+    errno = 0;
+    long parsed = strtol(value, &end, 10);
+    if (end == value || *end != '\0' || errno != 0 || parsed < 0 || parsed > INT_MAX)
+        return false;
+    n = (int) parsed;
+    return true;
+}
+
+}  // namespace
+
+
+/* --------------------------------------------------------------------
+ * AppOptions member functions.
+ * --------------------------------------------------------------------
+ */
+
+AppOptions::AppOptions()
+        : backend(DefaultRenderBackend()), width(1200), height(600), frames(0),
+          stats(false), benchLights(false), benchRays(false), portalPairs(0), numLights(0),
+          viewQuality(1.0f), eyeSeparation(0.0f), renderProcs(0),
+          latch(PortalScene::LATCH_FRAME), inputRate(0.0), gpuBudgetMB(0.0), sweep(PortalScene::SWEEP_NONE), captureDrop(false), frameGraph(false),
+          startTime(0.0)
+{
+}
+
+
+/* --------------------------------------------------------------------
+ * ParseAppOptions()
+ *
+ *   --backend NAME   vtk, glx, egl or osmesa, as built in, or soft.
+ *   --size WxH       Framebuffer size, default 1200x600.
+ *   --frames N       Exit after N frames; 0, the default, runs until closed.
+ *   --stats          Print frame times and portal counters every 100 frames.
+ *   --portals N      Stress scene with N portals (N/2 linked pairs) on a grid;
+ *                    N must be even.
+ *   --portal-sweep   Time the stress scene from 4 to 256 portals (implies --stats).
+ *   --lights N       N clustered point lights instead of the fixed-function light.
+ *   --light-sweep    Time 64 to 16384 clustered lights (implies --stats).
+ *   --view-quality Q Draw views at portal depth d at Q^d of full resolution.
+ *   --stereo SEP     Side-by-side stereo, eyes SEP scene units apart.
+ *   --procs N        Render in N strips, each in its own process.
+ *   --latch MODE     Sample camera input at the top of the frame loop only
+ *                    (none), also just before drawing (frame, the default),
+ *                    or also after planning portal views (view).
+ *   --input-rate HZ  Turn the camera in HZ timed steps per second, as an
+ *                    input device would, to measure input latency.
+ *   --gpu-budget MB  Keep the scene's GL memory under MB megabytes, evicting
+ *                    what was not drawn lately.
+ *   --model PATH     Add the OBJ model at PATH to the scene, cached in
+ *                    PATH.fvc after the first run.
+ *   --bench-lights   Time CPU light binning for 64 to 16384 lights, then exit.
+ *   --bench-rays     Time ray casting through the portal grid, then exit.
+ *   --capture PATH   Record frames: a .y4m video, or PNGs named by PATH (see
+ *                    FrameCapture::Open()).
+ *   --capture-drop   Drop frames when the writer falls behind, instead of waiting.
+ *   --frame-graph    Time each pass of the frame; print the passes on exit.
+ *   --record PATH    Record the camera, animation clock and scene keys of
+ *                    every frame to PATH (see camerapath.h).
+ *   --replay PATH    Draw the frames recorded in PATH, one per frame, and
+ *                    print their time distribution.
+ * --------------------------------------------------------------------
+ */
+bool ParseAppOptions(int argc, char *argv[], AppOptions &opts)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        bool hasValue = (i+1 < argc);
+        if (strcmp(argv[i], "--backend") == 0 && hasValue)
+            opts.backend = argv[++i];
+        else if (strcmp(argv[i], "--size") == 0 && hasValue)
+        {
+            const char *value = argv[++i];
+            const char *x = strchr(value, 'x');
+            opts.width = atoi(value);
+            opts.height = (x != NULL ? atoi(x + 1) : 0);
+            if (opts.width <= 0 || opts.height <= 0)
+            {
+                std::cerr << "Bad --size '" << value << "', expected WxH." << std::endl;
+                return false;
+            }
+        }
+        else if (strcmp(argv[i], "--frames") == 0 && hasValue)
+        {
+            const char *value = argv[++i];
+            if (!ParseCount(value, opts.frames))
+            {
+                std::cerr << "Bad --frames '" << value << "', expected N >= 0." << std::endl;
+                return false;
+            }
+        }
+        else if (strcmp(argv[i], "--stats") == 0)
+            opts.stats = true;
+        else if (strcmp(argv[i], "--portals") == 0 && hasValue)
+        {
+            // Portals come in linked pairs.
+            const char *value = argv[++i];
+            int numPortals = atoi(value);
+            if (numPortals <= 0 || numPortals % 2 != 0)
+            {
+                std::cerr << "Bad --portals '" << value << "', expected an even N > 0." << std::endl;
+                return false;
+            }
+            opts.portalPairs = numPortals / 2;
+        }
+        else if (strcmp(argv[i], "--portal-sweep") == 0)
+        {
+            opts.sweep = PortalScene::SWEEP_PORTALS;
+            opts.stats = true;
+        }
+        else if (strcmp(argv[i], "--lights") == 0 && hasValue)
+        {
+            const char *value = argv[++i];
+            if (!ParseCount(value, opts.numLights))
+            {
+                std::cerr << "Bad --lights '" << value << "', expected N >= 0." << std::endl;
+                return false;
+            }
+        }
+        else if (strcmp(argv[i], "--light-sweep") == 0)
+        {
+            opts.sweep = PortalScene::SWEEP_LIGHTS;
+            opts.stats = true;
+        }
+        else if (strcmp(argv[i], "--view-quality") == 0 && hasValue)
+        {
+            const char *value = argv[++i];
+            opts.viewQuality = (float) atof(value);
+            if (!(opts.viewQuality > 0.0f && opts.viewQuality <= 1.0f))
+            {
+                std::cerr << "Bad --view-quality '" << value << "', expected (0, 1]." << std::endl;
+                return false;
+            }
+        }
+        else if (strcmp(argv[i], "--stereo") == 0 && hasValue)
+        {
+            const char *value = argv[++i];
+            opts.eyeSeparation = (float) atof(value);
+            if (!(opts.eyeSeparation > 0.0f))
+            {
+                std::cerr << "Bad --stereo '" << value << "', expected a separation > 0." << std::endl;
+                return false;
+            }
+        }
+        else if (strcmp(argv[i], "--procs") == 0 && hasValue)
+        {
+            const char *value = argv[++i];
+            opts.renderProcs = atoi(value);
+            if (opts.renderProcs <= 0)
+            {
+                std::cerr << "Bad --procs '" << value << "', expected N > 0." << std::endl;
+                return false;
+            }
+        }
+        else if (strcmp(argv[i], "--latch") == 0 && hasValue)
+        {
+            const char *value = argv[++i];
+            if (strcmp(value, "none") == 0)
+                opts.latch = PortalScene::LATCH_NONE;
+            else if (strcmp(value, "frame") == 0)
+                opts.latch = PortalScene::LATCH_FRAME;
+            else if (strcmp(value, "view") == 0)
+                opts.latch = PortalScene::LATCH_VIEW;
+            else
+            {
+                std::cerr << "Bad --latch '" << value << "', expected none, frame or view." << std::endl;
+                return false;
+            }
+        }
+        else if (strcmp(argv[i], "--input-rate") == 0 && hasValue)
+        {
+            const char *value = argv[++i];
+            opts.inputRate = atof(value);
+            if (!(opts.inputRate > 0.0))
+            {
+                std::cerr << "Bad --input-rate '" << value << "', expected HZ > 0." << std::endl;
+                return false;
+            }
+        }
+        else if (strcmp(argv[i], "--gpu-budget") == 0 && hasValue)
+        {
+            const char *value = argv[++i];
+            opts.gpuBudgetMB = atof(value);
+            if (!(opts.gpuBudgetMB > 0.0))
+            {
+                std::cerr << "Bad --gpu-budget '" << value << "', expected MB > 0." << std::endl;
+                return false;
+            }
+        }
+        else if (strcmp(argv[i], "--model") == 0 && hasValue)
+            opts.modelPath = argv[++i];
+        else if (strcmp(argv[i], "--bench-lights") == 0)
+            opts.benchLights = true;
+        else if (strcmp(argv[i], "--bench-rays") == 0)
+            opts.benchRays = true;
+        else if (strcmp(argv[i], "--capture") == 0 && hasValue)
+            opts.capturePath = argv[++i];
+        else if (strcmp(argv[i], "--capture-drop") == 0)
+            opts.captureDrop = true;
+        else if (strcmp(argv[i], "--frame-graph") == 0)
+            opts.frameGraph = true;
+        else if (strcmp(argv[i], "--record") == 0 && hasValue)
+            opts.recordPath = argv[++i];
+        else if (strcmp(argv[i], "--replay") == 0 && hasValue)
+            opts.replayPath = argv[++i];
+        else
+        {
+            std::cerr << "Usage: " << argv[0]
+                      << " [--backend NAME] [--size WxH] [--frames N] [--stats]"
+                      << " [--portals N] [--portal-sweep]"
+                      << " [--lights N] [--light-sweep] [--view-quality Q]"
+                      << " [--stereo SEP] [--procs N] [--latch MODE] [--input-rate HZ]"
+                      << " [--gpu-budget MB] [--model PATH]"
+                      << " [--bench-lights] [--bench-rays]"
+                      << " [--capture PATH] [--capture-drop] [--frame-graph]"
+                      << " [--record PATH | --replay PATH]" << std::endl
+                      << "Backends built in:" << AvailableRenderBackends() << std::endl;
+            return false;
+        }
+    }
+    if (!opts.recordPath.empty() && !opts.replayPath.empty())
+    {
+        std::cerr << "Give --record or --replay, not both." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/* --------------------------------------------------------------------
+ * ApplyAppOptions()
+ * --------------------------------------------------------------------
+ */
+void ApplyAppOptions(const AppOptions &opts, PortalScene &scene)
+{
+    scene.SetPortalPairs(opts.portalPairs);
+    scene.SetNumLights(opts.numLights);
+    scene.SetViewQuality(opts.viewQuality);
+    scene.SetStereo(opts.eyeSeparation);
+    scene.SetGpuBudget((size_t) (opts.gpuBudgetMB * 1024.0 * 1024.0));
+    scene.SetModel(opts.modelPath);
+    scene.SetFrameGraphTiming(opts.frameGraph);
+    scene.SetSweep(opts.sweep);
+    scene.GetStats().SetEnabled(opts.stats);
+}
@@ -15,12 +15,13 @@
 #include "vtkRenderWindowInteractor.h"
 
 #include "../include/asynchronous.h"
+#include "../include/backend.h"  // ReportStartup()
 
 /* --------------------------------------------------------------------
  * KeypressCallbackFunction
  * --------------------------------------------------------------------
  */
-void KeypressCallbackFunction ( vtkObject* caller, long unsigned int vtkNotUsed(eventId), void* vtkNotUsed(clientData), void* vtkNotUsed(callData) )
+void KeypressCallbackFunction ( vtkObject* caller, long unsigned int vtkNotUsed(eventId), void* clientData, void* vtkNotUsed(callData) )
 {
   std::cout << "Keypress callback" << std::endl;
  
@@ -29,6 +30,16 @@ void KeypressCallbackFunction ( vtkObject* caller, long unsigned int vtkNotUsed(
  
   std::cout << "Pressed: " << iren->GetKeySym() << std::endl;
 
+  // 'p': pick through the portals at the mouse position.
+  PortalScene *scene = static_cast<PortalScene *>(clientData);
+  if (scene != NULL && iren->GetKeyCode() == 'p')
+  {
+    int *pos = iren->GetEventPosition();
+    scene->Pick(pos[0], pos[1], std::cout);
+  }
+  else if (scene != NULL && scene->GetPathPlayer() == NULL)  // A replay has its own keys.
+    scene->HandleKey(iren->GetKeyCode());  // '[', ']': view quality.
+
     /* Disabled because doesn't work... */
     /* Test: Show the camera transform matrices access. */
     //float current_modelview[16];
@@ -46,6 +57,27 @@ void KeypressCallbackFunction ( vtkObject* caller, long unsigned int vtkNotUsed(
 }
 
 
+/* --------------------------------------------------------------------
+ * CameraModifiedCallbackFunction, RenderEndCallbackFunction
+ * --------------------------------------------------------------------
+ */
+void CameraModifiedCallbackFunction ( vtkObject* vtkNotUsed(caller), long unsigned int vtkNotUsed(eventId), void* clientData, void* vtkNotUsed(callData) )
+{
+    // VTK handles events on this thread, as they are read: now is about
+    //   when the input that moved the camera arrived.
+    PortalScene *scene = static_cast<PortalScene *>(clientData);
+    if (scene != NULL)
+        scene->NoteInput(mishii_Seconds());
+}
+
+void RenderEndCallbackFunction ( vtkObject* vtkNotUsed(caller), long unsigned int vtkNotUsed(eventId), void* clientData, void* vtkNotUsed(callData) )
+{
+    PortalScene *scene = static_cast<PortalScene *>(clientData);
+    if (scene != NULL)
+        scene->FramePresented();
+}
+
+
 /* --------------------------------------------------------------------
  * vtkTimerCallback member functions.
  * --------------------------------------------------------------------
@@ -61,7 +93,10 @@ vtkTimerCallback *vtkTimerCallback::New()
   cb->mapper = NULL;
   cb->renWin = NULL;
   cb->cam    = NULL;
+  cb->scene  = NULL;
   cb->angle  = 0;
+  cb->startTime = 0.0;
+  cb->maxFrames = 0;
   return cb;
 }
 
@@ -80,6 +115,26 @@ void vtkTimerCallback::Execute(vtkObject *vtkNotUsed(caller),
         ++this->TimerCount;
         }
 
+    CameraPathRecorder *recorder = (scene != NULL ? scene->GetPathRecorder() : NULL);
+    CameraPathPlayer *player = (scene != NULL ? scene->GetPathPlayer() : NULL);
+    if (player != NULL && player->Done())
+    {
+        if (renWin != NULL)
+            renWin->GetInteractor()->TerminateApp();
+        return;
+    }
+
+    double frameStart = mishii_Seconds();
+    if (player != NULL && cam != NULL)
+    {
+        const CameraPathFrame &step = player->NextFrame();
+        for (size_t k = 0; k < step.keys.size(); k++)
+            scene->HandleKey(step.keys[k]);
+        cam->SetPosition(step.position.x, step.position.y, step.position.z);
+        cam->SetFocalPoint(step.focalPoint.x, step.focalPoint.y, step.focalPoint.z);
+        cam->SetViewUp(step.viewUp.x, step.viewUp.y, step.viewUp.z);
+    }
+
     // Make a call to the mapper to make it alter how it renders...
     if (mapper != NULL)
         mapper->AdvanceAnimation();
@@ -87,5 +142,21 @@ void vtkTimerCallback::Execute(vtkObject *vtkNotUsed(caller),
     // Force a render...
     if (renWin != NULL)
         renWin->Render();
+
+    if (player != NULL)
+        player->EndFrame(mishii_Seconds() - frameStart, scene->AnimationTime());
+    if (recorder != NULL && cam != NULL)
+    {
+        double *p = cam->GetPosition();
+        double *f = cam->GetFocalPoint();
+        double *u = cam->GetViewUp();
+        recorder->RecordFrame(glm::vec3(p[0], p[1], p[2]), glm::vec3(f[0], f[1], f[2]),
+                glm::vec3(u[0], u[1], u[2]), scene->AnimationTime());
+    }
+
+    if (TimerCount == 1)
+        ReportStartup("vtk", startTime);
+    if (maxFrames > 0 && TimerCount >= maxFrames && renWin != NULL)
+        renWin->GetInteractor()->TerminateApp();
 }
 
@@ -0,0 +1,391 @@
+/* =============================================================================
+ * backend.cxx
+ * Masado Ishii
+ * v0.3 2026-10-19
+ *
+ * Description: Backend selection and the frame loop shared by the backends
+ *   that run without VTK.
+ *
+ * Attributions:
+ * =============================================================================
+ */
+
+#ifndef GL_GLEXT_PROTOTYPES
+#define GL_GLEXT_PROTOTYPES  // glWindowPos2i(); must precede the first gl.h.
+#endif
+#include <GL/gl.h>
+#include <GL/glext.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+#include "../include/backend.h"
+#include "../include/appoptions.h"
+#include "../include/portalscene.h"
+
+// Backends are compiled in as found by CMake (FV_HAVE_*).
+#ifdef FV_HAVE_GLX
+RenderBackend *CreateGLXBackend();
+#endif
+#ifdef FV_HAVE_EGL
+RenderBackend *CreateEGLBackend();
+#endif
+#ifdef FV_HAVE_OSMESA
+RenderBackend *CreateOSMesaBackend();
+#endif
+RenderBackend *CreateSoftBackend();  // Always built in.
+
+
+/* --------------------------------------------------------------------
+ * Backend selection.
+ * --------------------------------------------------------------------
+ */
+
+RenderBackend *CreateRenderBackend(const std::string &name)
+{
+#ifdef FV_HAVE_GLX
+    if (name == "glx")
+        return CreateGLXBackend();
+#endif
+#ifdef FV_HAVE_EGL
+    if (name == "egl")
+        return CreateEGLBackend();
+#endif
+#ifdef FV_HAVE_OSMESA
+    if (name == "osmesa")
+        return CreateOSMesaBackend();
+#endif
+    if (name == "soft")
+        return CreateSoftBackend();
+    return NULL;
+}
+
+const char *DefaultRenderBackend()
+{
+#if defined(FV_HAVE_VTK)
+    return "vtk";
+#elif defined(FV_HAVE_GLX)
+    return "glx";
+#elif defined(FV_HAVE_EGL)
+    return "egl";
+#elif defined(FV_HAVE_OSMESA)
+    return "osmesa";
+#else
+    return "soft";
+#endif
+}
+
+const char *AvailableRenderBackends()
+{
+    return ""
+#ifdef FV_HAVE_VTK
+        " vtk"
+#endif
+#ifdef FV_HAVE_GLX
+        " glx"
+#endif
+#ifdef FV_HAVE_EGL
+        " egl"
+#endif
+#ifdef FV_HAVE_OSMESA
+        " osmesa"
+#endif
+        " soft";
+}
+
+
+/* --------------------------------------------------------------------
+ * RenderBackend member functions.
+ * --------------------------------------------------------------------
+ */
+
+void RenderBackend::DrawFrame(PortalScene &scene, const Camera &camera)
+{
+    int w = Width(), h = Height();
+    DrawView(scene, camera.ViewMatrix(), camera.ProjectionMatrix((float) w / h),
+            ScissorRect(0, 0, w, h));
+}
+
+void RenderBackend::DrawView(PortalScene &scene, const glm::mat4 &viewMat,
+        const glm::mat4 &projMat, const ScissorRect &viewport)
+{
+    scene.RenderFrame(viewMat, projMat, viewport);
+}
+
+void RenderBackend::ReadPixels(const ScissorRect &rect, unsigned char *rgba,
+        int rowPixels)
+{
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glPixelStorei(GL_PACK_ROW_LENGTH, rowPixels);
+    glReadPixels(rect.x, rect.y, rect.width, rect.height, GL_RGBA, GL_UNSIGNED_BYTE, rgba);
+    glPixelStorei(GL_PACK_ROW_LENGTH, 0);
+}
+
+void RenderBackend::ShowPixels(int width, int height, const unsigned char *rgba)
+{
+    glViewport(0, 0, width, height);
+    glDisable(GL_SCISSOR_TEST);
+    glDisable(GL_STENCIL_TEST);
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_BLEND);
+    glWindowPos2i(0, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glDrawPixels(width, height, GL_RGBA, GL_UNSIGNED_BYTE, rgba);
+}
+
+
+/* --------------------------------------------------------------------
+ * Frame loop input.
+ * --------------------------------------------------------------------
+ */
+
+namespace
+{
+    /* A thread turning the camera in small steps at a fixed rate, as an
+     *   input device would, each step stamped with when it was made. It
+     *   sweeps back and forth, keeping the scene in sight. Headless
+     *   backends have no other input to time.
+     */
+    class SyntheticInput
+    {
+      public:
+        static const float STEP_DEGREES;
+        static const int SWEEP_STEPS = 40;  // Steps each way.
+
+        explicit SyntheticInput(double rate)
+            : period(1.0 / rate), stop(false), steps(0), turn(0), oldest(0.0)
+        {
+            thread = std::thread(&SyntheticInput::Run, this);
+        }
+
+        ~SyntheticInput()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stop = true;
+            }
+            wake.notify_one();
+            thread.join();
+        }
+
+        /* Applies the steps made since the last call to camera, and
+         *   returns when the first of them was made.
+         */
+        bool Take(Camera &camera, double &time)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (steps == 0)
+                return false;
+            camera.Azimuth(STEP_DEGREES * turn);
+            time = oldest;
+            steps = turn = 0;
+            return true;
+        }
+
+      protected:
+        double period;
+        std::thread thread;
+        std::mutex mutex;
+        std::condition_variable wake;
+        bool stop;
+        int steps;      // Made and not taken,
+        int turn;       //   and their sum, counting steps back as -1.
+        double oldest;  // mishii_Seconds() of the first of them.
+
+        void Run()
+        {
+            std::chrono::steady_clock::time_point next = std::chrono::steady_clock::now();
+            std::unique_lock<std::mutex> lock(mutex);
+            for (int made = 0; !stop; made++)
+            {
+                next += std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                        std::chrono::duration<double>(period));
+                if (wake.wait_until(lock, next, [this] { return stop; }))
+                    break;
+                if (steps++ == 0)
+                    oldest = mishii_Seconds();
+                turn += (made / SWEEP_STEPS) % 2 == 0 ? 1 : -1;
+            }
+        }
+    };
+
+    const float SyntheticInput::STEP_DEGREES = 0.25f;
+
+    /* The camera input of the frame loop: window events and synthetic
+     *   steps, read at the top of each frame and, when the scene latches,
+     *   again from inside it. A replayed path steers the camera instead;
+     *   window events are still read, for quitting.
+     */
+    class LoopInput : public PoseSource
+    {
+      public:
+        std::unique_ptr<SyntheticInput> synthetic;  // NULL for none.
+        bool quit;      // The user asked to quit, maybe in the middle of a frame.
+        double polled;  // mishii_Seconds() of the last Poll().
+        bool replaying;
+
+        LoopInput(RenderBackend &b, Camera &c)
+            : quit(false), polled(0.0), replaying(false), backend(b), camera(c) {}
+
+        /* Handles pending input; returns when the oldest input that moved
+         *   the camera arrived, if any did.
+         */
+        bool Poll(double &inputTime)
+        {
+            polled = mishii_Seconds();
+            if (replaying)
+            {
+                Camera ignored(camera);
+                if (!backend.PollEvents(ignored))
+                    quit = true;
+                backend.TakeCameraInput(inputTime);
+                return false;
+            }
+            if (!backend.PollEvents(camera))
+                quit = true;
+            bool moved = backend.TakeCameraInput(inputTime);
+            double time;
+            if (synthetic && synthetic->Take(camera, time))
+            {
+                inputTime = moved ? std::min(inputTime, time) : time;
+                moved = true;
+            }
+            return moved;
+        }
+
+        virtual bool LatchPose(glm::mat4 &viewMat, double &inputTime)
+        {
+            if (!Poll(inputTime))
+                return false;
+            viewMat = camera.ViewMatrix();
+            return true;
+        }
+
+      protected:
+        RenderBackend &backend;
+        Camera &camera;
+    };
+}
+
+
+/* --------------------------------------------------------------------
+ * RunRenderBackend()
+ * --------------------------------------------------------------------
+ */
+int RunRenderBackend(RenderBackend &backend, PortalScene &scene,
+        const AppOptions &opts)
+{
+    // Windowed backends keep the pace of the VTK harness's 10 ms timer;
+    //   headless ones render as fast as they can.
+    const double TICK = 0.010;
+
+    if (!backend.Open(opts.width, opts.height))
+        return EXIT_FAILURE;
+
+    // Render processes, forked by Open(), get no pose source: input is
+    //   only read here.
+    Camera camera;
+    LoopInput input(backend, camera);
+    scene.SetPoseSource(&input, opts.latch);
+    double nextTick = mishii_Seconds();
+
+    // A replay draws one frame per recorded frame, however long they take.
+    CameraPathRecorder *recorder = scene.GetPathRecorder();
+    CameraPathPlayer *player = scene.GetPathPlayer();
+    input.replaying = (player != NULL);
+
+    for (int frame = 0; opts.frames == 0 || frame < opts.frames; frame++)
+    {
+        if (player != NULL && player->Done())
+            break;
+        double inputTime;
+        if (input.Poll(inputTime))
+            scene.NoteInput(inputTime);
+        if (input.quit)
+            break;
+
+        double frameStart = mishii_Seconds();
+        if (player != NULL)
+        {
+            const CameraPathFrame &step = player->NextFrame();
+            for (size_t k = 0; k < step.keys.size(); k++)
+                scene.HandleKey(step.keys[k]);
+            step.ApplyTo(camera);
+        }
+        scene.AdvanceAnimation();
+        backend.DrawFrame(scene, camera);
+        backend.Present();
+        scene.FramePresented(input.polled);
+
+        // The camera as drawn: latching may have moved it since the top.
+        if (player != NULL)
+            player->EndFrame(mishii_Seconds() - frameStart, scene.AnimationTime());
+        if (recorder != NULL)
+            recorder->RecordFrame(camera.position, camera.focalPoint, camera.viewUp,
+                    scene.AnimationTime());
+
+        if (frame == 0)
+        {
+            ReportStartup(backend.Name(), opts.startTime);
+            if (opts.inputRate > 0.0 && player == NULL)  // Not timing the startup.
+                input.synthetic.reset(new SyntheticInput(opts.inputRate));
+        }
+
+        int pickX, pickY;
+        while (backend.TakePick(pickX, pickY))
+            scene.Pick(pickX, pickY, std::cout);
+        // A replay takes its keys from the path, as it does the camera.
+        char key;
+        while (backend.TakeKey(key))
+            if (player == NULL)
+                scene.HandleKey(key);
+
+        if (!backend.Headless())
+        {
+            nextTick += TICK;
+            double wait = nextTick - mishii_Seconds();
+            if (wait > 0.0)
+                std::this_thread::sleep_for(std::chrono::duration<double>(wait));
+            else
+                nextTick = mishii_Seconds();
+        }
+    }
+
+    scene.SetPoseSource(NULL, PortalScene::LATCH_NONE);
+    if (player != NULL)
+        player->Report(std::cout);
+    if (opts.frameGraph)
+        scene.DumpFrameGraph(std::cout);
+    scene.FlushCapture();
+    scene.ReleaseGpuResources();
+    backend.Close();
+    return EXIT_SUCCESS;
+}
+
+
+/* --------------------------------------------------------------------
+ * ReportStartup()
+ * --------------------------------------------------------------------
+ */
+void ReportStartup(const char *backendName, double mainStartTime)
+{
+    double age = mishii_ProcessAge();
+
+    // Formatted apart, so that std::cout keeps its own settings.
+    std::ostringstream line;
+    line << std::fixed << std::setprecision(1)
+         << "startup: backend=" << backendName
+         << " first_frame_ms=" << 1e3 * (mishii_Seconds() - mainStartTime)
+         << " since_exec_ms=" << (age >= 0.0 ? 1e3 * age : -1.0)
+         << " rss_kb=" << mishii_ResidentKB()
+         << " peak_rss_kb=" << mishii_ResidentKB(true);
+    std::cout << line.str() << std::endl;
+}
@@ -0,0 +1,148 @@
+/* =============================================================================
+ * backend_egl.cxx
+ * Masado Ishii
+ * v0.3 2026-10-19
+ *
+ * Description: Headless backend on an EGL context without a surface. The
+ *   frame goes to a framebuffer object with depth and stencil.
+ *
+ * Attributions:
+ * =============================================================================
+ */
+
+#ifndef GL_GLEXT_PROTOTYPES
+#define GL_GLEXT_PROTOTYPES  // GL 3.0 framebuffer objects.
+#endif
+#include <GL/gl.h>
+#include <GL/glext.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <iostream>
+
+#include "../include/backend.h"
+
+
+/* ------------------------------------------------------------------
+ * EGLBackend class.
+ * ------------------------------------------------------------------
+ */
+class EGLBackend : public RenderBackend
+{
+  protected:
+    EGLDisplay display;
+    EGLContext context;
+    GLuint framebuffer, renderbuffers[2];  // Color, depth-stencil.
+    int width, height;
+
+  public:
+    EGLBackend() : display(EGL_NO_DISPLAY), context(EGL_NO_CONTEXT),
+            framebuffer(0), width(0), height(0)
+        { renderbuffers[0] = renderbuffers[1] = 0; }
+    virtual ~EGLBackend() { Close(); }
+
+    virtual const char *Name() const { return "egl"; }
+    virtual bool Headless() const { return true; }
+    virtual int Width() const { return width; }
+    virtual int Height() const { return height; }
+
+    virtual bool Open(int w, int h);
+    virtual void Close();
+    virtual void Present() { glFinish(); }
+};
+
+RenderBackend *CreateEGLBackend()
+{
+    return new EGLBackend;
+}
+
+
+/* --------------------------------------------------------------------
+ * EGLBackend member functions.
+ * --------------------------------------------------------------------
+ */
+
+bool EGLBackend::Open(int w, int h)
+{
+    width = w;
+    height = h;
+
+    // Prefer the surfaceless platform: no X server and no device node needed.
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+        (PFNEGLGETPLATFORMDISPLAYEXTPROC) eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (getPlatformDisplay != NULL)
+        display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+    if (display == EGL_NO_DISPLAY)
+        display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+    EGLint major, minor;
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor))
+    {
+        std::cerr << "EGLBackend: no EGL display." << std::endl;
+        return false;
+    }
+
+    // Desktop GL with the fixed-function pipeline (compatibility profile).
+    const EGLint configAttribs[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_NONE
+    };
+    EGLConfig config;
+    EGLint numConfigs = 0;
+    if (!eglBindAPI(EGL_OPENGL_API)
+            || !eglChooseConfig(display, configAttribs, &config, 1, &numConfigs)
+            || numConfigs == 0)
+    {
+        std::cerr << "EGLBackend: no desktop OpenGL config." << std::endl;
+        return false;
+    }
+
+    context = eglCreateContext(display, config, EGL_NO_CONTEXT, NULL);
+    if (context == EGL_NO_CONTEXT
+            || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context))
+    {
+        std::cerr << "EGLBackend: cannot make a surfaceless context current"
+                  << " (EGL_KHR_surfaceless_context)." << std::endl;
+        return false;
+    }
+
+    // The stand-in for a window: color plus packed depth-stencil.
+    glGenFramebuffers(1, &framebuffer);
+    glGenRenderbuffers(2, renderbuffers);
+    glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[0]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[1]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+            GL_RENDERBUFFER, renderbuffers[0]);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT,
+            GL_RENDERBUFFER, renderbuffers[1]);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+        std::cerr << "EGLBackend: incomplete framebuffer." << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+void EGLBackend::Close()
+{
+    if (context != EGL_NO_CONTEXT)
+    {
+        glDeleteFramebuffers(1, &framebuffer);
+        glDeleteRenderbuffers(2, renderbuffers);
+        eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        eglDestroyContext(display, context);
+        context = EGL_NO_CONTEXT;
+    }
+    if (display != EGL_NO_DISPLAY)
+    {
+        eglTerminate(display);
+        display = EGL_NO_DISPLAY;
+    }
+}
@@ -0,0 +1,234 @@
+/* =============================================================================
+ * backend_glx.cxx
+ * Masado Ishii
+ * v0.3 2026-10-19
+ *
+ * Description: Plain X11 window with a GLX context.
+ *
+ *   Keys: arrows orbit the camera, w/s dolly in and out, q or Escape quits,
+ *   [ and ] lower and raise the resolution of views through portals.
+ *   Left click picks (prints what is under the cursor, through portals).
+ *
+ * Attributions:
+ * =============================================================================
+ */
+
+#include <X11/Xlib.h>
+#include <X11/keysym.h>
+#include <GL/glx.h>
+
+#include <deque>
+#include <iostream>
+
+#include <stdint.h>
+
+#include "../include/backend.h"
+
+
+/* ------------------------------------------------------------------
+ * GLXBackend class.
+ * ------------------------------------------------------------------
+ */
+class GLXBackend : public RenderBackend
+{
+  protected:
+    Display *display;
+    Window window;
+    Colormap colormap;
+    GLXContext context;
+    Atom deleteWindow;
+    int width, height;
+    std::deque<std::pair<int, int> > picks;
+    std::deque<char> keys;  // For the scene.
+    double cameraInputTime; // Oldest camera key not taken; < 0 for none.
+
+    void NoteCameraInput(Time serverTime);
+
+  public:
+    GLXBackend() : display(NULL), window(0), colormap(0), context(NULL),
+            deleteWindow(0), width(0), height(0), cameraInputTime(-1.0) {}
+    virtual ~GLXBackend() { Close(); }
+
+    virtual const char *Name() const { return "glx"; }
+    virtual bool Headless() const { return false; }
+    virtual int Width() const { return width; }
+    virtual int Height() const { return height; }
+
+    virtual bool Open(int w, int h);
+    virtual void Close();
+    virtual bool PollEvents(Camera &camera);
+    virtual bool TakePick(int &x, int &y);
+    virtual bool TakeKey(char &key);
+    virtual bool TakeCameraInput(double &time);
+    virtual void Present() { glXSwapBuffers(display, window); }
+};
+
+RenderBackend *CreateGLXBackend()
+{
+    return new GLXBackend;
+}
+
+
+/* --------------------------------------------------------------------
+ * GLXBackend member functions.
+ * --------------------------------------------------------------------
+ */
+
+bool GLXBackend::Open(int w, int h)
+{
+    width = w;
+    height = h;
+
+    display = XOpenDisplay(NULL);
+    if (display == NULL)
+    {
+        std::cerr << "GLXBackend: cannot open the X display." << std::endl;
+        return false;
+    }
+
+    int attribs[] = {
+        GLX_RGBA, GLX_DOUBLEBUFFER,
+        GLX_DEPTH_SIZE, 24,
+        GLX_STENCIL_SIZE, 8,   // Important for proper portals.
+        None
+    };
+    int screen = DefaultScreen(display);
+    XVisualInfo *visual = glXChooseVisual(display, screen, attribs);
+    if (visual == NULL)
+    {
+        std::cerr << "GLXBackend: no visual with depth and stencil." << std::endl;
+        return false;
+    }
+
+    Window root = RootWindow(display, screen);
+    colormap = XCreateColormap(display, root, visual->visual, AllocNone);
+    XSetWindowAttributes wa;
+    wa.colormap = colormap;
+    wa.event_mask = KeyPressMask | ButtonPressMask | StructureNotifyMask;
+    window = XCreateWindow(display, root, 0, 0, width, height, 0, visual->depth,
+            InputOutput, visual->visual, CWColormap | CWEventMask, &wa);
+    XStoreName(display, window, "FunnelVision");
+    deleteWindow = XInternAtom(display, "WM_DELETE_WINDOW", False);
+    XSetWMProtocols(display, window, &deleteWindow, 1);
+    XMapWindow(display, window);
+
+    context = glXCreateContext(display, visual, NULL, True);
+    XFree(visual);
+    if (context == NULL || !glXMakeCurrent(display, window, context))
+    {
+        std::cerr << "GLXBackend: cannot create a GL context." << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+void GLXBackend::Close()
+{
+    if (display == NULL)
+        return;
+    if (context != NULL)
+    {
+        glXMakeCurrent(display, None, NULL);
+        glXDestroyContext(display, context);
+        context = NULL;
+    }
+    if (window != 0)
+        XDestroyWindow(display, window);
+    if (colormap != 0)
+        XFreeColormap(display, colormap);
+    XCloseDisplay(display);
+    display = NULL;
+    window = 0;
+    colormap = 0;
+}
+
+bool GLXBackend::PollEvents(Camera &camera)
+{
+    while (XPending(display) > 0)
+    {
+        XEvent event;
+        XNextEvent(display, &event);
+        switch (event.type)
+        {
+          case ConfigureNotify:
+            width = event.xconfigure.width;
+            height = event.xconfigure.height;
+            break;
+          case ButtonPress:
+            if (event.xbutton.button == Button1)
+                picks.push_back(std::make_pair(event.xbutton.x,
+                            height - 1 - event.xbutton.y));
+            break;
+          case ClientMessage:
+            if ((Atom) event.xclient.data.l[0] == deleteWindow)
+                return false;
+            break;
+          case KeyPress:
+          {
+            bool moved = true;
+            switch (XLookupKeysym(&event.xkey, 0))
+            {
+              case XK_Escape:
+              case XK_q:     return false;
+              case XK_Left:  camera.Azimuth(-2.0f);   break;
+              case XK_Right: camera.Azimuth(2.0f);    break;
+              case XK_Up:    camera.Elevation(2.0f);  break;
+              case XK_Down:  camera.Elevation(-2.0f); break;
+              case XK_w:     camera.Dolly(1.05f);     break;
+              case XK_s:     camera.Dolly(1.0f / 1.05f); break;
+              case XK_bracketleft:  keys.push_back('['); moved = false; break;
+              case XK_bracketright: keys.push_back(']'); moved = false; break;
+              default:       moved = false;
+            }
+            if (moved)
+                NoteCameraInput(event.xkey.time);
+            break;
+          }
+        }
+    }
+    return true;
+}
+
+/*
+ * NoteCameraInput() - Keeps the arrival time of the oldest camera key not
+ *   yet taken. X servers on Linux stamp events in milliseconds of
+ *   CLOCK_MONOTONIC, the clock of mishii_Seconds(), cut to 32 bits; a stamp
+ *   that does not fit that clock is replaced by the time it was read.
+ */
+void GLXBackend::NoteCameraInput(Time serverTime)
+{
+    double now = mishii_Seconds();
+    uint32_t age = (uint32_t) (uint64_t) (1e3 * now) - (uint32_t) serverTime;
+    double time = (age < 10000) ? now - 1e-3 * age : now;
+    if (cameraInputTime < 0.0 || time < cameraInputTime)
+        cameraInputTime = time;
+}
+
+bool GLXBackend::TakeCameraInput(double &time)
+{
+    if (cameraInputTime < 0.0)
+        return false;
+    time = cameraInputTime;
+    cameraInputTime = -1.0;
+    return true;
+}
+
+bool GLXBackend::TakeKey(char &key)
+{
+    if (keys.empty())
+        return false;
+    key = keys.front();
+    keys.pop_front();
+    return true;
+}
+
+bool GLXBackend::TakePick(int &x, int &y)
+{
+    if (picks.empty())
+        return false;
+    x = picks.front().first;
+    y = picks.front().second;
+    picks.pop_front();
+    return true;
+}
@@ -0,0 +1,88 @@
+/* =============================================================================
+ * backend_osmesa.cxx
+ * Masado Ishii
+ * v0.3 2026-10-19
+ *
+ * Description: Headless backend on Mesa's off-screen renderer. OSMesa
+ *   exports its own GL entry points, so this backend is built into a
+ *   separate executable (funnelvision-osmesa) linked without libGL.
+ *
+ * Attributions:
+ * =============================================================================
+ */
+
+#include <GL/osmesa.h>
+
+#include <iostream>
+#include <vector>
+
+#include "../include/backend.h"
+
+
+/* ------------------------------------------------------------------
+ * OSMesaBackend class.
+ * ------------------------------------------------------------------
+ */
+class OSMesaBackend : public RenderBackend
+{
+  protected:
+    OSMesaContext context;
+    std::vector<unsigned char> buffer;  // RGBA, rows bottom-up.
+    int width, height;
+
+  public:
+    OSMesaBackend() : context(NULL), width(0), height(0) {}
+    virtual ~OSMesaBackend() { Close(); }
+
+    virtual const char *Name() const { return "osmesa"; }
+    virtual bool Headless() const { return true; }
+    virtual int Width() const { return width; }
+    virtual int Height() const { return height; }
+
+    virtual bool Open(int w, int h);
+    virtual void Close();
+    virtual void Present() { glFinish(); }
+};
+
+RenderBackend *CreateOSMesaBackend()
+{
+    return new OSMesaBackend;
+}
+
+
+/* --------------------------------------------------------------------
+ * OSMesaBackend member functions.
+ * --------------------------------------------------------------------
+ */
+
+bool OSMesaBackend::Open(int w, int h)
+{
+    width = w;
+    height = h;
+
+    context = OSMesaCreateContextExt(OSMESA_RGBA, 24, 8, 0, NULL);
+    if (context == NULL)
+    {
+        std::cerr << "OSMesaBackend: cannot create a context." << std::endl;
+        return false;
+    }
+
+    buffer.resize(4 * width * height);
+    if (!OSMesaMakeCurrent(context, &buffer[0], GL_UNSIGNED_BYTE, width, height))
+    {
+        std::cerr << "OSMesaBackend: cannot make the context current." << std::endl;
+        return false;
+    }
+    OSMesaPixelStore(OSMESA_Y_UP, 1);
+
+    return true;
+}
+
+void OSMesaBackend::Close()
+{
+    if (context != NULL)
+    {
+        OSMesaDestroyContext(context);
+        context = NULL;
+    }
+}
@@ -0,0 +1,75 @@
+/* =============================================================================
+ * backend_soft.cxx
+ * Masado Ishii
+ * v0.3 2026-10-19
+ *
+ * Description: Headless backend on the CPU rasterizer (softraster.h), for
+ *   hosts without a GPU. Frames stay in memory; record them with --capture.
+ *
+ * Attributions:
+ * =============================================================================
+ */
+
+#include <cstring>
+
+#include "../include/backend.h"
+#include "../include/portalscene.h"
+#include "../include/softraster.h"
+
+
+/* ------------------------------------------------------------------
+ * SoftBackend class.
+ * ------------------------------------------------------------------
+ */
+class SoftBackend : public RenderBackend
+{
+  protected:
+    SoftRasterizer raster;
+    SoftFramebuffer framebuffer;
+
+  public:
+    virtual const char *Name() const { return "soft"; }
+    virtual bool Headless() const { return true; }
+    virtual int Width() const { return framebuffer.width; }
+    virtual int Height() const { return framebuffer.height; }
+
+    virtual bool Open(int w, int h) { framebuffer.Resize(w, h); return true; }
+    virtual void Close() {}
+    virtual void DrawView(PortalScene &scene, const glm::mat4 &viewMat,
+            const glm::mat4 &projMat, const ScissorRect &viewport);
+    virtual void ReadPixels(const ScissorRect &rect, unsigned char *rgba, int rowPixels);
+    virtual void ShowPixels(int width, int height, const unsigned char *rgba);
+    virtual void Present() {}
+};
+
+RenderBackend *CreateSoftBackend()
+{
+    return new SoftBackend;
+}
+
+
+/* --------------------------------------------------------------------
+ * SoftBackend member functions.
+ * --------------------------------------------------------------------
+ */
+
+void SoftBackend::DrawView(PortalScene &scene, const glm::mat4 &viewMat,
+        const glm::mat4 &projMat, const ScissorRect &viewport)
+{
+    scene.RenderFrameSoftware(viewMat, projMat, viewport, raster, framebuffer);
+}
+
+void SoftBackend::ReadPixels(const ScissorRect &rect, unsigned char *rgba, int rowPixels)
+{
+    const unsigned char *pixels = framebuffer.Pixels();
+    for (int y = 0; y < rect.height; y++)
+        memcpy(rgba + 4 * (size_t) y * rowPixels,
+                pixels + 4 * ((size_t) (rect.y + y) * framebuffer.width + rect.x),
+                4 * (size_t) rect.width);
+}
+
+void SoftBackend::ShowPixels(int width, int height, const unsigned char *rgba)
+{
+    framebuffer.Resize(width, height);
+    memcpy(&framebuffer.color[0], rgba, 4 * (size_t) width * height);
+}
@@ -0,0 +1,58 @@
+/* =============================================================================
+ * camera.cxx
+ * Masado Ishii
+ * v0.3 2026-10-19
+ *
+ * Description: A look-at camera for the backends that run without VTK.
+ *
+ * Attributions:
+ *   > Azimuth/Elevation/Dolly follow the behavior of vtkCamera.
+ * =============================================================================
+ */
+
+#include "../include/camera.h"
+
+
+/* --------------------------------------------------------------------
+ * Camera member functions.
+ * --------------------------------------------------------------------
+ */
+
+Camera::Camera()
+        : position(0.0f, 0.0f, 70.0f), focalPoint(0.0f, 0.0f, 0.0f),
+          viewUp(0.0f, 1.0f, 0.0f), viewAngle(30.0f),
+          clipNear(20.0f), clipFar(120.0f)
+{
+}
+
+glm::mat4 Camera::ViewMatrix() const
+{
+    return glm::lookAt(position, focalPoint, viewUp);
+}
+
+glm::mat4 Camera::ProjectionMatrix(float aspect) const
+{
+    return glm::perspective(glm::radians(viewAngle), aspect, clipNear, clipFar);
+}
+
+void Camera::Azimuth(float degrees)
+{
+    glm::mat4 R = glm::rotate(glm::mat4(), glm::radians(degrees), viewUp);
+    position = focalPoint + glm::vec3(R * glm::vec4(position - focalPoint, 0.0f));
+}
+
+void Camera::Elevation(float degrees)
+{
+    glm::vec3 offset = position - focalPoint;
+    glm::vec3 axis = glm::normalize(glm::cross(offset, viewUp));
+    glm::mat4 R = glm::rotate(glm::mat4(), glm::radians(-degrees), axis);
+    position = focalPoint + glm::vec3(R * glm::vec4(offset, 0.0f));
+    viewUp = glm::normalize(glm::vec3(R * glm::vec4(viewUp, 0.0f)));
+}
+
+void Camera::Dolly(float factor)
+{
+    if (factor <= 0.0f)
+        return;
+    position = focalPoint + (position - focalPoint) / factor;
+}
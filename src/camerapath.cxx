@@ -0,0 +1,240 @@
+/* =============================================================================
+ * camerapath.cxx
+ * Masado Ishii
+ * v0.3 2026-10-19
+ *
+ * Description: Camera paths: the recording file, and replaying it.
+ *
+ * Attributions:
+ * =============================================================================
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#include <stdint.h>
+
+#include "../include/camerapath.h"
+#include "../include/utility.h"  // mishii_Seconds()
+
+
+namespace
+{
+
+// Path file layout: Header, then per frame a Record and its numKeys keys.
+struct Header
+{
+    char     magic[4];      // "FVCP"
+    uint32_t version;
+    uint32_t headerBytes;   // sizeof(Header) and sizeof(Record), checking
+    uint32_t recordBytes;   //   the layout of the build that wrote it.
+    uint32_t byteOrder;     // BYTE_ORDER_TAG as written.
+};
+
+struct Record
+{
+    float    time;
+    float    animTime;
+    float    position[3];
+    float    focalPoint[3];
+    float    viewUp[3];
+    uint32_t numKeys;
+};
+
+const char     MAGIC[4] = { 'F', 'V', 'C', 'P' };
+const uint32_t BYTE_ORDER_TAG = 0x01020304;
+
+// Animation clocks further apart than this are different frames: the
+//   clock steps by 0.01.
+const float CLOCK_TOLERANCE = 1e-4f;
+
+void ToArray(const glm::vec3 &v, float a[3]) { a[0] = v.x; a[1] = v.y; a[2] = v.z; }
+glm::vec3 FromArray(const float a[3]) { return glm::vec3(a[0], a[1], a[2]); }
+
+}
+
+
+/* --------------------------------------------------------------------
+ * CameraPathRecorder member functions.
+ * --------------------------------------------------------------------
+ */
+
+bool CameraPathRecorder::Open(const std::string &p)
+{
+    Close();
+    path = p;
+    file = fopen(path.c_str(), "wb");
+    if (file == NULL)
+    {
+        std::cerr << "CameraPathRecorder: cannot write '" << path << "': "
+                  << strerror(errno) << std::endl;
+        return false;
+    }
+
+    Header header;
+    memset(&header, 0, sizeof header);
+    memcpy(header.magic, MAGIC, 4);
+    header.version = VERSION;
+    header.headerBytes = sizeof(Header);
+    header.recordBytes = sizeof(Record);
+    header.byteOrder = BYTE_ORDER_TAG;
+    if (fwrite(&header, sizeof header, 1, file) != 1)
+    {
+        std::cerr << "CameraPathRecorder: cannot write '" << path << "'." << std::endl;
+        fclose(file);
+        file = NULL;
+        return false;
+    }
+    keys.clear();
+    numFrames = 0;
+    return true;
+}
+
+void CameraPathRecorder::Close()
+{
+    if (file == NULL)
+        return;
+    long bytes = ftell(file);
+    bool ok = (fclose(file) == 0);
+    file = NULL;
+    if (!ok)
+        std::cerr << "CameraPathRecorder: writing '" << path << "' failed." << std::endl;
+    std::cout << "record: path=" << path << " frames=" << numFrames
+              << " bytes=" << bytes << std::endl;
+}
+
+void CameraPathRecorder::RecordFrame(const glm::vec3 &position, const glm::vec3 &focalPoint,
+        const glm::vec3 &viewUp, float animTime)
+{
+    if (file == NULL)
+        return;
+    double now = mishii_Seconds();
+    if (numFrames == 0)
+        startTime = now;
+
+    Record r;
+    r.time = (float) (now - startTime);
+    r.animTime = animTime;
+    ToArray(position, r.position);
+    ToArray(focalPoint, r.focalPoint);
+    ToArray(viewUp, r.viewUp);
+    r.numKeys = (uint32_t) keys.size();
+    if (fwrite(&r, sizeof r, 1, file) != 1
+            || (!keys.empty() && fwrite(keys.data(), 1, keys.size(), file) != keys.size()))
+    {
+        std::cerr << "CameraPathRecorder: writing '" << path << "' failed; stopping." << std::endl;
+        fclose(file);
+        file = NULL;
+        return;
+    }
+    keys.clear();
+    numFrames++;
+}
+
+
+/* --------------------------------------------------------------------
+ * CameraPathPlayer member functions.
+ * --------------------------------------------------------------------
+ */
+
+bool CameraPathPlayer::Load(const std::string &p)
+{
+    path = p;
+    frames.clear();
+    frameSeconds.clear();
+    next = 0;
+    divergedAt = -1;
+
+    FILE *f = fopen(path.c_str(), "rb");
+    if (f == NULL)
+    {
+        std::cerr << "CameraPathPlayer: cannot read '" << path << "': "
+                  << strerror(errno) << std::endl;
+        return false;
+    }
+
+    Header header;
+    if (fread(&header, sizeof header, 1, f) != 1
+            || memcmp(header.magic, MAGIC, 4) != 0
+            || header.version != CameraPathRecorder::VERSION
+            || header.headerBytes != sizeof(Header)
+            || header.recordBytes != sizeof(Record)
+            || header.byteOrder != BYTE_ORDER_TAG)
+    {
+        std::cerr << "CameraPathPlayer: '" << path << "' is not a camera path of this version."
+                  << std::endl;
+        fclose(f);
+        return false;
+    }
+
+    // A record cut short ends the path: the recording run was killed.
+    Record r;
+    while (fread(&r, sizeof r, 1, f) == 1)
+    {
+        CameraPathFrame frame;
+        frame.keys.resize(r.numKeys);
+        if (r.numKeys > 0 && fread(&frame.keys[0], 1, r.numKeys, f) != r.numKeys)
+            break;
+        frame.time = r.time;
+        frame.animTime = r.animTime;
+        frame.position = FromArray(r.position);
+        frame.focalPoint = FromArray(r.focalPoint);
+        frame.viewUp = FromArray(r.viewUp);
+        frames.push_back(frame);
+    }
+    fclose(f);
+
+    if (frames.empty())
+    {
+        std::cerr << "CameraPathPlayer: '" << path << "' has no frames." << std::endl;
+        return false;
+    }
+    frameSeconds.reserve(frames.size());
+    return true;
+}
+
+void CameraPathPlayer::EndFrame(double seconds, float animTime)
+{
+    int frame = (int) next - 1;
+    frameSeconds.push_back(seconds);
+    if (divergedAt < 0 && frame >= 0
+            && std::fabs(animTime - frames[frame].animTime) > CLOCK_TOLERANCE)
+    {
+        divergedAt = frame;
+        std::cerr << "CameraPathPlayer: animation clock differs from the recording at frame "
+                  << frame << "." << std::endl;
+    }
+}
+
+void CameraPathPlayer::Report(std::ostream &out) const
+{
+    int n = (int) frameSeconds.size();
+    if (n == 0)
+        return;
+    std::vector<double> sorted(frameSeconds);
+    std::sort(sorted.begin(), sorted.end());
+    double total = 0.0;
+    for (int k = 0; k < n; k++)
+        total += sorted[k];
+
+    // Formatted apart, so that out keeps its own settings.
+    std::ostringstream line;
+    line << std::fixed << std::setprecision(3)
+         << "replay: path=" << path << " frames=" << n << "/" << frames.size()
+         << " mean_ms=" << 1e3 * total / n
+         << " p50_ms=" << 1e3 * sorted[n / 2]
+         << " p95_ms=" << 1e3 * sorted[std::min(n - 1, (int) (0.95 * n))]
+         << " max_ms=" << 1e3 * sorted[n - 1]
+         << " recorded_s=" << frames[n - 1].time
+         << " clock=";
+    if (divergedAt < 0)
+        line << "ok";
+    else
+        line << "diverged@" << divergedAt;
+    out << line.str() << std::endl;
+}
@@ -0,0 +1,426 @@
+/* =============================================================================
+ * clusteredlighting.cxx
+ * Masado Ishii
+ * v0.3 2026-10-19
+ *
+ * Description: Clustered forward shading for many dynamic point lights.
+ *
+ * Attributions:
+ * =============================================================================
+ */
+
+#ifndef GL_GLEXT_PROTOTYPES
+#define GL_GLEXT_PROTOTYPES  // GL 3.0 entry points; must precede the first gl.h.
+#endif
+#include <GL/gl.h>
+#include <GL/glext.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+
+#include "../include/clusteredlighting.h"
+
+
+/* --------------------------------------------------------------------
+ * Shader sources.
+ * --------------------------------------------------------------------
+ */
+
+namespace
+{
+    const char *clusterVertexShader =
+        "#version 130\n"
+        "out vec3 viewPos;\n"
+        "out vec4 vertColor;\n"
+        "void main()\n"
+        "{\n"
+        "    vec4 p = gl_ModelViewMatrix * gl_Vertex;\n"
+        "    viewPos = p.xyz;\n"
+        "    vertColor = gl_Color;\n"
+        "    gl_Position = gl_ProjectionMatrix * p;\n"
+        "}\n";
+
+    // The meshes carry no normals, so shade with flat face normals.
+    const char *clusterFragmentShader =
+        "#version 130\n"
+        "uniform usampler2D clusterRanges;\n"
+        "uniform usampler2D lightIndices;\n"
+        "uniform sampler2D lightData;\n"
+        "uniform vec4 viewport;\n"
+        "uniform vec3 gridSize;\n"
+        "uniform float zNear;\n"
+        "uniform float zLogScale;\n"
+        "in vec3 viewPos;\n"
+        "in vec4 vertColor;\n"
+        "const int ROW = 1024;\n"
+        "const vec3 ambient = vec3(0.2);\n"
+        "void main()\n"
+        "{\n"
+        "    vec3 n = normalize(cross(dFdx(viewPos), dFdy(viewPos)));\n"
+        "    if (dot(n, viewPos) > 0.0)\n"
+        "        n = -n;\n"
+        "    vec2 uv = clamp((gl_FragCoord.xy - viewport.xy) / viewport.zw, 0.0, 0.9999);\n"
+        "    ivec2 tile = ivec2(uv * gridSize.xy);\n"
+        "    int slice = int(clamp(log(-viewPos.z / zNear) * zLogScale, 0.0, gridSize.z - 1.0));\n"
+        "    uvec2 range = texelFetch(clusterRanges,\n"
+        "            ivec2(tile.y * int(gridSize.x) + tile.x, slice), 0).rg;\n"
+        "    vec3 c = ambient * vertColor.rgb;\n"
+        "    for (uint i = 0u; i < range.y; i++)\n"
+        "    {\n"
+        "        int k = int(range.x + i);\n"
+        "        int li = 2 * int(texelFetch(lightIndices, ivec2(k % ROW, k / ROW), 0).r);\n"
+        "        vec4 pr = texelFetch(lightData, ivec2(li % ROW, li / ROW), 0);\n"
+        "        vec3 lc = texelFetch(lightData, ivec2(li % ROW + 1, li / ROW), 0).rgb;\n"
+        "        vec3 L = pr.xyz - viewPos;\n"
+        "        float d = length(L);\n"
+        "        float att = max(1.0 - d / pr.w, 0.0);\n"
+        "        c += vertColor.rgb * lc * max(dot(n, L / d), 0.0) * att * att;\n"
+        "    }\n"
+        "    gl_FragColor = vec4(c, vertColor.a);\n"
+        "}\n";
+
+    GLuint CompileShader(GLenum type, const char *source)
+    {
+        GLuint shader = glCreateShader(type);
+        glShaderSource(shader, 1, &source, NULL);
+        glCompileShader(shader);
+
+        GLint ok;
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+        if (!ok)
+        {
+            char log[1024];
+            glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+            std::cerr << "ClusteredLighting: shader compile failed:" << std::endl
+                      << log << std::endl;
+            glDeleteShader(shader);
+            return 0;
+        }
+        return shader;
+    }
+}
+
+
+/* --------------------------------------------------------------------
+ * LightClusterGrid member functions.
+ * --------------------------------------------------------------------
+ */
+
+void LightClusterGrid::Build(const std::vector<PointLight> &lights,
+        const glm::mat4 &viewMat, const glm::mat4 &projMat, WorkerPool &pool)
+{
+    // Recover the clip planes from a GL perspective matrix.
+    zNear = projMat[3][2] / (projMat[2][2] - 1.0f);
+    zFar = projMat[3][2] / (projMat[2][2] + 1.0f);
+    zLogScale = SLICES / std::log(zFar / zNear);
+
+    int numLights = (int) lights.size();
+    viewLights.resize(2 * numLights);
+    for (int i = 0; i < numLights; i++)
+    {
+        glm::vec4 p = viewMat * glm::vec4(lights[i].position, 1.0f);
+        viewLights[2*i] = glm::vec4(glm::vec3(p), lights[i].radius);
+        viewLights[2*i + 1] = glm::vec4(lights[i].color, 0.0f);
+    }
+
+    int numChunks = pool.NumThreads();
+    chunkPairs.resize(numChunks);
+    chunkCounts.resize(numChunks);
+    for (int c = 0; c < numChunks; c++)
+    {
+        chunkPairs[c].clear();
+        chunkCounts[c].assign(NUM_CLUSTERS, 0);
+    }
+
+    // Pass 1: each chunk of lights finds its clusters.
+    pool.ParallelFor(numLights, [&](int begin, int end, int chunk)
+        { BinLights(lights, projMat, begin, end, chunk); });
+
+    // Prefix sums: clusters in order, chunks in order within a cluster.
+    // chunkCounts becomes the write cursor of each chunk.
+    clusterRanges.resize(2 * NUM_CLUSTERS);
+    GLuint offset = 0;
+    for (int k = 0; k < NUM_CLUSTERS; k++)
+    {
+        clusterRanges[2*k] = offset;
+        for (int c = 0; c < numChunks; c++)
+        {
+            GLuint count = chunkCounts[c][k];
+            chunkCounts[c][k] = offset;
+            offset += count;
+        }
+        clusterRanges[2*k + 1] = offset - clusterRanges[2*k];
+    }
+    lightIndices.resize(offset);
+
+    // Pass 2: scatter light indices.
+    pool.ParallelFor(numChunks, [&](int begin, int end, int)
+    {
+        for (int c = begin; c < end; c++)
+        {
+            const std::vector<GLuint> &pairs = chunkPairs[c];
+            std::vector<GLuint> &cursor = chunkCounts[c];
+            for (size_t p = 0; p < pairs.size(); p += 2)
+                lightIndices[cursor[pairs[p]]++] = pairs[p + 1];
+        }
+    });
+}
+
+void LightClusterGrid::BinLights(const std::vector<PointLight> &lights,
+        const glm::mat4 &projMat, int begin, int end, int chunk)
+{
+    std::vector<GLuint> &pairs = chunkPairs[chunk];
+    std::vector<GLuint> &counts = chunkCounts[chunk];
+
+    for (int i = begin; i < end; i++)
+    {
+        glm::vec3 c(viewLights[2*i]);
+        float r = viewLights[2*i].w;
+
+        // Depth range, as positive distances in front of the eye.
+        float dmin = -c.z - r, dmax = -c.z + r;
+        if (dmax < zNear || dmin > zFar)
+            continue;
+        int s0 = Slice(std::max(dmin, zNear));
+        int s1 = Slice(std::min(dmax, zFar));
+
+        // Screen range, from the view-space bounding box of the sphere.
+        int tx0 = 0, tx1 = TILES_X - 1, ty0 = 0, ty1 = TILES_Y - 1;
+        if (dmin > zNear)
+        {
+            float xmin = 1e30f, ymin = 1e30f, xmax = -1e30f, ymax = -1e30f;
+            for (int corner = 0; corner < 8; corner++)
+            {
+                glm::vec4 p(c.x + (corner & 1 ? r : -r),
+                            c.y + (corner & 2 ? r : -r),
+                            c.z + (corner & 4 ? r : -r), 1.0f);
+                glm::vec4 q = projMat * p;
+                xmin = std::min(xmin, q.x / q.w);  xmax = std::max(xmax, q.x / q.w);
+                ymin = std::min(ymin, q.y / q.w);  ymax = std::max(ymax, q.y / q.w);
+            }
+            if (xmax < -1.0f || xmin > 1.0f || ymax < -1.0f || ymin > 1.0f)
+                continue;
+            tx0 = std::max(0, (int) ((xmin + 1.0f) * 0.5f * TILES_X));
+            tx1 = std::min(TILES_X - 1, (int) ((xmax + 1.0f) * 0.5f * TILES_X));
+            ty0 = std::max(0, (int) ((ymin + 1.0f) * 0.5f * TILES_Y));
+            ty1 = std::min(TILES_Y - 1, (int) ((ymax + 1.0f) * 0.5f * TILES_Y));
+        }
+
+        for (int s = s0; s <= s1; s++)
+            for (int ty = ty0; ty <= ty1; ty++)
+                for (int tx = tx0; tx <= tx1; tx++)
+                {
+                    GLuint k = (s * TILES_Y + ty) * TILES_X + tx;
+                    pairs.push_back(k);
+                    pairs.push_back(i);
+                    counts[k]++;
+                }
+    }
+}
+
+int LightClusterGrid::Slice(float dist) const
+{
+    int s = (int) (std::log(dist / zNear) * zLogScale);
+    return std::max(0, std::min(SLICES - 1, s));
+}
+
+
+/* --------------------------------------------------------------------
+ * ClusteredLighting member functions.
+ * --------------------------------------------------------------------
+ */
+
+ClusteredLighting::ClusteredLighting()
+        : binSeconds(0.0), lightRefs(0), lights(NULL), resources(NULL),
+          initialized(false), usable(false), program(0)
+{
+    textures[0] = textures[1] = textures[2] = -1;
+}
+
+ClusteredLighting::~ClusteredLighting()
+{
+    // GL objects die with the context; there may be none current here.
+}
+
+bool ClusteredLighting::Initialize()
+{
+    initialized = true;
+    if (resources == NULL)
+        return false;
+
+    GLuint vs = CompileShader(GL_VERTEX_SHADER, clusterVertexShader);
+    GLuint fs = CompileShader(GL_FRAGMENT_SHADER, clusterFragmentShader);
+    if (vs == 0 || fs == 0)
+        return false;
+
+    program = glCreateProgram();
+    glAttachShader(program, vs);
+    glAttachShader(program, fs);
+    glLinkProgram(program);
+    glDeleteShader(vs);
+    glDeleteShader(fs);
+
+    GLint ok;
+    glGetProgramiv(program, GL_LINK_STATUS, &ok);
+    if (!ok)
+    {
+        char log[1024];
+        glGetProgramInfoLog(program, sizeof(log), NULL, log);
+        std::cerr << "ClusteredLighting: program link failed:" << std::endl
+                  << log << std::endl;
+        return false;
+    }
+
+    glUseProgram(program);
+    glUniform1i(glGetUniformLocation(program, "clusterRanges"), 0);
+    glUniform1i(glGetUniformLocation(program, "lightIndices"), 1);
+    glUniform1i(glGetUniformLocation(program, "lightData"), 2);
+    uViewport = glGetUniformLocation(program, "viewport");
+    uGridSize = glGetUniformLocation(program, "gridSize");
+    uZNear = glGetUniformLocation(program, "zNear");
+    uZLogScale = glGetUniformLocation(program, "zLogScale");
+    glUseProgram(0);
+
+    // Integer textures cannot be filtered; all three are read with texelFetch.
+    for (int t = 0; t < 3; t++)
+    {
+        textures[t] = resources->Create(GpuResources::TEXTURES);
+        glBindTexture(GL_TEXTURE_2D, resources->Name(textures[t]));
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    return true;
+}
+
+void ClusteredLighting::BeginDrawLevel(int level)
+{
+    if (!initialized)
+        usable = Initialize();
+    if (!usable || lights == NULL)
+        return;
+
+    glUseProgram(program);
+    glUniform4f(uViewport, viewport.x, viewport.y, viewport.width, viewport.height);
+    glUniform3f(uGridSize, LightClusterGrid::TILES_X, LightClusterGrid::TILES_Y,
+            LightClusterGrid::SLICES);
+    for (int t = 0; t < 3; t++)
+    {
+        glActiveTexture(GL_TEXTURE0 + t);
+        glBindTexture(GL_TEXTURE_2D, resources->Name(textures[t]));
+    }
+    glActiveTexture(GL_TEXTURE0);
+}
+
+void ClusteredLighting::BeginDrawView(const PortalView &view, const glm::mat4 &viewMat)
+{
+    if (!usable || lights == NULL)
+        return;
+
+    // Rebin in this view's eye space; the portal chain moves the eye.
+    double t0 = mishii_Seconds();
+    grid.Build(*lights, viewMat, projMat, WorkerPool::Shared());
+    binSeconds += mishii_Seconds() - t0;
+    lightRefs += (long) grid.lightIndices.size();
+
+    Upload();
+    glUniform1f(uZNear, grid.zNear);
+    glUniform1f(uZLogScale, grid.zLogScale);
+}
+
+void ClusteredLighting::EndDrawLevel(int level)
+{
+    if (!usable || lights == NULL)
+        return;
+
+    for (int t = 2; t >= 0; t--)
+    {
+        glActiveTexture(GL_TEXTURE0 + t);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+    glUseProgram(0);
+}
+
+void ClusteredLighting::Upload()
+{
+    const int row = TEXTURE_ROW;
+
+    // Pad the lists out to whole texture rows.
+    std::vector<GLuint> &indices = grid.lightIndices;
+    int indexRows = std::max(1, (int) (indices.size() + row - 1) / row);
+    indices.resize(indexRows * row, 0);
+
+    std::vector<glm::vec4> &data = grid.viewLights;
+    int dataRows = std::max(1, (int) (data.size() + row - 1) / row);
+    data.resize(dataRows * row, glm::vec4(0.0f));
+
+    glActiveTexture(GL_TEXTURE0);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RG32UI,
+            LightClusterGrid::TILES_X * LightClusterGrid::TILES_Y,
+            LightClusterGrid::SLICES, 0, GL_RG_INTEGER, GL_UNSIGNED_INT,
+            &grid.clusterRanges[0]);
+    glActiveTexture(GL_TEXTURE1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R32UI, row, indexRows, 0,
+            GL_RED_INTEGER, GL_UNSIGNED_INT, &indices[0]);
+    glActiveTexture(GL_TEXTURE2);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, row, dataRows, 0,
+            GL_RGBA, GL_FLOAT, glm::value_ptr(data[0]));
+    glActiveTexture(GL_TEXTURE0);
+
+    resources->SetBytes(textures[0], grid.clusterRanges.size() * sizeof(GLuint));
+    resources->SetBytes(textures[1], indices.size() * sizeof(GLuint));
+    resources->SetBytes(textures[2], data.size() * sizeof(glm::vec4));
+}
+
+void ClusteredLighting::BenchmarkBinning(std::ostream &out)
+{
+    const int REPEATS = 20;
+
+    // The default camera: 30 degree field of view, 2:1, clip 20..120, at (0,0,70).
+    glm::mat4 projMat = glm::perspective(glm::radians(30.0f), 2.0f, 20.0f, 120.0f);
+    glm::mat4 viewMat = glm::lookAt(glm::vec3(0.0f, 0.0f, 70.0f),
+            glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+    WorkerPool &pool = WorkerPool::Shared();
+    LightClusterGrid grid;
+    std::vector<PointLight> lights;
+    unsigned int seed = 1;
+
+    // Restored at the end, for whatever prints to out next.
+    std::ios::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+
+    out << "light binning, " << pool.NumThreads() << " threads:" << std::endl;
+    for (int n = 64; n <= 16384; n *= 4)
+    {
+        while ((int) lights.size() < n)
+        {
+            PointLight l;
+            float f[3];
+            for (int k = 0; k < 3; k++)
+            {
+                seed = seed * 1103515245u + 12345u;
+                f[k] = ((seed >> 8) & 0xFFFF) / 65535.0f;
+            }
+            l.position = glm::vec3(40.0f * f[0] - 20.0f, 40.0f * f[1] - 20.0f, 6.0f * f[2]);
+            l.radius = 4.0f;
+            l.color = glm::vec3(1.0f);
+            lights.push_back(l);
+        }
+
+        grid.Build(lights, viewMat, projMat, pool);  // Warm up.
+        double t0 = mishii_Seconds();
+        for (int r = 0; r < REPEATS; r++)
+            grid.Build(lights, viewMat, projMat, pool);
+        double t = (mishii_Seconds() - t0) / REPEATS;
+
+        out << std::fixed << std::setprecision(3)
+            << "  lights=" << n << " ms=" << 1e3 * t
+            << " refs=" << grid.lightIndices.size() << std::endl;
+    }
+    out.flags(flags);
+    out.precision(precision);
+}
@@ -0,0 +1,367 @@
+/* =============================================================================
+ * framecapture.cxx
+ * Masado Ishii
+ * v0.3 2026-10-19
+ *
+ * Description: Frame capture to a PNG sequence or a .y4m video, through a
+ *   ring of pixel buffer objects and a writer thread.
+ *
+ * Attributions:
+ * =============================================================================
+ */
+
+#ifndef GL_GLEXT_PROTOTYPES
+#define GL_GLEXT_PROTOTYPES  // Buffer objects.
+#endif
+#include <GL/gl.h>
+#include <GL/glext.h>
+
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#include "../include/framecapture.h"
+#include "../include/utility.h"
+
+
+namespace
+{
+
+// Whether pattern has exactly one %d or %0Nd conversion, and otherwise
+//   only %% escapes: the one argument WriteFrame() passes is an int.
+bool ValidPattern(const std::string &pattern)
+{
+    int numConversions = 0;
+    for (size_t i = 0; i < pattern.size(); i++)
+    {
+        if (pattern[i] != '%')
+            continue;
+        if (++i < pattern.size() && pattern[i] == '%')
+            continue;
+        if (i < pattern.size() && pattern[i] == '0')
+            while (i < pattern.size() && isdigit((unsigned char) pattern[i]))
+                i++;
+        if (i >= pattern.size() || pattern[i] != 'd')
+            return false;
+        numConversions++;
+    }
+    return numConversions == 1;
+}
+
+}  // namespace
+
+
+/* --------------------------------------------------------------------
+ * FrameCapture member functions.
+ * --------------------------------------------------------------------
+ */
+
+FrameCapture::FrameCapture()
+        : lastDropped(0), lastBlocked(0), lastWaitSeconds(0.0),
+          open(false), dropWhenFull(false), video(false), resources(NULL),
+          nextSlot(0), ringWidth(0), ringHeight(0), numCaptured(0),
+          quit(false), numWritten(0), numFailed(0), numDropped(0), numBlocked(0),
+          blockSeconds(0.0), errorShown(false)
+{
+    for (int i = 0; i < RING_SIZE; i++)
+    {
+        slots[i].buffer = -1;
+        slots[i].pending = false;
+        slots[i].index = 0;
+    }
+}
+
+FrameCapture::~FrameCapture()
+{
+    Close();
+    // The pixel buffers die with the context; there may be none current here.
+}
+
+bool FrameCapture::Open(const std::string &p, bool drop)
+{
+    Close();
+
+    path = p;
+    dropWhenFull = drop;
+    video = (path.size() > 4 && path.compare(path.size() - 4, 4, ".y4m") == 0);
+    if (!video && path.find('%') == std::string::npos)
+        path += "%05d.png";
+    if (!video && !ValidPattern(path))
+    {
+        std::cerr << "FrameCapture: bad pattern '" << p
+                  << "', expected one %d or %0Nd (and %% for '%')." << std::endl;
+        return false;
+    }
+
+    quit = false;
+    errorShown = false;
+    numCaptured = numWritten = numFailed = numDropped = numBlocked = 0;
+    blockSeconds = 0.0;
+    writer = std::thread(&FrameCapture::WriterLoop, this);
+    open = true;
+    return true;
+}
+
+/*
+ * Allocate() - Sizes the ring for width x height readbacks.
+ */
+void FrameCapture::Allocate(int width, int height)
+{
+    Release();
+    for (int i = 0; i < RING_SIZE; i++)
+    {
+        slots[i].buffer = resources->Create(GpuResources::BUFFERS);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, resources->Name(slots[i].buffer));
+        glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr) 4 * width * height,
+                NULL, GL_STREAM_READ);
+        resources->SetBytes(slots[i].buffer, (size_t) 4 * width * height);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    ringWidth = width;
+    ringHeight = height;
+    nextSlot = 0;
+}
+
+void FrameCapture::Release()
+{
+    for (int i = 0; i < RING_SIZE; i++)
+        if (slots[i].buffer >= 0)
+        {
+            resources->Delete(slots[i].buffer);
+            slots[i].buffer = -1;
+            slots[i].pending = false;
+        }
+    ringWidth = ringHeight = 0;
+}
+
+/*
+ * Capture()
+ */
+void FrameCapture::Capture(const ScissorRect &rect)
+{
+    lastDropped = lastBlocked = 0;
+    lastWaitSeconds = 0.0;
+    if (!open || rect.Empty() || resources == NULL)
+        return;
+
+    if (rect.width != ringWidth || rect.height != ringHeight)
+    {
+        Flush();
+        Allocate(rect.width, rect.height);
+    }
+
+    // The oldest slot was filled RING_SIZE frames ago; collect it first.
+    Slot &slot = slots[nextSlot];
+    if (slot.pending)
+        Collect(slot);
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, resources->Name(slot.buffer));
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(rect.x, rect.y, rect.width, rect.height,
+            GL_RGBA, GL_UNSIGNED_BYTE, 0);  // Offset 0 into the buffer.
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    slot.pending = true;
+    slot.index = numCaptured++;
+    nextSlot = (nextSlot + 1) % RING_SIZE;
+}
+
+/*
+ * Flush()
+ */
+void FrameCapture::Flush()
+{
+    if (!open)
+        return;
+    // Oldest first, so the writer sees frames in order.
+    for (int i = 0; i < RING_SIZE; i++)
+    {
+        Slot &slot = slots[(nextSlot + i) % RING_SIZE];
+        if (slot.pending)
+            Collect(slot);
+    }
+}
+
+/*
+ * CapturePixels()
+ */
+void FrameCapture::CapturePixels(int width, int height, const unsigned char *rgba)
+{
+    lastDropped = lastBlocked = 0;
+    lastWaitSeconds = 0.0;
+    if (!open)
+        return;
+
+    Frame *frame = AcquireFrame();
+    if (frame == NULL)
+        return;
+    frame->index = numCaptured++;
+    frame->width = width;
+    frame->height = height;
+    frame->pixels.assign(rgba, rgba + (size_t) 4 * width * height);
+    QueueFrame(frame, true);
+}
+
+/*
+ * Collect() - Maps a finished readback and queues it for the writer.
+ */
+void FrameCapture::Collect(Slot &slot)
+{
+    slot.pending = false;
+
+    Frame *frame = AcquireFrame();
+    if (frame == NULL)
+        return;
+    frame->index = slot.index;
+    frame->width = ringWidth;
+    frame->height = ringHeight;
+    frame->pixels.resize((size_t) 4 * ringWidth * ringHeight);
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, resources->Name(slot.buffer));
+    const void *data = glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+    if (data != NULL)
+    {
+        memcpy(&frame->pixels[0], data, frame->pixels.size());
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    QueueFrame(frame, data != NULL);
+}
+
+/*
+ * AcquireFrame() - A free frame, once the queue has room. NULL if the
+ *   frame is dropped instead.
+ */
+FrameCapture::Frame *FrameCapture::AcquireFrame()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    if ((int) queue.size() >= QUEUE_CAPACITY)
+    {
+        if (dropWhenFull)
+        {
+            numDropped++;
+            lastDropped = 1;
+            return NULL;
+        }
+        double t0 = mishii_Seconds();
+        notFull.wait(lock, [this] { return (int) queue.size() < QUEUE_CAPACITY; });
+        double wait = mishii_Seconds() - t0;
+        numBlocked++;
+        blockSeconds += wait;
+        lastBlocked = 1;
+        lastWaitSeconds = wait;
+    }
+    if (freeFrames.empty())
+        return new Frame;
+    Frame *frame = freeFrames.back();
+    freeFrames.pop_back();
+    return frame;
+}
+
+void FrameCapture::QueueFrame(Frame *frame, bool valid)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (valid)
+    {
+        queue.push_back(frame);
+        notEmpty.notify_one();
+    }
+    else
+    {
+        numFailed++;
+        freeFrames.push_back(frame);
+    }
+}
+
+/*
+ * Close()
+ */
+void FrameCapture::Close()
+{
+    if (!open)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+        notEmpty.notify_one();
+    }
+    writer.join();
+    y4m.Close();
+    open = false;
+
+    // Formatted apart, so that std::cout keeps its own settings.
+    std::ostringstream line;
+    line << "capture: path=" << path
+         << " captured=" << numCaptured
+         << " written=" << numWritten
+         << " failed=" << numFailed
+         << " dropped=" << numDropped
+         << " backpressured=" << numBlocked
+         << " wait_ms=" << std::fixed << std::setprecision(1) << 1e3 * blockSeconds;
+    std::cout << line.str() << std::endl;
+
+    for (size_t i = 0; i < freeFrames.size(); i++)
+        delete freeFrames[i];
+    freeFrames.clear();
+}
+
+/*
+ * WriterLoop() - Body of the writer thread. Drains the queue before quitting.
+ */
+void FrameCapture::WriterLoop()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+        notEmpty.wait(lock, [this] { return quit || !queue.empty(); });
+        if (queue.empty())
+            break;
+
+        Frame *frame = queue.front();
+        queue.pop_front();
+        lock.unlock();
+
+        bool ok = WriteFrame(*frame);
+
+        lock.lock();
+        if (ok)
+            numWritten++;
+        else
+            numFailed++;
+        freeFrames.push_back(frame);
+        notFull.notify_one();
+    }
+}
+
+bool FrameCapture::WriteFrame(const Frame &frame)
+{
+    if (video)
+    {
+        if (!y4m.IsOpen() && !y4m.Open(path, frame.width, frame.height, VIDEO_FPS))
+        {
+            if (!errorShown)
+                std::cerr << "FrameCapture: cannot write " << path << std::endl;
+            errorShown = true;
+            return false;
+        }
+        if (frame.width != y4m.Width() || frame.height != y4m.Height())
+            return false;  // The video keeps its first size.
+        return y4m.WriteFrame(&frame.pixels[0]);
+    }
+
+    char name[1024];
+    snprintf(name, sizeof(name), path.c_str(), (int) frame.index);
+    if (!WritePNG(name, frame.width, frame.height, &frame.pixels[0]))
+    {
+        if (!errorShown)
+            std::cerr << "FrameCapture: cannot write " << name << std::endl;
+        errorShown = true;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,320 @@
+/* =============================================================================
+ * framegraph.cxx
+ * Masado Ishii
+ * v0.3 2026-10-19
+ *
+ * Description: A frame as a graph of passes: ordering, culling, state
+ *   group runs, transient slots and per-pass timing.
+ *
+ * Attributions:
+ * =============================================================================
+ */
+
+#include <algorithm>
+#include <cstdio>
+
+#include "../include/framegraph.h"
+#include "../include/utility.h"  // mishii_Seconds()
+
+
+/* --------------------------------------------------------------------
+ * FrameGraph member functions.
+ * --------------------------------------------------------------------
+ */
+
+void FrameGraph::Clear()
+{
+    passes.clear();
+    resources.clear();
+    groups.clear();
+    schedule.clear();
+    numSlots = 0;
+    numMerged = 0;
+}
+
+FrameGraph::Resource FrameGraph::AddResource(const std::string &name, bool transient)
+{
+    ResourceInfo r;
+    r.name = name;
+    r.transient = transient;
+    r.output = false;
+    r.slot = -1;
+    r.first = r.last = -1;
+    resources.push_back(r);
+    return (Resource) resources.size() - 1;
+}
+
+int FrameGraph::AddStateGroup(const std::string &name, const PassFn &enter, const PassFn &leave)
+{
+    Group g;
+    g.name = name;
+    g.enter = enter;
+    g.leave = leave;
+    groups.push_back(g);
+    return (int) groups.size() - 1;
+}
+
+int FrameGraph::AddPass(const std::string &name, const PassFn &fn, int group)
+{
+    Pass p;
+    p.name = name;
+    p.fn = fn;
+    p.group = group;
+    p.live = false;
+    passes.push_back(p);
+    return (int) passes.size() - 1;
+}
+
+void FrameGraph::Compile()
+{
+    AddDependencies();
+    Cull();
+    Schedule();
+    AssignSlots();
+}
+
+/*
+ * AddDependencies() - A pass runs after the last earlier writer of what
+ *   it reads or writes, and after the readers since then of what it
+ *   writes.
+ */
+void FrameGraph::AddDependencies()
+{
+    std::vector<int> lastWriter(resources.size(), -1);
+    std::vector<std::vector<int> > readers(resources.size());
+
+    for (int p = 0; p < (int) passes.size(); p++)
+    {
+        Pass &pass = passes[p];
+        pass.deps.clear();
+        pass.sources.clear();
+        for (size_t i = 0; i < pass.reads.size(); i++)
+            if (lastWriter[pass.reads[i]] >= 0)
+                pass.sources.push_back(lastWriter[pass.reads[i]]);
+        std::sort(pass.sources.begin(), pass.sources.end());
+        pass.sources.erase(std::unique(pass.sources.begin(), pass.sources.end()),
+                pass.sources.end());
+        pass.deps = pass.sources;
+        for (size_t i = 0; i < pass.writes.size(); i++)
+        {
+            Resource r = pass.writes[i];
+            if (lastWriter[r] >= 0)
+                pass.deps.push_back(lastWriter[r]);
+            for (size_t k = 0; k < readers[r].size(); k++)
+                if (readers[r][k] != p)
+                    pass.deps.push_back(readers[r][k]);
+        }
+        std::sort(pass.deps.begin(), pass.deps.end());
+        pass.deps.erase(std::unique(pass.deps.begin(), pass.deps.end()), pass.deps.end());
+
+        for (size_t i = 0; i < pass.reads.size(); i++)
+            readers[pass.reads[i]].push_back(p);
+        for (size_t i = 0; i < pass.writes.size(); i++)
+        {
+            lastWriter[pass.writes[i]] = p;
+            readers[pass.writes[i]].clear();
+        }
+    }
+}
+
+/*
+ * Cull() - Keeps the passes writing outputs and, working back, those
+ *   whose writes they read. The other dependencies (a write after a
+ *   read or write) only order passes; they keep nothing. Dependencies
+ *   always point back, so one sweep does.
+ */
+void FrameGraph::Cull()
+{
+    for (size_t p = 0; p < passes.size(); p++)
+    {
+        passes[p].live = false;
+        for (size_t i = 0; i < passes[p].writes.size(); i++)
+            if (resources[passes[p].writes[i]].output)
+                passes[p].live = true;
+    }
+    for (int p = (int) passes.size() - 1; p >= 0; p--)
+        if (passes[p].live)
+            for (size_t d = 0; d < passes[p].sources.size(); d++)
+                passes[passes[p].sources[d]].live = true;
+}
+
+/*
+ * Schedule() - Of the passes ready to run, the first added, unless one
+ *   of them continues the current state group's run. Culled passes do
+ *   not run, so nothing waits for them.
+ */
+void FrameGraph::Schedule()
+{
+    std::vector<int> waiting(passes.size(), 0);  // Unscheduled dependencies.
+    std::vector<std::vector<int> > dependents(passes.size());
+    for (size_t p = 0; p < passes.size(); p++)
+        if (passes[p].live)
+            for (size_t d = 0; d < passes[p].deps.size(); d++)
+                if (passes[passes[p].deps[d]].live)
+                {
+                    waiting[p]++;
+                    dependents[passes[p].deps[d]].push_back((int) p);
+                }
+
+    std::vector<int> ready;
+    for (size_t p = 0; p < passes.size(); p++)
+        if (passes[p].live && waiting[p] == 0)
+            ready.push_back((int) p);
+
+    schedule.clear();
+    numMerged = 0;
+    int group = NO_GROUP;
+    while (!ready.empty())
+    {
+        size_t pick = 0;  // ready is kept in the order passes were added.
+        for (size_t i = 0; i < ready.size(); i++)
+            if (group != NO_GROUP && passes[ready[i]].group == group)
+            {
+                pick = i;
+                break;
+            }
+        int p = ready[pick];
+        ready.erase(ready.begin() + pick);
+
+        if (group != NO_GROUP && passes[p].group == group)
+            numMerged++;
+        group = passes[p].group;
+        schedule.push_back(p);
+
+        for (size_t i = 0; i < dependents[p].size(); i++)
+        {
+            int q = dependents[p][i];
+            if (--waiting[q] == 0)
+                ready.insert(std::lower_bound(ready.begin(), ready.end(), q), q);
+        }
+    }
+}
+
+/*
+ * AssignSlots() - Interval allocation: each transient resource, by first
+ *   use, takes the lowest slot whose last user has run.
+ */
+void FrameGraph::AssignSlots()
+{
+    for (size_t r = 0; r < resources.size(); r++)
+    {
+        resources[r].slot = -1;
+        resources[r].first = resources[r].last = -1;
+    }
+    for (int s = 0; s < (int) schedule.size(); s++)
+    {
+        const Pass &pass = passes[schedule[s]];
+        for (int rw = 0; rw < 2; rw++)
+        {
+            const std::vector<Resource> &list = (rw == 0 ? pass.reads : pass.writes);
+            for (size_t i = 0; i < list.size(); i++)
+            {
+                ResourceInfo &r = resources[list[i]];
+                if (r.first < 0)
+                    r.first = s;
+                r.last = s;
+            }
+        }
+    }
+
+    std::vector<int> order;
+    for (size_t r = 0; r < resources.size(); r++)
+        if (resources[r].transient && resources[r].first >= 0)
+            order.push_back((int) r);
+    std::stable_sort(order.begin(), order.end(),
+            [this](int a, int b) { return resources[a].first < resources[b].first; });
+
+    std::vector<int> slotFreeAfter;  // Last schedule position using each slot.
+    for (size_t i = 0; i < order.size(); i++)
+    {
+        ResourceInfo &r = resources[order[i]];
+        int slot = 0;
+        while (slot < (int) slotFreeAfter.size() && slotFreeAfter[slot] >= r.first)
+            slot++;
+        if (slot == (int) slotFreeAfter.size())
+            slotFreeAfter.push_back(-1);
+        slotFreeAfter[slot] = r.last;
+        r.slot = slot;
+    }
+    numSlots = (int) slotFreeAfter.size();
+}
+
+void FrameGraph::Execute()
+{
+    int group = NO_GROUP;
+    for (size_t s = 0; s < schedule.size(); s++)
+    {
+        const Pass &pass = passes[schedule[s]];
+        bool last = (s + 1 == schedule.size() || passes[schedule[s+1]].group != pass.group);
+        double start = (timed ? mishii_Seconds() : 0.0);
+
+        if (pass.group != group)
+        {
+            group = pass.group;
+            if (group != NO_GROUP && groups[group].enter)
+                groups[group].enter();
+        }
+        pass.fn();
+        if (last && group != NO_GROUP && groups[group].leave)
+            groups[group].leave();
+
+        if (timed)
+        {
+            if (timingSync)
+                timingSync();
+            Timing &t = timings[pass.name];  // Zeroed when new.
+            t.seconds += mishii_Seconds() - start;
+            t.frames++;
+        }
+        if (last)
+            group = NO_GROUP;
+    }
+    if (timed)
+        timedFrames++;
+}
+
+void FrameGraph::Dump(std::ostream &out) const
+{
+    int numCulled = (int) (passes.size() - schedule.size());
+    out << "framegraph: passes=" << schedule.size() << " culled=" << numCulled
+        << " merged=" << numMerged << " slots=" << numSlots;
+    if (timedFrames > 0)
+        out << " frames=" << timedFrames;
+    out << std::endl;
+
+    char line[128];
+    for (size_t s = 0; s < schedule.size(); s++)
+    {
+        const Pass &pass = passes[schedule[s]];
+        std::map<std::string, Timing>::const_iterator t = timings.find(pass.name);
+        std::string group = (pass.group == NO_GROUP ? "-" : groups[pass.group].name);
+        if (t != timings.end() && t->second.frames > 0)
+            snprintf(line, sizeof line, "  %2d %-10s %-8s %8.3f ms ", (int) s + 1,
+                    pass.name.c_str(), group.c_str(), 1e3 * t->second.seconds / t->second.frames);
+        else
+            snprintf(line, sizeof line, "  %2d %-10s %-8s %11s ", (int) s + 1,
+                    pass.name.c_str(), group.c_str(), "");
+        out << line;
+        PrintResources(out, "reads", pass.reads);
+        PrintResources(out, "writes", pass.writes);
+        out << std::endl;
+    }
+    for (size_t p = 0; p < passes.size(); p++)
+        if (!passes[p].live)
+            out << "   - " << passes[p].name << " (culled: nothing reads its writes)" << std::endl;
+}
+
+void FrameGraph::PrintResources(std::ostream &out, const char *label,
+        const std::vector<Resource> &list) const
+{
+    if (list.empty())
+        return;
+    out << " " << label << "=";
+    for (size_t i = 0; i < list.size(); i++)
+    {
+        const ResourceInfo &r = resources[list[i]];
+        out << (i > 0 ? "," : "") << r.name;
+        if (r.slot >= 0)
+            out << "@" << r.slot;
+    }
+}
@@ -0,0 +1,113 @@
+/* =============================================================================
+ * framestats.cxx
+ * Masado Ishii
+ * v0.3 2026-10-19
+ *
+ * Description: Frame timing and per-frame counters, reported periodically
+ *   as one line of text.
+ *
+ * Attributions:
+ * =============================================================================
+ */
+
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#include "../include/framestats.h"
+#include "../include/utility.h"
+
+
+/* --------------------------------------------------------------------
+ * FrameStats member functions.
+ * --------------------------------------------------------------------
+ */
+
+FrameStats::FrameStats()
+        : enabled(false), reportInterval(100), output(&std::cout),
+          frameStart(0.0), numFrames(0), sumTime(0.0), minTime(0.0), maxTime(0.0),
+          lastMean(0.0), lastFrames(0)
+{
+}
+
+void FrameStats::BeginFrame()
+{
+    frameStart = mishii_Seconds();
+}
+
+void FrameStats::EndFrame()
+{
+    double t = mishii_Seconds() - frameStart;
+    if (numFrames == 0 || t < minTime)
+        minTime = t;
+    if (numFrames == 0 || t > maxTime)
+        maxTime = t;
+    sumTime += t;
+    numFrames++;
+
+    if (enabled && reportInterval > 0 && numFrames >= reportInterval)
+        Report();
+}
+
+void FrameStats::Count(const char *name, double value)
+{
+    Find(name).sum += value;
+}
+
+void FrameStats::Sample(const char *name, double value)
+{
+    Counter &c = Find(name);
+    c.sum += value;
+    c.samples++;
+}
+
+FrameStats::Counter &FrameStats::Find(const char *name)
+{
+    for (size_t i = 0; i < counters.size(); i++)
+        if (counters[i].name == name)
+            return counters[i];
+    Counter c;
+    c.name = name;
+    c.sum = 0.0;
+    c.samples = 0;
+    counters.push_back(c);
+    return counters.back();
+}
+
+void FrameStats::Report()
+{
+    if (numFrames == 0)
+        return;
+
+    lastMean = sumTime / numFrames;
+    lastFrames = numFrames;
+
+    if (enabled && output != NULL)
+    {
+        // Formatted apart, so that the output stream keeps its own settings.
+        std::ostringstream line;
+        line << std::fixed << std::setprecision(3)
+             << "stats: frames=" << numFrames
+             << " ms mean=" << 1e3 * lastMean
+             << " min=" << 1e3 * minTime
+             << " max=" << 1e3 * maxTime;
+        for (size_t i = 0; i < counters.size(); i++)
+        {
+            const Counter &c = counters[i];
+            if (c.samples > 0)
+                line << " " << c.name << "=" << c.sum / c.samples;
+            else
+                line << " " << c.name << "=" << c.sum / numFrames;
+        }
+        *output << line.str() << std::endl;
+    }
+
+    numFrames = 0;
+    sumTime = minTime = maxTime = 0.0;
+    for (size_t i = 0; i < counters.size(); i++)
+    {
+        counters[i].sum = 0.0;
+        counters[i].samples = 0;
+    }
+}
@@ -0,0 +1,176 @@
+/* =============================================================================
+ * gpuresources.cxx
+ * Masado Ishii
+ * v0.3 2026-10-19
+ *
+ * Description: GL object ownership, memory accounting and eviction.
+ *
+ * Attributions:
+ * =============================================================================
+ */
+
+#ifndef GL_GLEXT_PROTOTYPES
+#define GL_GLEXT_PROTOTYPES  // Buffer and framebuffer objects; must precede the first gl.h.
+#endif
+#include <GL/gl.h>
+#include <GL/glext.h>
+
+#include <algorithm>
+#include <utility>
+
+#include "../include/gpuresources.h"
+
+
+/* --------------------------------------------------------------------
+ * GpuResources member functions.
+ * --------------------------------------------------------------------
+ */
+
+GpuResources::GpuResources()
+        : numEvicted(0), restoredBytes(0), overBudget(false), budget(0), frame(0)
+{
+    for (int c = 0; c < NUM_CATEGORIES; c++)
+        categoryBytes[c] = 0;
+}
+
+GpuResources::Handle GpuResources::Create(Category c, Owner *owner)
+{
+    GLuint name = 0;
+    switch (c)
+    {
+      case LISTS:        name = glGenLists(1);           break;
+      case BUFFERS:      glGenBuffers(1, &name);         break;
+      case TEXTURES:     glGenTextures(1, &name);        break;
+      case FRAMEBUFFERS: glGenFramebuffers(1, &name);    break;
+      default:           break;
+    }
+
+    Handle h;
+    if (!freeHandles.empty())
+    {
+        h = freeHandles.back();
+        freeHandles.pop_back();
+    }
+    else
+    {
+        h = (Handle) entries.size();
+        entries.push_back(Entry());
+    }
+    Entry &e = entries[h];
+    e.category = c;
+    e.name = name;
+    e.bytes = 0;
+    e.owner = owner;
+    e.lastUse = frame;
+    return h;
+}
+
+void GpuResources::Delete(Handle h)
+{
+    if (h < 0 || h >= (Handle) entries.size() || entries[h].name == 0)
+        return;
+    Entry &e = entries[h];
+    switch (e.category)
+    {
+      case LISTS:        glDeleteLists(e.name, 1);           break;
+      case BUFFERS:      glDeleteBuffers(1, &e.name);        break;
+      case TEXTURES:     glDeleteTextures(1, &e.name);       break;
+      case FRAMEBUFFERS: glDeleteFramebuffers(1, &e.name);   break;
+      default:           break;
+    }
+    categoryBytes[e.category] -= e.bytes;
+    e.name = 0;
+    e.bytes = 0;
+    e.owner = NULL;
+    freeHandles.push_back(h);
+}
+
+void GpuResources::SetBytes(Handle h, size_t bytes)
+{
+    Entry &e = entries[h];
+    categoryBytes[e.category] += bytes - e.bytes;
+    e.bytes = bytes;
+}
+
+size_t GpuResources::TotalBytes() const
+{
+    size_t total = 0;
+    for (int c = 0; c < NUM_CATEGORIES; c++)
+        total += categoryBytes[c];
+    return total;
+}
+
+void GpuResources::RequestRestore(Owner *owner)
+{
+    if (std::find(restores.begin(), restores.end(), owner) == restores.end())
+        restores.push_back(owner);
+}
+
+void GpuResources::CancelRestore(Owner *owner)
+{
+    restores.erase(std::remove(restores.begin(), restores.end(), owner), restores.end());
+}
+
+void GpuResources::EndFrame()
+{
+    numEvicted = 0;
+    restoredBytes = 0;
+    overBudget = false;
+    if (budget == 0 && restores.empty())
+        return;
+
+    while (!restores.empty() && restoredBytes < RESTORE_BYTES
+            && (budget == 0 || TotalBytes() < budget))
+    {
+        Owner *owner = restores.front();
+        restores.pop_front();
+        size_t before = TotalBytes();
+        owner->Restore(*this);
+        restoredBytes += std::max(TotalBytes(), before) - before;
+    }
+
+    if (budget > 0 && TotalBytes() > budget)
+    {
+        // Least recently used first; nothing drawn or restored this frame.
+        std::vector<std::pair<unsigned long, Handle> > candidates;
+        for (size_t h = 0; h < entries.size(); h++)
+            if (entries[h].name != 0 && entries[h].owner != NULL
+                    && entries[h].lastUse < frame)
+                candidates.push_back(std::make_pair(entries[h].lastUse, (Handle) h));
+        std::sort(candidates.begin(), candidates.end());
+
+        for (size_t i = 0; i < candidates.size() && TotalBytes() > budget; i++)
+        {
+            const Entry &e = entries[candidates[i].second];
+            if (e.name != 0 && e.owner != NULL)  // Not gone with an earlier owner.
+            {
+                Evict(e.owner);
+                numEvicted++;
+            }
+        }
+        overBudget = TotalBytes() > budget;
+    }
+}
+
+void GpuResources::Release()
+{
+    restores.clear();
+    for (size_t h = 0; h < entries.size(); h++)
+        if (entries[h].name != 0 && entries[h].owner != NULL)
+            Evict(entries[h].owner);
+    for (size_t h = 0; h < entries.size(); h++)
+        Delete((Handle) h);
+    entries.clear();
+    freeHandles.clear();
+}
+
+/*
+ * Evict() - Has owner evict its objects, then deletes any it kept.
+ */
+void GpuResources::Evict(Owner *owner)
+{
+    owner->Evict(*this);
+    for (size_t h = 0; h < entries.size(); h++)
+        if (entries[h].name != 0 && entries[h].owner == owner)
+            Delete((Handle) h);
+}
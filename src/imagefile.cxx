@@ -0,0 +1,314 @@
+/* =============================================================================
+ * imagefile.cxx
+ * Masado Ishii
+ * v0.3 2026-10-19
+ *
+ * Description: Dependency-free writers for captured frames: PNG images and
+ *   raw YUV4MPEG2 (.y4m) video; and a reader for the PNGs written.
+ *
+ * Attributions:
+ *   > PNG layout per the W3C PNG specification; deflate "stored" blocks per
+ *     RFC 1951, zlib framing per RFC 1950.
+ *   > YUV4MPEG2 layout as read by ffmpeg and mpv.
+ * =============================================================================
+ */
+
+#include <cstring>
+#include <vector>
+
+#include "../include/imagefile.h"
+
+
+/* --------------------------------------------------------------------
+ * PNG helpers: checksums and chunks.
+ * --------------------------------------------------------------------
+ */
+
+static unsigned long Crc32(unsigned long crc, const unsigned char *data, size_t n)
+{
+    static unsigned long table[256];
+    static bool tableReady = false;
+    if (!tableReady)
+    {
+        for (unsigned long i = 0; i < 256; i++)
+        {
+            unsigned long c = i;
+            for (int k = 0; k < 8; k++)
+                c = (c & 1) ? 0xEDB88320UL ^ (c >> 1) : c >> 1;
+            table[i] = c;
+        }
+        tableReady = true;
+    }
+
+    crc ^= 0xFFFFFFFFUL;
+    for (size_t i = 0; i < n; i++)
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return crc ^ 0xFFFFFFFFUL;
+}
+
+static void PutBE32(std::vector<unsigned char> &out, unsigned long v)
+{
+    out.push_back((v >> 24) & 0xFF);
+    out.push_back((v >> 16) & 0xFF);
+    out.push_back((v >> 8) & 0xFF);
+    out.push_back(v & 0xFF);
+}
+
+static bool WriteChunk(FILE *f, const char *type, const std::vector<unsigned char> &data)
+{
+    std::vector<unsigned char> head;
+    PutBE32(head, data.size());
+    head.insert(head.end(), type, type + 4);
+
+    unsigned long crc = Crc32(0, &head[4], 4);
+    if (!data.empty())
+        crc = Crc32(crc, &data[0], data.size());
+    std::vector<unsigned char> tail;
+    PutBE32(tail, crc);
+
+    return fwrite(&head[0], 1, head.size(), f) == head.size()
+        && (data.empty() || fwrite(&data[0], 1, data.size(), f) == data.size())
+        && fwrite(&tail[0], 1, tail.size(), f) == tail.size();
+}
+
+
+/* --------------------------------------------------------------------
+ * WritePNG()
+ * --------------------------------------------------------------------
+ */
+bool WritePNG(const std::string &path, int width, int height,
+        const unsigned char *rgba)
+{
+    static const unsigned char signature[8] = { 137, 'P', 'N', 'G', '\r', '\n', 26, '\n' };
+
+    std::vector<unsigned char> ihdr;
+    PutBE32(ihdr, width);
+    PutBE32(ihdr, height);
+    ihdr.push_back(8);  // Bit depth.
+    ihdr.push_back(2);  // Color type: RGB.
+    ihdr.push_back(0);  // Compression, filter, interlace.
+    ihdr.push_back(0);
+    ihdr.push_back(0);
+
+    // Scanlines top-down, each with filter type 0.
+    std::vector<unsigned char> raw;
+    raw.reserve((size_t) height * (1 + 3*width));
+    for (int y = height - 1; y >= 0; y--)
+    {
+        raw.push_back(0);
+        const unsigned char *p = rgba + (size_t) 4 * width * y;
+        for (int x = 0; x < width; x++, p += 4)
+            raw.insert(raw.end(), p, p + 3);
+    }
+
+    // zlib stream of stored (uncompressed) deflate blocks.
+    std::vector<unsigned char> idat;
+    idat.reserve(raw.size() + raw.size() / 65535 * 5 + 16);
+    idat.push_back(0x78);
+    idat.push_back(0x01);
+    size_t pos = 0;
+    do
+    {
+        size_t n = raw.size() - pos;
+        if (n > 65535)
+            n = 65535;
+        idat.push_back(pos + n == raw.size() ? 1 : 0);  // BFINAL, BTYPE = 00.
+        idat.push_back(n & 0xFF);
+        idat.push_back((n >> 8) & 0xFF);
+        idat.push_back(~n & 0xFF);
+        idat.push_back((~n >> 8) & 0xFF);
+        idat.insert(idat.end(), raw.begin() + pos, raw.begin() + pos + n);
+        pos += n;
+    } while (pos < raw.size());
+
+    unsigned long a = 1, b = 0;  // Adler-32.
+    for (size_t i = 0; i < raw.size(); i++)
+    {
+        a = (a + raw[i]) % 65521;
+        b = (b + a) % 65521;
+    }
+    PutBE32(idat, (b << 16) | a);
+
+    FILE *f = fopen(path.c_str(), "wb");
+    if (f == NULL)
+        return false;
+    bool ok = fwrite(signature, 1, 8, f) == 8
+        && WriteChunk(f, "IHDR", ihdr)
+        && WriteChunk(f, "IDAT", idat)
+        && WriteChunk(f, "IEND", std::vector<unsigned char>());
+    return (fclose(f) == 0) && ok;
+}
+
+/* --------------------------------------------------------------------
+ * ReadPNG()
+ * --------------------------------------------------------------------
+ */
+static unsigned long GetBE32(const unsigned char *p)
+{
+    return ((unsigned long) p[0] << 24) | ((unsigned long) p[1] << 16)
+        | ((unsigned long) p[2] << 8) | p[3];
+}
+
+bool ReadPNG(const std::string &path, int &width, int &height,
+        std::vector<unsigned char> &rgba)
+{
+    static const unsigned char signature[8] = { 137, 'P', 'N', 'G', '\r', '\n', 26, '\n' };
+
+    FILE *f = fopen(path.c_str(), "rb");
+    if (f == NULL)
+        return false;
+    std::vector<unsigned char> file;
+    unsigned char buffer[65536];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof buffer, f)) > 0)
+        file.insert(file.end(), buffer, buffer + n);
+    fclose(f);
+    if (file.size() < 8 || memcmp(&file[0], signature, 8) != 0)
+        return false;
+
+    // Chunks: IHDR, then the IDATs, concatenated.
+    std::vector<unsigned char> idat;
+    bool haveHeader = false;
+    for (size_t pos = 8; pos + 12 <= file.size(); )
+    {
+        size_t length = GetBE32(&file[pos]);
+        const unsigned char *type = &file[pos + 4];
+        const unsigned char *data = &file[pos + 8];
+        if (pos + 12 + length > file.size())
+            return false;
+        if (memcmp(type, "IHDR", 4) == 0)
+        {
+            if (length != 13 || data[8] != 8 || data[9] != 2
+                    || data[10] != 0 || data[11] != 0 || data[12] != 0)
+                return false;
+            width = (int) GetBE32(data);
+            height = (int) GetBE32(data + 4);
+            haveHeader = true;
+        }
+        else if (memcmp(type, "IDAT", 4) == 0)
+            idat.insert(idat.end(), data, data + length);
+        else if (memcmp(type, "IEND", 4) == 0)
+            break;
+        pos += 12 + length;
+    }
+    if (!haveHeader || width <= 0 || height <= 0 || idat.size() < 2)
+        return false;
+
+    // Stored deflate blocks only.
+    std::vector<unsigned char> raw;
+    size_t pos = 2;
+    bool last = false;
+    while (!last)
+    {
+        if (pos + 5 > idat.size() || (idat[pos] & 0x06) != 0)
+            return false;
+        last = (idat[pos] & 1) != 0;
+        size_t len = idat[pos + 1] | (idat[pos + 2] << 8);
+        pos += 5;
+        if (pos + len > idat.size())
+            return false;
+        raw.insert(raw.end(), idat.begin() + pos, idat.begin() + pos + len);
+        pos += len;
+    }
+
+    size_t rowBytes = 1 + 3 * (size_t) width;
+    if (raw.size() != rowBytes * height)
+        return false;
+    rgba.resize(4 * (size_t) width * height);
+    for (int y = 0; y < height; y++)
+    {
+        const unsigned char *row = &raw[rowBytes * (height - 1 - y)];
+        if (row[0] != 0)
+            return false;
+        unsigned char *p = &rgba[4 * (size_t) width * y];
+        for (int x = 0; x < width; x++, p += 4)
+        {
+            p[0] = row[1 + 3*x];
+            p[1] = row[2 + 3*x];
+            p[2] = row[3 + 3*x];
+            p[3] = 255;
+        }
+    }
+    return true;
+}
+
+
+/* --------------------------------------------------------------------
+ * Y4MWriter member functions.
+ * --------------------------------------------------------------------
+ */
+
+static inline unsigned char Clamp8(float v)
+{
+    return (unsigned char) (v < 0.0f ? 0.0f : (v > 255.0f ? 255.0f : v));
+}
+
+bool Y4MWriter::Open(const std::string &path, int w, int h, int rate)
+{
+    Close();
+    file = fopen(path.c_str(), "wb");
+    if (file == NULL)
+        return false;
+    width = w;
+    height = h;
+    fps = rate;
+    return fprintf(file, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n",
+            width, height, fps) > 0;
+}
+
+bool Y4MWriter::WriteFrame(const unsigned char *rgba)
+{
+    if (file == NULL)
+        return false;
+
+    int cw = (width + 1) / 2, ch = (height + 1) / 2;
+    planes.resize((size_t) width * height + 2 * (size_t) cw * ch);
+    unsigned char *yPlane = (unsigned char *) &planes[0];
+    unsigned char *cbPlane = yPlane + (size_t) width * height;
+    unsigned char *crPlane = cbPlane + (size_t) cw * ch;
+
+    // Luma per pixel; rows flipped to top-down.
+    for (int y = 0; y < height; y++)
+    {
+        const unsigned char *p = rgba + (size_t) 4 * width * (height - 1 - y);
+        unsigned char *out = yPlane + (size_t) width * y;
+        for (int x = 0; x < width; x++, p += 4)
+            out[x] = Clamp8(0.299f*p[0] + 0.587f*p[1] + 0.114f*p[2] + 0.5f);
+    }
+
+    // Chroma from the mean of each 2x2 block (clamped at odd edges).
+    for (int cy = 0; cy < ch; cy++)
+        for (int cx = 0; cx < cw; cx++)
+        {
+            float r = 0.0f, g = 0.0f, b = 0.0f;
+            for (int dy = 0; dy < 2; dy++)
+                for (int dx = 0; dx < 2; dx++)
+                {
+                    int x = 2*cx + dx < width ? 2*cx + dx : width - 1;
+                    int y = 2*cy + dy < height ? 2*cy + dy : height - 1;
+                    const unsigned char *p = rgba + 4 * ((size_t) width * (height - 1 - y) + x);
+                    r += p[0];
+                    g += p[1];
+                    b += p[2];
+                }
+            r *= 0.25f;
+            g *= 0.25f;
+            b *= 0.25f;
+            cbPlane[(size_t) cw * cy + cx] =
+                Clamp8(128.5f - 0.168736f*r - 0.331264f*g + 0.5f*b);
+            crPlane[(size_t) cw * cy + cx] =
+                Clamp8(128.5f + 0.5f*r - 0.418688f*g - 0.081312f*b);
+        }
+
+    return fputs("FRAME\n", file) >= 0
+        && fwrite(&planes[0], 1, planes.size(), file) == planes.size();
+}
+
+void Y4MWriter::Close()
+{
+    if (file != NULL)
+    {
+        fclose(file);
+        file = NULL;
+    }
+}
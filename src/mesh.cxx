@@ -12,7 +12,104 @@
 
 #include "../include/mesh.h"
 
-/* ----------------
- * PolygonMesh TBA.
- * ----------------
+/* --------------------------------------------------------------------
+ * PolygonMesh member functions.
+ * --------------------------------------------------------------------
  */
+
+GLuint PolygonMesh::AddVertex(const glm::vec3 &position, const glm::vec3 &color)
+{
+    positions.push_back(position);
+    colors.push_back(color);
+    return (GLuint) positions.size() - 1;
+}
+
+void PolygonMesh::AddTriangle(GLuint a, GLuint b, GLuint c)
+{
+    triangles.push_back(a);
+    triangles.push_back(b);
+    triangles.push_back(c);
+}
+
+void PolygonMesh::AddQuad(GLuint a, GLuint b, GLuint c, GLuint d)
+{
+    AddTriangle(a, b, c);
+    AddTriangle(a, c, d);
+}
+
+void PolygonMesh::ComputeBounds()
+{
+    if (positions.empty())
+        return;
+    glm::vec3 bmin = positions[0], bmax = positions[0];
+    for (size_t i = 1; i < positions.size(); i++)
+    {
+        bmin = glm::min(bmin, positions[i]);
+        bmax = glm::max(bmax, positions[i]);
+    }
+    SetBounds(bmin, bmax);
+}
+
+PolygonMesh::~PolygonMesh()
+{
+    if (resources != NULL)
+    {
+        resources->CancelRestore(this);
+        resources->Delete(displayList);
+    }
+}
+
+void PolygonMesh::Draw()
+{
+    if (resources != NULL && displayList < 0 && !evicted)
+        Compile();
+    if (displayList >= 0)
+    {
+        resources->Touch(displayList);
+        glCallList(resources->Name(displayList));
+    }
+    else
+    {
+        if (evicted)
+            resources->RequestRestore(this);
+        DrawImmediate();
+    }
+}
+
+void PolygonMesh::Evict(GpuResources &r)
+{
+    r.Delete(displayList);
+    displayList = -1;
+    evicted = true;
+}
+
+void PolygonMesh::Restore(GpuResources &r)
+{
+    if (displayList < 0)
+        Compile();
+}
+
+/*
+ * Compile() - Builds the display list. The estimate of its size counts a
+ *   color and a position per vertex drawn.
+ */
+void PolygonMesh::Compile()
+{
+    displayList = resources->Create(GpuResources::LISTS, this);
+    evicted = false;
+    glNewList(resources->Name(displayList), GL_COMPILE);
+    DrawImmediate();
+    glEndList();
+    resources->SetBytes(displayList, triangles.size() * 2 * sizeof(glm::vec3));
+}
+
+void PolygonMesh::DrawImmediate() const
+{
+    glBegin(GL_TRIANGLES);
+    for (size_t i = 0; i < triangles.size(); i++)
+    {
+        glColor3fv(glm::value_ptr(colors[triangles[i]]));
+        glVertex3fv(glm::value_ptr(positions[triangles[i]]));
+    }
+    glEnd();
+}
@@ -0,0 +1,439 @@
+/* =============================================================================
+ * modelcache.cxx
+ * Masado Ishii
+ * v0.3 2026-10-19
+ *
+ * Description: Imported models: OBJ parsing and the binary model cache.
+ *
+ * Attributions:
+ *   > OBJ subset per the Wavefront "Object Files (.obj)" appendix.
+ *   > FNV-1a constants per Fowler, Noll and Vo.
+ * =============================================================================
+ */
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../include/modelcache.h"
+
+
+namespace
+{
+
+/* A file mapped read-only for as long as this lives. */
+class MappedFile
+{
+  public:
+    const char *data;
+    size_t size;
+
+    MappedFile() : data(NULL), size(0) {}
+    ~MappedFile()
+    {
+        if (data != NULL)
+            munmap((void *) data, size);
+    }
+
+    /* False, with errno set, if path could not be mapped; an empty file
+     *   maps to no data.
+     */
+    bool Open(const std::string &path)
+    {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0)
+        {
+            close(fd);
+            return false;
+        }
+        size = (size_t) st.st_size;
+        void *p = (size > 0 ? mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0) : NULL);
+        int mapErrno = errno;
+        close(fd);  // The mapping holds the file.
+        if (p == MAP_FAILED)
+        {
+            errno = mapErrno;
+            size = 0;
+            return false;
+        }
+        data = (const char *) p;
+        return true;
+    }
+};
+
+// Cache file layout: Header, a Record per object, then the positions and
+//   colors of all vertices and the indices of all triangles, each array
+//   packed in object order. Indices count from the object's first vertex.
+struct Header
+{
+    char     magic[4];      // "FVMC"
+    uint32_t version;
+    uint32_t headerBytes;   // sizeof(Header) and sizeof(Record), checking
+    uint32_t recordBytes;   //   the layout of the build that wrote it.
+    uint32_t byteOrder;     // BYTE_ORDER_TAG as written.
+    uint32_t numObjects;
+    uint64_t sourceHash;
+    uint64_t numVertices;
+    uint64_t numIndices;
+};
+
+struct Record
+{
+    char     name[56];      // NUL-terminated; longer names are cut.
+    uint32_t firstVertex, numVertices;
+    uint32_t firstIndex, numIndices;
+    float    boundsMin[3], boundsMax[3];
+};
+
+const char     MAGIC[4] = { 'F', 'V', 'M', 'C' };
+const uint32_t BYTE_ORDER_TAG = 0x01020304;
+
+/* FNV-1a, folding in 8 bytes at a time; the tail a byte at a time. */
+uint64_t HashBytes(const char *data, size_t n)
+{
+    const uint64_t PRIME = 0x100000001b3ULL;
+    uint64_t h = 0xcbf29ce484222325ULL;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        uint64_t word;
+        memcpy(&word, data + i, 8);
+        h = (h ^ word) * PRIME;
+    }
+    for (; i < n; i++)
+        h = (h ^ (unsigned char) data[i]) * PRIME;
+    return h;
+}
+
+void DeleteObjects(std::vector<ModelCache::Object> &objects, size_t from)
+{
+    for (size_t i = from; i < objects.size(); i++)
+        delete objects[i].mesh;
+    objects.resize(from);
+}
+
+}  // namespace
+
+
+/* --------------------------------------------------------------------
+ * ModelCache member functions.
+ * --------------------------------------------------------------------
+ */
+
+bool ModelCache::Load(const std::string &path, std::vector<Object> &objects)
+{
+    double start = mishii_Seconds();
+    source = NONE;
+    cacheBytes = 0;
+
+    MappedFile text;
+    if (!text.Open(path))
+    {
+        std::cerr << "ModelCache: " << path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    uint64_t hash = HashBytes(text.data, text.size) ^ text.size;
+    hashSeconds = mishii_Seconds() - start;
+
+    std::string cachePath = CachePath(path);
+    if (ReadCache(cachePath, hash, objects))
+        source = CACHED;
+    else if (ParseOBJ(path, text.data, text.size, objects))
+    {
+        source = PARSED;
+        if (!WriteCache(cachePath, hash, objects))
+            std::cerr << "ModelCache: could not write " << cachePath
+                      << "; the next run parses again." << std::endl;
+    }
+    seconds = mishii_Seconds() - start;
+    return source != NONE;
+}
+
+/*
+ * ReadCache() - Maps the cache and copies out its arrays, if it is there,
+ *   was made from these source bytes by this build, and every index names
+ *   a vertex of its own object. Says nothing when it is not: the caller
+ *   parses instead.
+ */
+bool ModelCache::ReadCache(const std::string &cachePath, unsigned long long sourceHash,
+        std::vector<Object> &objects)
+{
+    MappedFile file;
+    if (!file.Open(cachePath) || file.size < sizeof(Header))
+        return false;
+
+    Header header;
+    memcpy(&header, file.data, sizeof header);
+    if (memcmp(header.magic, MAGIC, 4) != 0 || header.version != VERSION
+            || header.headerBytes != sizeof(Header) || header.recordBytes != sizeof(Record)
+            || header.byteOrder != BYTE_ORDER_TAG || header.sourceHash != sourceHash)
+        return false;
+
+    // Every array must lie within the file, so a truncated cache is rebuilt.
+    //   Counts too large for the file are refused first, so that the sizes
+    //   below cannot overflow.
+    if (header.numVertices > file.size / (2 * sizeof(glm::vec3))
+            || header.numIndices > file.size / sizeof(GLuint))
+        return false;
+    uint64_t recordsAt = sizeof(Header);
+    uint64_t positionsAt = recordsAt + (uint64_t) header.numObjects * sizeof(Record);
+    uint64_t colorsAt = positionsAt + header.numVertices * sizeof(glm::vec3);
+    uint64_t indicesAt = colorsAt + header.numVertices * sizeof(glm::vec3);
+    uint64_t end = indicesAt + header.numIndices * sizeof(GLuint);
+    if (end != file.size)
+        return false;
+
+    const Record *records = (const Record *) (file.data + recordsAt);
+    const glm::vec3 *positions = (const glm::vec3 *) (file.data + positionsAt);
+    const glm::vec3 *colors = (const glm::vec3 *) (file.data + colorsAt);
+    const GLuint *indices = (const GLuint *) (file.data + indicesAt);
+
+    size_t first = objects.size();
+    for (uint32_t k = 0; k < header.numObjects; k++)
+    {
+        const Record &r = records[k];
+        if ((uint64_t) r.firstVertex + r.numVertices > header.numVertices
+                || (uint64_t) r.firstIndex + r.numIndices > header.numIndices
+                || r.numIndices % 3 != 0 || memchr(r.name, 0, sizeof r.name) == NULL)
+        {
+            DeleteObjects(objects, first);
+            return false;
+        }
+        for (uint32_t i = 0; i < r.numIndices; i++)
+            if (indices[r.firstIndex + i] >= r.numVertices)
+            {
+                DeleteObjects(objects, first);
+                return false;
+            }
+
+        Object obj;
+        obj.name = r.name;
+        obj.mesh = new PolygonMesh;
+        obj.mesh->positions.assign(positions + r.firstVertex,
+                positions + r.firstVertex + r.numVertices);
+        obj.mesh->colors.assign(colors + r.firstVertex,
+                colors + r.firstVertex + r.numVertices);
+        obj.mesh->triangles.assign(indices + r.firstIndex,
+                indices + r.firstIndex + r.numIndices);
+        obj.mesh->SetBounds(glm::vec3(r.boundsMin[0], r.boundsMin[1], r.boundsMin[2]),
+                glm::vec3(r.boundsMax[0], r.boundsMax[1], r.boundsMax[2]));
+        objects.push_back(obj);
+    }
+    cacheBytes = file.size;
+    return true;
+}
+
+/*
+ * WriteCache() - Writes to a temporary file renamed over the cache, so a
+ *   reader never maps a partial one.
+ */
+bool ModelCache::WriteCache(const std::string &cachePath, unsigned long long sourceHash,
+        const std::vector<Object> &objects)
+{
+    Header header;
+    memset(&header, 0, sizeof header);
+    memcpy(header.magic, MAGIC, 4);
+    header.version = VERSION;
+    header.headerBytes = sizeof(Header);
+    header.recordBytes = sizeof(Record);
+    header.byteOrder = BYTE_ORDER_TAG;
+    header.numObjects = (uint32_t) objects.size();
+    header.sourceHash = sourceHash;
+
+    std::vector<Record> records(objects.size());
+    for (size_t k = 0; k < objects.size(); k++)
+    {
+        const PolygonMesh &mesh = *objects[k].mesh;
+        Record &r = records[k];
+        memset(&r, 0, sizeof r);
+        strncpy(r.name, objects[k].name.c_str(), sizeof r.name - 1);
+        r.firstVertex = (uint32_t) header.numVertices;
+        r.numVertices = (uint32_t) mesh.positions.size();
+        r.firstIndex = (uint32_t) header.numIndices;
+        r.numIndices = (uint32_t) mesh.triangles.size();
+        for (int c = 0; c < 3; c++)
+        {
+            r.boundsMin[c] = mesh.boundsMin[c];
+            r.boundsMax[c] = mesh.boundsMax[c];
+        }
+        header.numVertices += r.numVertices;
+        header.numIndices += r.numIndices;
+    }
+
+    std::string tmpPath = cachePath + ".tmp";
+    FILE *f = fopen(tmpPath.c_str(), "wb");
+    if (f == NULL)
+        return false;
+    bool ok = fwrite(&header, sizeof header, 1, f) == 1
+        && (records.empty() || fwrite(&records[0], sizeof(Record), records.size(), f) == records.size());
+    for (size_t k = 0; ok && k < objects.size(); k++)
+    {
+        const std::vector<glm::vec3> &p = objects[k].mesh->positions;
+        ok = p.empty() || fwrite(&p[0], sizeof(glm::vec3), p.size(), f) == p.size();
+    }
+    for (size_t k = 0; ok && k < objects.size(); k++)
+    {
+        const std::vector<glm::vec3> &c = objects[k].mesh->colors;
+        ok = c.empty() || fwrite(&c[0], sizeof(glm::vec3), c.size(), f) == c.size();
+    }
+    for (size_t k = 0; ok && k < objects.size(); k++)
+    {
+        const std::vector<GLuint> &t = objects[k].mesh->triangles;
+        ok = t.empty() || fwrite(&t[0], sizeof(GLuint), t.size(), f) == t.size();
+    }
+    ok = (fclose(f) == 0) && ok;
+    if (!ok || rename(tmpPath.c_str(), cachePath.c_str()) != 0)
+    {
+        remove(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+/*
+ * ParseOBJ() - Vertices ("v", with optional colors) and faces ("f", as
+ *   triangle fans, any of the v/vt/vn forms, negative indices counting
+ *   back); "o" and "g" start a new object. Other statements are skipped.
+ *   Each object gets the vertices its faces use, so objects sharing a
+ *   vertex each get a copy. Objects without faces are dropped.
+ */
+bool ModelCache::ParseOBJ(const std::string &path, const char *text, size_t n,
+        std::vector<Object> &objects)
+{
+    const glm::vec3 gray(0.7f, 0.7f, 0.7f);  // Uncolored vertices.
+
+    std::vector<glm::vec3> positions, colors;
+    std::vector<GLuint> local;    // Index in the current object of each
+    std::vector<size_t> touched;  //   vertex it uses, or NONE.
+    const GLuint NONE = ~(GLuint) 0;
+
+    std::string name = "model";
+    PolygonMesh *mesh = NULL;
+    std::vector<GLuint> face;
+    std::string line;
+    size_t first = objects.size();
+    int lineNumber = 0;
+
+    for (size_t pos = 0; pos < n; )
+    {
+        size_t eol = pos;
+        while (eol < n && text[eol] != '\n')
+            eol++;
+        line.assign(text + pos, eol - pos);  // NUL-terminated for strtof().
+        pos = eol + 1;
+        lineNumber++;
+
+        const char *s = line.c_str();
+        while (*s == ' ' || *s == '\t')
+            s++;
+        bool v = (s[0] == 'v' && (s[1] == ' ' || s[1] == '\t'));
+        bool f = (s[0] == 'f' && (s[1] == ' ' || s[1] == '\t'));
+        bool o = ((s[0] == 'o' || s[0] == 'g') && (s[1] == ' ' || s[1] == '\t'));
+
+        if (v)
+        {
+            char *end;
+            float x[6];
+            const char *p = s + 2;
+            int k;
+            for (k = 0; k < 6; k++, p = end)
+            {
+                x[k] = strtof(p, &end);
+                if (end == p)
+                    break;
+            }
+            if (k < 3)
+            {
+                std::cerr << "ModelCache: " << path << ":" << lineNumber
+                          << ": bad vertex." << std::endl;
+                DeleteObjects(objects, first);
+                return false;
+            }
+            positions.push_back(glm::vec3(x[0], x[1], x[2]));
+            colors.push_back(k == 6 ? glm::vec3(x[3], x[4], x[5]) : gray);
+            local.push_back(NONE);
+        }
+        else if (f)
+        {
+            face.clear();
+            const char *p = s + 2;
+            while (true)
+            {
+                char *end;
+                long i = strtol(p, &end, 10);
+                if (end == p)
+                    break;
+                long vi = (i < 0 ? (long) positions.size() + i : i - 1);
+                if (i == 0 || vi < 0 || vi >= (long) positions.size())
+                {
+                    face.clear();
+                    break;
+                }
+                if (mesh == NULL)
+                {
+                    mesh = new PolygonMesh;
+                    Object obj;
+                    obj.name = name;
+                    obj.mesh = mesh;
+                    objects.push_back(obj);
+                }
+                if (local[vi] == NONE)
+                {
+                    local[vi] = mesh->AddVertex(positions[vi], colors[vi]);
+                    touched.push_back(vi);
+                }
+                face.push_back(local[vi]);
+                for (p = end; *p != '\0' && *p != ' ' && *p != '\t' && *p != '\r'; p++)
+                    ;  // Past "/vt/vn".
+            }
+            if (face.size() < 3)
+            {
+                std::cerr << "ModelCache: " << path << ":" << lineNumber
+                          << ": bad face." << std::endl;
+                DeleteObjects(objects, first);
+                return false;
+            }
+            for (size_t k = 2; k < face.size(); k++)
+                mesh->AddTriangle(face[0], face[k-1], face[k]);
+        }
+        else if (o)
+        {
+            const char *e = line.c_str() + line.size();
+            s += 2;
+            while (*s == ' ' || *s == '\t')
+                s++;
+            while (e > s && (e[-1] == ' ' || e[-1] == '\t' || e[-1] == '\r'))
+                e--;
+            if (e > s)
+                name.assign(s, e - s);
+            if (mesh != NULL)
+            {
+                mesh->ComputeBounds();
+                mesh = NULL;
+                for (size_t k = 0; k < touched.size(); k++)
+                    local[touched[k]] = NONE;
+                touched.clear();
+            }
+        }
+    }
+    if (mesh != NULL)
+        mesh->ComputeBounds();
+
+    if (objects.size() == first)
+    {
+        std::cerr << "ModelCache: " << path << ": no faces." << std::endl;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,283 @@
+/* =============================================================================
+ * parallel.cxx
+ * Masado Ishii
+ * v0.3 2026-10-19
+ *
+ * Description: Worker threads for the CPU side of the renderer: a pool for
+ *   evenly sized data-parallel loops, and a work-stealing scheduler for
+ *   tasks of uneven cost.
+ *
+ * Attributions:
+ * =============================================================================
+ */
+
+#include "../include/parallel.h"
+
+
+namespace
+{
+
+// Process-wide instances behind Shared(); see RestartShared().
+std::mutex sharedMutex;
+WorkerPool *sharedPool = NULL;
+TaskScheduler *sharedScheduler = NULL;
+
+}  // namespace
+
+
+/* --------------------------------------------------------------------
+ * WorkerPool member functions.
+ * --------------------------------------------------------------------
+ */
+
+WorkerPool::WorkerPool(int numThreads)
+        : job(NULL), jobSize(0), generation(0), pending(0), quit(false)
+{
+    if (numThreads <= 0)
+        numThreads = (int) std::thread::hardware_concurrency();
+    if (numThreads <= 0)
+        numThreads = 1;
+
+    for (int chunk = 1; chunk < numThreads; chunk++)
+        workers.push_back(std::thread(&WorkerPool::WorkerLoop, this, chunk));
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    wake.notify_all();
+    for (size_t i = 0; i < workers.size(); i++)
+        workers[i].join();
+}
+
+WorkerPool &WorkerPool::Shared()
+{
+    std::lock_guard<std::mutex> lock(sharedMutex);
+    if (sharedPool == NULL)
+        sharedPool = new WorkerPool;
+    return *sharedPool;
+}
+
+/*
+ * RestartShared() - The inherited pool's threads did not survive fork(),
+ *   and it cannot be destroyed without them, so it is left behind.
+ */
+void WorkerPool::RestartShared()
+{
+    std::lock_guard<std::mutex> lock(sharedMutex);
+    if (sharedPool != NULL)
+        sharedPool = new WorkerPool;
+}
+
+void WorkerPool::ParallelFor(int n, const RangeFn &fn)
+{
+    if (n <= 0)
+        return;
+    if (workers.empty() || n == 1)
+    {
+        fn(0, n, 0);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job = &fn;
+        jobSize = n;
+        pending = (int) workers.size();
+        generation++;
+    }
+    wake.notify_all();
+
+    RunChunk(0);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [this] { return pending == 0; });
+    job = NULL;
+}
+
+void WorkerPool::RunChunk(int chunk)
+{
+    int numChunks = NumThreads();
+    int begin = (int) ((long long) jobSize * chunk / numChunks);
+    int end = (int) ((long long) jobSize * (chunk + 1) / numChunks);
+    if (begin < end)
+        (*job)(begin, end, chunk);
+}
+
+void WorkerPool::WorkerLoop(int chunk)
+{
+    unsigned long seen = 0;
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return quit || generation != seen; });
+            if (quit)
+                return;
+            seen = generation;
+        }
+
+        RunChunk(chunk);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--pending == 0)
+            done.notify_one();
+    }
+}
+
+
+/* --------------------------------------------------------------------
+ * TaskScheduler member functions.
+ * --------------------------------------------------------------------
+ */
+
+TaskScheduler::TaskScheduler(int numThreads)
+        : job(NULL), generation(0), pending(0), quit(false), numSteals(0)
+{
+    if (numThreads <= 0)
+        numThreads = (int) std::thread::hardware_concurrency();
+    if (numThreads <= 0)
+        numThreads = 1;
+
+    queues = std::vector<Queue>(numThreads);
+    for (int thread = 1; thread < numThreads; thread++)
+        workers.push_back(std::thread(&TaskScheduler::WorkerLoop, this, thread));
+}
+
+TaskScheduler::~TaskScheduler()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    wake.notify_all();
+    for (size_t i = 0; i < workers.size(); i++)
+        workers[i].join();
+}
+
+TaskScheduler &TaskScheduler::Shared()
+{
+    std::lock_guard<std::mutex> lock(sharedMutex);
+    if (sharedScheduler == NULL)
+        sharedScheduler = new TaskScheduler;
+    return *sharedScheduler;
+}
+
+void TaskScheduler::RestartShared()
+{
+    std::lock_guard<std::mutex> lock(sharedMutex);
+    if (sharedScheduler != NULL)
+        sharedScheduler = new TaskScheduler;  // As in WorkerPool::RestartShared().
+}
+
+void TaskScheduler::Run(int numTasks, const TaskFn &fn)
+{
+    numSteals = 0;
+    if (numTasks <= 0)
+        return;
+    if (workers.empty() || numTasks == 1)
+    {
+        for (int task = 0; task < numTasks; task++)
+            fn(task, 0);
+        return;
+    }
+
+    int numThreads = NumThreads();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (int t = 0; t < numThreads; t++)
+        {
+            std::lock_guard<std::mutex> queueLock(queues[t].mutex);
+            queues[t].begin = (int) ((long long) numTasks * t / numThreads);
+            queues[t].end = (int) ((long long) numTasks * (t + 1) / numThreads);
+        }
+        job = &fn;
+        pending = (int) workers.size();
+        generation++;
+    }
+    wake.notify_all();
+
+    RunTasks(0);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [this] { return pending == 0; });
+    job = NULL;
+}
+
+/*
+ * RunTasks() - Returns once no queue has a task left. Tasks being stolen
+ *   are in no queue, but the thief runs them itself, so every task is
+ *   done by the time all threads have returned.
+ */
+void TaskScheduler::RunTasks(int thread)
+{
+    int task;
+    for (;;)
+    {
+        if (Pop(thread, task))
+            (*job)(task, thread);
+        else if (!Steal(thread))
+            return;
+    }
+}
+
+bool TaskScheduler::Pop(int thread, int &task)
+{
+    Queue &q = queues[thread];
+    std::lock_guard<std::mutex> lock(q.mutex);
+    if (q.begin >= q.end)
+        return false;
+    task = q.begin++;
+    return true;
+}
+
+bool TaskScheduler::Steal(int thread)
+{
+    int numThreads = NumThreads();
+    for (int k = 1; k < numThreads; k++)
+    {
+        Queue &victim = queues[(thread + k) % numThreads];
+        int begin, end;
+        {
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            int left = victim.end - victim.begin;
+            if (left <= 0)
+                continue;
+            end = victim.end;
+            begin = end - (left + 1) / 2;
+            victim.end = begin;
+        }
+
+        Queue &q = queues[thread];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        q.begin = begin;
+        q.end = end;
+        numSteals++;
+        return true;
+    }
+    return false;
+}
+
+void TaskScheduler::WorkerLoop(int thread)
+{
+    unsigned long seen = 0;
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return quit || generation != seen; });
+            if (quit)
+                return;
+            seen = generation;
+        }
+
+        RunTasks(thread);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--pending == 0)
+            done.notify_one();
+    }
+}
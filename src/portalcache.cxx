@@ -0,0 +1,109 @@
+/* =============================================================================
+ * portalcache.cxx
+ * Masado Ishii
+ * v0.3 2026-10-19
+ *
+ * Description: Camera-independent transforms of the portal graph, kept
+ *   from frame to frame.
+ *
+ * Attributions:
+ * =============================================================================
+ */
+
+#include "../include/portalcache.h"
+
+
+/* --------------------------------------------------------------------
+ * PortalTransformCache member functions.
+ * --------------------------------------------------------------------
+ */
+
+const int PortalTransformCache::ROOT;
+const int PortalTransformCache::MAX_CHAINS;
+
+PortalTransformCache::PortalTransformCache()
+        : linkHits(0), linkMisses(0), chainHits(0), chainMisses(0), nextStamp(1)
+{
+    Clear();
+}
+
+void PortalTransformCache::Clear()
+{
+    links.clear();
+    chainIds.clear();
+
+    ChainEntry root;
+    root.chain.chainMat = glm::mat4(1.0);
+    root.chain.invChainMat = glm::mat4(1.0);
+    chains.assign(1, root);
+}
+
+void PortalTransformCache::BeginFrame()
+{
+    linkHits = linkMisses = 0;
+    chainHits = chainMisses = 0;
+    if (NumChains() > MAX_CHAINS || (int) links.size() > MAX_CHAINS)
+        Clear();
+}
+
+double PortalTransformCache::HitRate() const
+{
+    long hits = linkHits + chainHits;
+    long lookups = hits + linkMisses + chainMisses;
+    return lookups > 0 ? (double) hits / lookups : 1.0;
+}
+
+const PortalTransformCache::Link &PortalTransformCache::GetLink(const PortalObject *portal)
+{
+    const PortalObject *dest = portal->destPortal;
+    LinkEntry &entry = links[portal];  // Versions start at 1, so new entries miss.
+    if (entry.dest == dest && entry.version == portal->Version()
+            && entry.destVersion == dest->Version())
+    {
+        linkHits++;
+        return entry.link;
+    }
+
+    linkMisses++;
+    entry.link.linkMat = portal->LinkMatrix();
+    entry.link.invModelMat = glm::inverse(portal->modelMat);
+    entry.dest = dest;
+    entry.version = portal->Version();
+    entry.destVersion = dest->Version();
+    return entry.link;
+}
+
+/*
+ * Extend() - The parent was looked up (or extended) before its children
+ *   this frame, so comparing stamps with it is enough to know that
+ *   nothing further up the chain has changed.
+ */
+int PortalTransformCache::Extend(int parent, const PortalObject *portal)
+{
+    const PortalObject *dest = portal->destPortal;
+    std::pair<std::unordered_map<ChainKey, int, ChainKeyHash>::iterator, bool> found =
+            chainIds.insert(std::make_pair(ChainKey(parent, portal), (int) chains.size()));
+    int id = found.first->second;
+    if (found.second)
+        chains.push_back(ChainEntry());
+
+    ChainEntry &entry = chains[id];
+    if (!found.second && entry.dest == dest && entry.version == portal->Version()
+            && entry.destVersion == dest->Version()
+            && entry.parentStamp == chains[parent].stamp)
+    {
+        chainHits++;
+        return id;
+    }
+
+    chainMisses++;
+    const Link &link = GetLink(portal);
+    entry.chain.chainMat = chains[parent].chain.chainMat * link.linkMat;
+    entry.chain.invChainMat = glm::inverse(entry.chain.chainMat);
+    entry.dest = dest;
+    entry.version = portal->Version();
+    entry.destVersion = dest->Version();
+    entry.stamp = nextStamp++;
+    entry.parentStamp = chains[parent].stamp;
+    return id;
+}
@@ -0,0 +1,976 @@
+/* =============================================================================
+ * portalplan.cxx
+ * Masado Ishii
+ * v0.3 2026-10-19
+ *
+ * Description: Breadth-first frame planning for portal rendering, and the
+ *   level-batched GL renderer that executes a plan.
+ *
+ * Attributions:
+ * =============================================================================
+ */
+
+#ifndef GL_GLEXT_PROTOTYPES
+#define GL_GLEXT_PROTOTYPES  // Occlusion queries; must precede the first gl.h.
+#endif
+#include <GL/gl.h>
+#include <GL/glext.h>
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+#include "../include/portalplan.h"
+#include "../include/viewscaling.h"
+#include "../include/utility.h"  // mishii_Seconds()
+
+
+/* --------------------------------------------------------------------
+ * ScissorRect members.
+ * --------------------------------------------------------------------
+ */
+
+ScissorRect ScissorRect::Intersect(const ScissorRect &o) const
+{
+    int x0 = std::max(x, o.x);
+    int y0 = std::max(y, o.y);
+    int x1 = std::min(x + width, o.x + o.width);
+    int y1 = std::min(y + height, o.y + o.height);
+    if (x1 <= x0 || y1 <= y0)
+        return ScissorRect();
+    return ScissorRect(x0, y0, x1 - x0, y1 - y0);
+}
+
+ScissorRect ScissorRect::Union(const ScissorRect &o) const
+{
+    if (o.Empty())
+        return *this;
+    if (Empty())
+        return o;
+    int x0 = std::min(x, o.x);
+    int y0 = std::min(y, o.y);
+    int x1 = std::max(x + width, o.x + o.width);
+    int y1 = std::max(y + height, o.y + o.height);
+    return ScissorRect(x0, y0, x1 - x0, y1 - y0);
+}
+
+
+/* --------------------------------------------------------------------
+ * StencilAllocator members.
+ * --------------------------------------------------------------------
+ */
+
+void StencilAllocator::Reset(const ScissorRect &rootRect, int stencilBits)
+{
+    if (stencilBits > MAX_STENCIL_BITS)
+        stencilBits = MAX_STENCIL_BITS;
+    numValues = 1 << stencilBits;
+    for (int v = 0; v < MAX_VALUES; v++)
+    {
+        holders[v].clear();
+        holderBounds[v] = ScissorRect();
+    }
+    nextFresh = 1;
+    numShared = 0;
+    Hold(0, rootRect);
+}
+
+GLint StencilAllocator::Allocate(const ScissorRect &rect)
+{
+    if (nextFresh < numValues)
+    {
+        Hold(nextFresh, rect);
+        return nextFresh++;
+    }
+
+    // All values are taken. Share one whose holders are all disjoint from rect.
+    for (GLint v = 1; v < numValues; v++)
+    {
+        if (holderBounds[v].Overlaps(rect))
+        {
+            if ((int) holders[v].size() >= MAX_SHARED_HOLDERS)
+                continue;
+            bool disjoint = true;
+            for (size_t h = 0; h < holders[v].size() && disjoint; h++)
+                disjoint = !holders[v][h].Overlaps(rect);
+            if (!disjoint)
+                continue;
+        }
+        Hold(v, rect);
+        numShared++;
+        return v;
+    }
+
+    return -1;
+}
+
+void StencilAllocator::Hold(GLint value, const ScissorRect &rect)
+{
+    if (holders[value].empty())
+        holderBounds[value] = rect;
+    else
+        holderBounds[value] = holderBounds[value].Union(rect);
+    holders[value].push_back(rect);
+}
+
+
+/* --------------------------------------------------------------------
+ * PortalFramePlan members.
+ * --------------------------------------------------------------------
+ */
+
+void PortalFramePlan::Clear()
+{
+    views.clear();
+    levelBegin.clear();
+    numCulled = 0;
+    numDemoted = 0;
+    numShared = 0;
+    numScaled = 0;
+    for (size_t e = 0; e < eyes.size(); e++)
+    {
+        eyes[e].viewMats.clear();
+        eyes[e].scissors.clear();
+    }
+}
+
+
+/* --------------------------------------------------------------------
+ * PortalFramePlanner members.
+ * --------------------------------------------------------------------
+ */
+
+const float PortalFramePlanner::MIN_RESOLUTION_SCALE = 0.125f;
+
+namespace
+{
+    // A child view waiting to be sorted nearest-first.
+    struct PendingChild
+    {
+        float viewZ;  // View-space z of the portal origin; larger is nearer.
+        PortalView view;
+        int chain;    // Of PortalFramePlanner::transforms.
+        ScissorRect eyeScissors[PortalEye::MAX_EYES];
+
+        bool operator<(const PendingChild &o) const { return viewZ > o.viewZ; }
+    };
+
+    // Draw list order: by mesh, then as in the scene.
+    struct MeshOrder
+    {
+        const std::vector<const MeshObject *> *objects;
+
+        bool operator()(int a, int b) const
+        {
+            const Mesh *ma = (*objects)[a]->mesh;
+            const Mesh *mb = (*objects)[b]->mesh;
+            if (ma != mb)
+                return std::less<const Mesh *>()(ma, mb);
+            return a < b;
+        }
+    };
+}
+
+void PortalFramePlanner::Plan(MeshObjList &scene, const glm::mat4 &viewMat,
+        const glm::mat4 &projMat, const ScissorRect &viewport,
+        PortalFramePlan &plan)
+{
+    plan.eyes.clear();
+    PlanViews(scene, viewMat, projMat, viewport, plan);
+}
+
+void PortalFramePlanner::PlanMultiView(MeshObjList &scene,
+        const std::vector<EyeCamera> &cameras, PortalFramePlan &plan)
+{
+    int numEyes = std::min((int) cameras.size(), (int) PortalEye::MAX_EYES);
+    plan.eyes.resize(numEyes);
+    for (int e = 0; e < numEyes; e++)
+        plan.eyes[e].camera = cameras[e];
+
+    EyeCamera shared = SharedCamera(cameras);
+    PlanViews(scene, shared.viewMat, shared.projMat, shared.viewport, plan);
+}
+
+EyeCamera PortalFramePlanner::SharedCamera(const std::vector<EyeCamera> &cameras)
+{
+    EyeCamera shared = cameras[0];
+
+    // Same orientation, at the mean eye position.
+    glm::vec3 center(0.0f);
+    for (size_t e = 0; e < cameras.size(); e++)
+        center += glm::vec3(glm::inverse(cameras[e].viewMat)[3]);
+    center = center * (1.0f / cameras.size());
+    glm::mat4 rotation = cameras[0].viewMat;
+    rotation[3] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    shared.viewMat = rotation;
+    shared.viewMat[3] = glm::vec4(-(glm::mat3(rotation) * center), 1.0f);
+
+    // Bound the corners of every eye frustum by slopes from the center.
+    float l = 1e30f, r = -1e30f, b = 1e30f, t = -1e30f;
+    float n = 1e30f, f = 0.0f;
+    for (size_t e = 0; e < cameras.size(); e++)
+    {
+        glm::mat4 toShared = shared.viewMat * glm::inverse(cameras[e].viewMat)
+                * glm::inverse(cameras[e].projMat);
+        for (int corner = 0; corner < 8; corner++)
+        {
+            glm::vec4 c = toShared * glm::vec4(corner & 1 ? 1.0f : -1.0f,
+                    corner & 2 ? 1.0f : -1.0f, corner & 4 ? 1.0f : -1.0f, 1.0f);
+            glm::vec3 p = glm::vec3(c) / c.w;
+            float depth = -p.z;
+            l = std::min(l, p.x / depth);  r = std::max(r, p.x / depth);
+            b = std::min(b, p.y / depth);  t = std::max(t, p.y / depth);
+            n = std::min(n, depth);        f = std::max(f, depth);
+        }
+    }
+    shared.projMat = glm::frustum(l*n, r*n, b*n, t*n, n, f);
+    return shared;
+}
+
+void PortalFramePlanner::PlanViews(MeshObjList &scene, const glm::mat4 &viewMat,
+        const glm::mat4 &projMat, const ScissorRect &viewport,
+        PortalFramePlan &plan)
+{
+    plan.Clear();
+    stencilAllocator.Reset(viewport, stencilBits);
+    numScenes = 0;
+    viewScene.clear();
+    viewChain.clear();
+    demoted.clear();
+    transforms.BeginFrame();
+
+    int numEyes = (int) plan.eyes.size();
+    float quality = numEyes > 0 ? 1.0f : viewQuality;
+
+    // Eye positions in the root scene. A view's inverse chain matrix takes
+    //   them into its scene, and a portal's inverse model matrix from there
+    //   into the portal's space, which only leaves the camera to invert.
+    glm::vec4 eyePoints[PortalEye::MAX_EYES];
+    eyePoints[0] = glm::inverse(viewMat)[3];
+    for (int e = 0; e < numEyes; e++)
+        eyePoints[e] = glm::inverse(plan.eyes[e].camera.viewMat)[3];
+    int numEyePoints = std::max(numEyes, 1);
+
+    PortalView root;
+    root.parent = -1;
+    root.depth = 0;
+    root.portal = NULL;
+    root.skipPortal = NULL;
+    root.scene = &scene;
+    root.chainMat = glm::mat4(1.0);
+    root.viewMat = viewMat;
+    root.stencilRef = 0;
+    root.scissor = viewport;
+    root.resolutionScale = 1.0f;
+    plan.views.push_back(root);
+    viewScene.push_back(IndexScene(&scene));
+    viewChain.push_back(PortalTransformCache::ROOT);
+    plan.levelBegin.push_back(0);
+    for (int e = 0; e < numEyes; e++)
+    {
+        plan.eyes[e].viewMats.push_back(plan.eyes[e].camera.viewMat);
+        plan.eyes[e].scissors.push_back(plan.eyes[e].camera.viewport);
+    }
+
+    std::vector<PendingChild> pending;
+
+    // Each pass of the outer loop expands one recursion level; the views
+    //   it appends make up the next level. This replaces the recursion
+    //   that used to live in PortalObject::Draw().
+    for (int depth = 0; ; depth++)
+    {
+        int begin = plan.levelBegin[depth];
+        int end = (int) plan.views.size();
+
+        for (int vi = begin; vi < end; vi++)
+        {
+            // The deepest views draw their portals as surfaces.
+            if (depth >= MAX_PORTAL_RECURSION_DEPTH)
+                continue;
+
+            pending.clear();
+            {
+                // Note: plan.views may not grow inside this block. Objects
+                //   other than these portals go to draw lists later.
+                PortalView &view = plan.views[vi];
+                const SceneIndex &index = sceneIndex[viewScene[vi]];
+                glm::vec4 viewEyes[PortalEye::MAX_EYES];
+                const glm::mat4 &invChainMat = transforms.GetChain(viewChain[vi]).invChainMat;
+                for (int e = 0; e < numEyePoints; e++)
+                    viewEyes[e] = invChainMat * eyePoints[e];
+
+                for (size_t p = 0; p < index.portals.size(); p++)
+                {
+                    const MeshObject *obj = index.objects[index.portals[p]];
+                    if (obj == view.skipPortal)
+                        continue;
+                    const PortalObject *portal = obj->AsPortal();
+
+                    // Single-sided: the back of a portal is culled anyway.
+                    if (!FacesViewer(transforms.GetLink(portal).invModelMat,
+                            viewEyes, numEyePoints))
+                    {
+                        plan.numCulled++;
+                        continue;
+                    }
+
+                    ScissorRect rect = ProjectBounds(*portal, view.viewMat,
+                            projMat, viewport, view.scissor);
+                    if (rect.Empty())
+                    {
+                        plan.numCulled++;
+                        continue;
+                    }
+
+                    // Each eye's rect, moved to its viewport's origin, so that
+                    //   views sharing a stencil value are disjoint in every eye.
+                    PendingChild pc;
+                    ScissorRect stencilRect = rect;
+                    if (numEyes > 0)
+                    {
+                        stencilRect = ScissorRect();
+                        for (int e = 0; e < numEyes; e++)
+                        {
+                            const PortalEye &eye = plan.eyes[e];
+                            ScissorRect &er = pc.eyeScissors[e];
+                            er = ProjectBounds(*portal, eye.viewMats[vi],
+                                    eye.camera.projMat, eye.camera.viewport,
+                                    eye.scissors[vi]);
+                            if (!er.Empty())
+                                stencilRect = stencilRect.Union(ScissorRect(
+                                        er.x - eye.camera.viewport.x,
+                                        er.y - eye.camera.viewport.y,
+                                        er.width, er.height));
+                        }
+                        if (stencilRect.Empty())
+                        {
+                            plan.numCulled++;
+                            continue;
+                        }
+                    }
+
+                    GLint stencilRef = stencilAllocator.Allocate(stencilRect);
+                    if (stencilRef < 0)
+                    {
+                        plan.numDemoted++;
+                        demoted.push_back(std::make_pair(vi, index.portals[p]));
+                        continue;
+                    }
+
+                    pc.viewZ = (view.viewMat * portal->modelMat)[3][2];
+                    pc.view.parent = vi;
+                    pc.view.depth = depth + 1;
+                    pc.view.portal = portal;
+                    pc.view.skipPortal = portal->destPortal;
+                    pc.view.scene = portal->destPortal->parentScene;
+                    pc.chain = transforms.Extend(viewChain[vi], portal);
+                    pc.view.chainMat = transforms.GetChain(pc.chain).chainMat;
+                    pc.view.viewMat = viewMat * pc.view.chainMat;
+                    pc.view.stencilRef = stencilRef;
+                    pc.view.scissor = rect;
+                    pc.view.resolutionScale = ResolutionScale(depth + 1, rect, quality);
+                    if (pc.view.resolutionScale < 1.0f)
+                        plan.numScaled++;
+                    pending.push_back(pc);
+                }
+            }
+
+            // Nearest first, so that it wins where sibling portals overlap.
+            std::stable_sort(pending.begin(), pending.end());
+            for (size_t c = 0; c < pending.size(); c++)
+            {
+                plan.views[vi].children.push_back((int) plan.views.size());
+                plan.views.push_back(pending[c].view);
+                viewScene.push_back(IndexScene(pending[c].view.scene));
+                viewChain.push_back(pending[c].chain);
+                for (int e = 0; e < numEyes; e++)
+                {
+                    PortalEye &eye = plan.eyes[e];
+                    eye.viewMats.push_back(eye.camera.viewMat * pending[c].view.chainMat);
+                    eye.scissors.push_back(pending[c].eyeScissors[e]);
+                }
+            }
+        }
+
+        plan.levelBegin.push_back(end);  // Also the start of the next level.
+        if ((int) plan.views.size() == end)
+            break;
+    }
+
+    plan.numShared = stencilAllocator.NumShared();
+    BuildDrawLists(plan, projMat, viewport);
+}
+
+int PortalFramePlanner::IndexScene(MeshObjList *scene)
+{
+    for (int i = 0; i < numScenes; i++)
+        if (sceneIndex[i].scene == scene)
+            return i;
+
+    if (numScenes == (int) sceneIndex.size())
+        sceneIndex.push_back(SceneIndex());
+    SceneIndex &index = sceneIndex[numScenes];
+    index.scene = scene;
+    index.objects.assign(scene->begin(), scene->end());
+    index.portals.clear();
+    for (size_t i = 0; i < index.objects.size(); i++)
+    {
+        const PortalObject *portal = index.objects[i]->AsPortal();
+        if (portal != NULL && portal->destPortal != NULL)
+            index.portals.push_back((int) i);
+    }
+    return numScenes++;
+}
+
+/*
+ * BuildDrawLists() - Two rounds of tasks: culling slices of each view's
+ *   scene, then sorting each view's survivors into its draw list. Linked
+ *   portals above the recursion limit were dealt with by planning; the
+ *   ones it demoted join their view's list here.
+ */
+void PortalFramePlanner::BuildDrawLists(PortalFramePlan &plan,
+        const glm::mat4 &projMat, const ScissorRect &viewport)
+{
+    double start = mishii_Seconds();
+
+    int numViews = (int) plan.views.size();
+    firstTask.resize(numViews + 1);
+    int numTasks = 0;
+    for (int vi = 0; vi < numViews; vi++)
+    {
+        firstTask[vi] = numTasks;
+        int n = (int) sceneIndex[viewScene[vi]].objects.size();
+        numTasks += std::max(1, (n + CULL_TASK_OBJECTS - 1) / CULL_TASK_OBJECTS);
+    }
+    firstTask[numViews] = numTasks;
+
+    if ((int) cullTasks.size() < numTasks)
+        cullTasks.resize(numTasks);
+    for (int vi = 0; vi < numViews; vi++)
+    {
+        int n = (int) sceneIndex[viewScene[vi]].objects.size();
+        for (int t = firstTask[vi]; t < firstTask[vi+1]; t++)
+        {
+            CullTask &task = cullTasks[t];
+            task.view = vi;
+            task.begin = (t - firstTask[vi]) * CULL_TASK_OBJECTS;
+            task.end = std::min(n, task.begin + CULL_TASK_OBJECTS);
+        }
+    }
+
+    scheduler->Run(numTasks, [&](int t, int thread)
+        { CullObjects(plan, cullTasks[t], projMat, viewport); });
+    scheduler->Run(numViews, [&](int vi, int thread)
+        { SortDrawList(plan, vi); });
+
+    plan.numObjectsCulled = 0;
+    for (int t = 0; t < numTasks; t++)
+        plan.numObjectsCulled += cullTasks[t].numCulled;
+    plan.numCommands = 0;
+    for (int vi = 0; vi < numViews; vi++)
+        plan.numCommands += (int) plan.views[vi].commands.size();
+
+    buildSeconds = mishii_Seconds() - start;
+}
+
+/*
+ * CullObjects() - A multi-view plan's scissor rectangles are the shared
+ *   camera's, which may miss what an eye sees past a portal's edge, so an
+ *   object is only culled if every eye's own rectangle misses it.
+ */
+void PortalFramePlanner::CullObjects(const PortalFramePlan &plan, CullTask &task,
+        const glm::mat4 &projMat, const ScissorRect &viewport) const
+{
+    const PortalView &view = plan.views[task.view];
+    const SceneIndex &index = sceneIndex[viewScene[task.view]];
+    bool planned = view.depth < MAX_PORTAL_RECURSION_DEPTH;
+    int numEyes = (int) plan.eyes.size();
+
+    task.shown.clear();
+    task.numCulled = 0;
+    for (int i = task.begin; i < task.end; i++)
+    {
+        const MeshObject *obj = index.objects[i];
+        if (obj == view.skipPortal)
+            continue;
+        const PortalObject *portal = obj->AsPortal();
+        if (planned && portal != NULL && portal->destPortal != NULL)
+            continue;
+
+        bool visible = false;
+        if (numEyes == 0)
+            visible = !ProjectBounds(*obj, view.viewMat, projMat, viewport,
+                    view.scissor).Empty();
+        for (int e = 0; e < numEyes && !visible; e++)
+        {
+            const PortalEye &eye = plan.eyes[e];
+            visible = !ProjectBounds(*obj, eye.viewMats[task.view], eye.camera.projMat,
+                    eye.camera.viewport, eye.scissors[task.view]).Empty();
+        }
+
+        if (visible)
+            task.shown.push_back(i);
+        else
+            task.numCulled++;
+    }
+}
+
+void PortalFramePlanner::SortDrawList(PortalFramePlan &plan, int vi)
+{
+    PortalView &view = plan.views[vi];
+    const SceneIndex &index = sceneIndex[viewScene[vi]];
+
+    std::vector<int> &shown = cullTasks[firstTask[vi]].shown;
+    for (int t = firstTask[vi] + 1; t < firstTask[vi+1]; t++)
+        shown.insert(shown.end(), cullTasks[t].shown.begin(), cullTasks[t].shown.end());
+    std::vector<std::pair<int, int> >::const_iterator d = std::lower_bound(
+            demoted.begin(), demoted.end(), std::make_pair(vi, -1));
+    for ( ; d != demoted.end() && d->first == vi; ++d)
+        shown.push_back(d->second);
+
+    MeshOrder order;
+    order.objects = &index.objects;
+    std::sort(shown.begin(), shown.end(), order);
+
+    int n = (int) shown.size();
+    view.drawList.resize(n);
+    view.modelViews.resize(n);
+    view.commands.clear();
+    for (int k = 0; k < n; k++)
+    {
+        const MeshObject *obj = index.objects[shown[k]];
+        view.drawList[k] = obj;
+        view.modelViews[k] = view.viewMat * obj->modelMat;
+        if (k == 0 || obj->mesh != view.drawList[k-1]->mesh)
+        {
+            DrawCommand cmd = { obj->mesh, k, 0 };
+            view.commands.push_back(cmd);
+        }
+        view.commands.back().count++;
+    }
+}
+
+bool PortalFramePlanner::Reproject(PortalFramePlan &plan, const glm::mat4 &viewMat,
+        const glm::mat4 &projMat, const ScissorRect &viewport)
+{
+    if (!CanReproject(plan))
+        return false;
+
+    // Parents come before their children.
+    plan.views[0].viewMat = viewMat;
+    plan.views[0].scissor = viewport;
+    for (size_t vi = 1; vi < plan.views.size(); vi++)
+    {
+        PortalView &view = plan.views[vi];
+        const PortalView &parent = plan.views[view.parent];
+        view.viewMat = viewMat * view.chainMat;
+        view.scissor = ProjectBounds(*view.portal, parent.viewMat, projMat,
+                viewport, parent.scissor);
+        if (view.resolutionScale < 1.0f)
+            view.resolutionScale = view.scissor.Empty() ? 1.0f
+                : ResolutionScale(view.depth, view.scissor, viewQuality);
+    }
+    BuildDrawLists(plan, projMat, viewport);
+    return true;
+}
+
+ScissorRect PortalFramePlanner::ProjectBounds(const MeshObject &obj,
+        const glm::mat4 &viewMat, const glm::mat4 &projMat,
+        const ScissorRect &viewport, const ScissorRect &clip)
+{
+    if (obj.mesh == NULL || !obj.mesh->hasBounds)
+        return clip;
+
+    glm::mat4 mvp = projMat * viewMat * obj.modelMat;
+    const glm::vec3 &b0 = obj.mesh->boundsMin;
+    const glm::vec3 &b1 = obj.mesh->boundsMax;
+
+    float xmin = 1e30f, ymin = 1e30f, xmax = -1e30f, ymax = -1e30f;
+    for (int corner = 0; corner < 8; corner++)
+    {
+        glm::vec4 p(corner & 1 ? b1.x : b0.x,
+                    corner & 2 ? b1.y : b0.y,
+                    corner & 4 ? b1.z : b0.z, 1.0f);
+        glm::vec4 c = mvp * p;
+        if (c.w <= 1e-6f)
+            return clip;  // Crosses the eye plane; be conservative.
+        float x = c.x / c.w;
+        float y = c.y / c.w;
+        xmin = std::min(xmin, x);  xmax = std::max(xmax, x);
+        ymin = std::min(ymin, y);  ymax = std::max(ymax, y);
+    }
+
+    // NDC to window coordinates.
+    float sx = 0.5f * viewport.width, sy = 0.5f * viewport.height;
+    int x0 = (int) std::floor(viewport.x + (xmin + 1.0f) * sx);
+    int y0 = (int) std::floor(viewport.y + (ymin + 1.0f) * sy);
+    int x1 = (int) std::ceil(viewport.x + (xmax + 1.0f) * sx);
+    int y1 = (int) std::ceil(viewport.y + (ymax + 1.0f) * sy);
+
+    return ScissorRect(x0, y0, x1 - x0, y1 - y0).Intersect(clip);
+}
+
+float PortalFramePlanner::ResolutionScale(int depth, const ScissorRect &rect,
+        float quality)
+{
+    float scale = std::max(MIN_RESOLUTION_SCALE, std::pow(quality, (float) depth));
+    float pixels = (float) rect.width * rect.height;
+    if (pixels * scale * scale < MIN_SCALED_PIXELS)
+        scale = std::sqrt(MIN_SCALED_PIXELS / pixels);
+    return std::min(1.0f, scale);
+}
+
+bool PortalFramePlanner::FacesViewer(const glm::mat4 &invModelMat,
+        const glm::vec4 *eyes, int numEyes)
+{
+    // An eye, in portal model space, must be on the +Z side.
+    for (int e = 0; e < numEyes; e++)
+        if ((invModelMat * eyes[e]).z > 0.0f)
+            return true;
+    return false;
+}
+
+
+/* --------------------------------------------------------------------
+ * PortalFrameRenderer members.
+ * --------------------------------------------------------------------
+ */
+
+PortalFrameRenderer::PortalFrameRenderer()
+        : fillSamples(0), nestedPixels(0), savedPixels(0),
+          hook(NULL), resources(NULL), scaledTarget(NULL), scaleViews(false), depthFunc(GL_LESS),
+          eye(-1), countFill(false), numQueries(0)
+{
+}
+
+PortalFrameRenderer::~PortalFrameRenderer()
+{
+    delete scaledTarget;
+    if (!queries.empty())
+        glDeleteQueries((GLsizei) queries.size(), &queries[0]);
+}
+
+void PortalFrameRenderer::Render(const PortalFramePlan &plan)
+{
+    BeginRender(plan);
+    for (int level = 0; level < plan.NumLevels(); level++)
+        RenderLevel(plan, level);
+    EndRender(plan);
+}
+
+void PortalFrameRenderer::BeginRender(const PortalFramePlan &plan)
+{
+    fillSamples = 0;
+    nestedPixels = 0;
+    savedPixels = 0;
+    numQueries = 0;
+
+    glGetIntegerv(GL_DEPTH_FUNC, &depthFunc);
+
+    scaleViews = false;
+    if (plan.numScaled > 0 && resources != NULL)
+    {
+        if (scaledTarget == NULL)
+            scaledTarget = new ScaledViewTarget(*resources);
+        scaleViews = scaledTarget->Available();  // Else all at full resolution.
+    }
+
+    if (!plan.eyes.empty())
+    {
+        glGetIntegerv(GL_VIEWPORT, prevViewport);
+        glMatrixMode(GL_PROJECTION);
+        glPushMatrix();
+    }
+
+    glMatrixMode(GL_MODELVIEW);
+    glPushMatrix();
+    glEnable(GL_SCISSOR_TEST);
+    eye = -1;
+}
+
+/*
+ * RenderLevel() - One recursion level, for each eye in turn. Eyes draw
+ *   into disjoint viewports, so their passes need no ordering beyond the
+ *   levels'.
+ */
+void PortalFrameRenderer::RenderLevel(const PortalFramePlan &plan, int level)
+{
+    int numEyes = (int) plan.eyes.size();
+    for (int e = 0; e < std::max(numEyes, 1); e++)
+    {
+        if (numEyes > 0)
+            BeginEye(plan, e);
+        if (level > 0)
+        {
+            ResetLevel(plan, level);
+            glDepthFunc(depthFunc);
+        }
+        DrawLevel(plan, level);
+        if (level + 1 < plan.NumLevels())
+            MarkLevel(plan, level);
+    }
+}
+
+void PortalFrameRenderer::EndRender(const PortalFramePlan &plan)
+{
+    glDisable(GL_SCISSOR_TEST);
+    glPopMatrix();
+
+    if (!plan.eyes.empty())
+    {
+        eye = -1;
+        glMatrixMode(GL_PROJECTION);
+        glPopMatrix();
+        glMatrixMode(GL_MODELVIEW);
+        glViewport(prevViewport[0], prevViewport[1], prevViewport[2], prevViewport[3]);
+        if (hook != NULL)
+            hook->SetProjection(projMat, viewport);
+    }
+
+    // Back to defaults.
+    glStencilFunc(GL_EQUAL, plan.views[0].stencilRef, 0xFF);
+
+    for (int q = 0; q < numQueries; q++)
+    {
+        GLuint samples;
+        glGetQueryObjectuiv(queries[q], GL_QUERY_RESULT, &samples);
+        fillSamples += samples;
+    }
+}
+
+/*
+ * ResetLevel() - Clears color and depth inside every view of a level,
+ *   so that each scene behind a portal starts from an empty background.
+ */
+void PortalFrameRenderer::ResetLevel(const PortalFramePlan &plan, int level)
+{
+    glStencilMask(0x0);
+    glDepthFunc(GL_ALWAYS);
+    glDepthRange(1.0, 1.0);         // Far plane.
+    glBlendFunc(GL_ZERO, GL_ZERO);  // Paints a literal silhouette into the color buffer.
+
+    for (int vi = plan.LevelBegin(level); vi < plan.LevelEnd(level); vi++)
+    {
+        const PortalView &view = plan.views[vi];
+        if (Scaled(view) || Scissor(plan, vi).Empty())
+            continue;  // A scaled view's composite covers the silhouette instead.
+        SetScissor(Scissor(plan, vi));
+        glStencilFunc(GL_EQUAL, view.stencilRef, 0xFF);
+        glLoadMatrixf(glm::value_ptr(ViewMat(plan, view.parent)));
+        view.portal->Draw();
+    }
+
+    // Back to defaults (depth func is restored by the caller).
+    glBlendFunc(GL_ONE, GL_ZERO);
+    glDepthRange(0.0, 1.0);
+}
+
+/*
+ * DrawLevel() - Draws the scene content of every view of a level.
+ */
+void PortalFrameRenderer::DrawLevel(const PortalFramePlan &plan, int level)
+{
+    glStencilMask(0x0);
+    BeginCount();
+    if (hook != NULL)
+        hook->BeginDrawLevel(level);
+
+    bool anyScaled = false;
+    for (int vi = plan.LevelBegin(level); vi < plan.LevelEnd(level); vi++)
+    {
+        const PortalView &view = plan.views[vi];
+        if (Scaled(view))
+        {
+            anyScaled = true;
+            continue;
+        }
+        const ScissorRect &scissor = Scissor(plan, vi);
+        if (scissor.Empty())
+            continue;
+        if (level > 0)
+            nestedPixels += (long) scissor.width * scissor.height;
+        SetScissor(scissor);
+        glStencilFunc(GL_EQUAL, view.stencilRef, 0xFF);
+        glLoadMatrixf(glm::value_ptr(ViewMat(plan, vi)));
+        if (hook != NULL)
+            hook->BeginDrawView(view, ViewMat(plan, vi));
+        DrawContent(view);
+    }
+
+    if (hook != NULL)
+        hook->EndDrawLevel(level);
+    EndCount();
+
+    if (anyScaled)
+        DrawScaledViews(plan, level);
+}
+
+/*
+ * DrawScaledViews() - Draws the level's scaled views into one offscreen
+ *   atlas, then composites each over its portal silhouette in place of
+ *   ResetLevel(). The hook is given each view's offscreen projection.
+ */
+void PortalFrameRenderer::DrawScaledViews(const PortalFramePlan &plan, int level)
+{
+    scaledViews.clear();
+    scaledTarget->BeginBatch(projMat, viewport);
+    for (int vi = plan.LevelBegin(level); vi < plan.LevelEnd(level); vi++)
+        if (Scaled(plan.views[vi]))
+        {
+            const PortalView &view = plan.views[vi];
+            scaledTarget->AddSlot(view.scissor, view.resolutionScale);
+            scaledViews.push_back(vi);
+        }
+    scaledTarget->Bind();
+
+    for (size_t s = 0; s < scaledViews.size(); s++)
+    {
+        const PortalView &view = plan.views[scaledViews[s]];
+        glm::mat4 subProj;
+        ScissorRect subViewport;
+        scaledTarget->BeginSlot((int) s, subProj, subViewport);
+
+        long drawn = (long) subViewport.width * subViewport.height;
+        nestedPixels += drawn;
+        savedPixels += (long) view.scissor.width * view.scissor.height - drawn;
+
+        if (hook != NULL)
+            hook->SetProjection(subProj, subViewport);
+        DrawView(view, level);
+    }
+    if (hook != NULL)
+        hook->SetProjection(projMat, viewport);
+    scaledTarget->Unbind();
+
+    // As in ResetLevel(), but with the view's color and depth.
+    glDepthFunc(GL_ALWAYS);
+    for (size_t s = 0; s < scaledViews.size(); s++)
+    {
+        const PortalView &view = plan.views[scaledViews[s]];
+        SetScissor(view.scissor);
+        glStencilFunc(GL_EQUAL, view.stencilRef, 0xFF);
+        glLoadMatrixf(glm::value_ptr(plan.views[view.parent].viewMat));
+        scaledTarget->BeginComposite((int) s);
+        view.portal->Draw();
+    }
+    scaledTarget->EndComposite();
+    glDepthFunc(depthFunc);
+}
+
+/*
+ * DrawView() - One view's content as its own pass, for DrawScaledViews().
+ */
+void PortalFrameRenderer::DrawView(const PortalView &view, int level)
+{
+    BeginCount();
+    if (hook != NULL)
+        hook->BeginDrawLevel(level);
+    glLoadMatrixf(glm::value_ptr(view.viewMat));
+    if (hook != NULL)
+        hook->BeginDrawView(view, view.viewMat);
+    DrawContent(view);
+    if (hook != NULL)
+        hook->EndDrawLevel(level);
+    EndCount();
+}
+
+/*
+ * DrawContent() - Replays a view's draw commands with the modelviews the
+ *   planner computed. An eye of a multi-view plan has its own, so there
+ *   each object multiplies onto the eye's view matrix, as loaded.
+ */
+void PortalFrameRenderer::DrawContent(const PortalView &view)
+{
+    if (eye >= 0)
+    {
+        for (size_t i = 0; i < view.drawList.size(); i++)
+            view.drawList[i]->Draw();
+        return;
+    }
+
+    for (size_t c = 0; c < view.commands.size(); c++)
+    {
+        const DrawCommand &cmd = view.commands[c];
+        for (int i = cmd.first; i < cmd.first + cmd.count; i++)
+        {
+            glLoadMatrixf(glm::value_ptr(view.modelViews[i]));
+            cmd.mesh->Draw();
+        }
+    }
+}
+
+/*
+ * BeginEye() - Moves drawing to eye e's viewport and projection.
+ */
+void PortalFrameRenderer::BeginEye(const PortalFramePlan &plan, int e)
+{
+    const EyeCamera &camera = plan.eyes[e].camera;
+    eye = e;
+    glViewport(camera.viewport.x, camera.viewport.y,
+            camera.viewport.width, camera.viewport.height);
+    glMatrixMode(GL_PROJECTION);
+    glLoadMatrixf(glm::value_ptr(camera.projMat));
+    glMatrixMode(GL_MODELVIEW);
+    if (hook != NULL)
+        hook->SetProjection(camera.projMat, camera.viewport);
+}
+
+/*
+ * MarkLevel() - Writes the stencil values of the next level's views,
+ *   using the portal silhouettes as seen from this level.
+ */
+void PortalFrameRenderer::MarkLevel(const PortalFramePlan &plan, int level)
+{
+    glDepthMask(GL_FALSE);                                // The portal surface is not physical.
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);  // Color is reset in ResetLevel().
+    glStencilOp(GL_KEEP, GL_KEEP, GL_INVERT);             // parent ^ (parent ^ child) == child.
+
+    for (int vi = plan.LevelBegin(level); vi < plan.LevelEnd(level); vi++)
+    {
+        const PortalView &view = plan.views[vi];
+        if (view.children.empty())
+            continue;
+        glLoadMatrixf(glm::value_ptr(ViewMat(plan, vi)));
+        glStencilFunc(GL_EQUAL, view.stencilRef, 0xFF);
+        for (size_t c = 0; c < view.children.size(); c++)
+        {
+            const PortalView &child = plan.views[view.children[c]];
+            const ScissorRect &scissor = Scissor(plan, view.children[c]);
+            if (scissor.Empty())
+                continue;
+            SetScissor(scissor);
+            glStencilMask(view.stencilRef ^ child.stencilRef);
+            child.portal->Draw();
+        }
+    }
+
+    // Back to defaults.
+    glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
+    glStencilMask(0x0);
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    glDepthMask(GL_TRUE);
+}
+
+/*
+ * BeginCount(), EndCount() - Bracket a content pass with a sample query.
+ */
+void PortalFrameRenderer::BeginCount()
+{
+    if (!countFill)
+        return;
+    if (numQueries == (int) queries.size())
+    {
+        GLuint q;
+        glGenQueries(1, &q);
+        queries.push_back(q);
+    }
+    glBeginQuery(GL_SAMPLES_PASSED, queries[numQueries]);
+}
+
+void PortalFrameRenderer::EndCount()
+{
+    if (!countFill)
+        return;
+    glEndQuery(GL_SAMPLES_PASSED);
+    numQueries++;
+}
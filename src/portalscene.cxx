@@ -0,0 +1,936 @@
+/* =============================================================================
+ * portalscene.cxx
+ * Masado Ishii
+ * v0.1 2016-12-26
+ * v0.2 2017-08-04 - New scene content.
+ * v0.3 2026-10-19 - Split out of scenemapper.cxx; no longer depends on VTK.
+ *
+ * Description: Definitions of scene and animations, and the per-frame GL
+ *   setup for drawing them.
+ *
+ * Attributions:
+ *   > Modeled on code by Hank Childs, presumably derivative
+ *     of Kitware coders K.Martin, W.Schroeder, and B.Lorensen.
+ * =============================================================================
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+
+#include "../include/portalscene.h"
+#include "../include/camera.h"  // Default camera for benchmarks.
+
+
+/* --------------------------------------------------------------------
+ * PortalScene member functions.
+ * --------------------------------------------------------------------
+ */
+
+/*
+ * Destructor.
+ */
+PortalScene::~PortalScene()
+{
+    ClearScene();
+    for (std::list<PolygonMesh *>::iterator iter = meshes.begin();
+            iter != meshes.end();
+            ++iter)
+        delete *iter;
+}
+
+/*
+ * SetupLight()
+ */
+void PortalScene::SetupLight(void)
+{
+    glEnable(GL_LIGHTING);
+    glEnable(GL_LIGHT0);
+    GLfloat diffuse0[4] = { 0.8, 0.8, 0.8, 1 };
+    GLfloat ambient0[4] = { 0.2, 0.2, 0.2, 1 };
+    GLfloat specular0[4] = { 0.0, 0.0, 0.0, 1 };
+    GLfloat pos0[4] = { 1, 2, 3, 0 };
+    glLightfv(GL_LIGHT0, GL_POSITION, pos0);
+    glLightfv(GL_LIGHT0, GL_DIFFUSE, diffuse0);
+    glLightfv(GL_LIGHT0, GL_AMBIENT, ambient0);
+    glLightfv(GL_LIGHT0, GL_SPECULAR, specular0);
+    glDisable(GL_LIGHT1);
+    glDisable(GL_LIGHT2);
+    glDisable(GL_LIGHT3);
+    glDisable(GL_LIGHT5);
+    glDisable(GL_LIGHT6);
+    glDisable(GL_LIGHT7);
+}
+
+/*
+ * InitializeScene()
+ */
+void PortalScene::InitializeScene()
+{
+    // Constants.
+    const float d45 = atan(1);  // PI/4.
+    const float d360 = 8*d45;   // 2*PI.
+
+    /* ----------------------------------------------------
+     * Meshes (model space).
+     * ----------------------------------------------------
+     */
+
+    // Built on the CPU; each mesh compiles its display list when first drawn.
+
+    //
+    // unitSquare: White square with vertices at (+-1, +-1, 0).
+    //
+    PolygonMesh *mesh_square = new PolygonMesh;
+    {
+        glm::vec3 white(1.0f, 1.0f, 1.0f);
+        mesh_square->AddQuad(
+                mesh_square->AddVertex(glm::vec3(1, 1, 0), white),
+                mesh_square->AddVertex(glm::vec3(-1, 1, 0), white),
+                mesh_square->AddVertex(glm::vec3(-1, -1, 0), white),
+                mesh_square->AddVertex(glm::vec3(1, -1, 0), white));
+    }
+
+    //
+    // windowFrame: Gray frame around unitSquare, width = 0.1.
+    //
+    float w = 0.1f;
+        /* Corner coordinates in quadrants 1, 2, 3, 4, 1. */
+    float wfInnerX[5] = {1.0f, -1.0f, -1.0f, 1.0f, 1.0f};
+    float wfInnerY[5] = {1.0f, 1.0f, -1.0f, -1.0f, 1.0f};
+    float wfOuterX[5] = {1.0f +w, -1.0f -w, -1.0f -w, 1.0f +w, 1.0f +w};
+    float wfOuterY[5] = {1.0f +w, 1.0f +w, -1.0f -w, -1.0f -w, 1.0f +w};
+    //
+    PolygonMesh *mesh_windowFrame = new PolygonMesh;
+    {
+        glm::vec3 gray(0.7f, 0.7f, 0.7f);
+        for (int q= 0; q< 4; q++)
+        {
+            /*     C --------------- B
+             *       \             /
+             *      D ------------- A
+             */
+            mesh_windowFrame->AddQuad(
+                    mesh_windowFrame->AddVertex(glm::vec3(wfInnerX[q], wfInnerY[q], 0.0f), gray),
+                    mesh_windowFrame->AddVertex(glm::vec3(wfOuterX[q], wfOuterY[q], 0.0f), gray),
+                    mesh_windowFrame->AddVertex(glm::vec3(wfOuterX[q+1], wfOuterY[q+1], 0.0f), gray),
+                    mesh_windowFrame->AddVertex(glm::vec3(wfInnerX[q+1], wfInnerY[q+1], 0.0f), gray));
+        }
+    }
+
+    //
+    // octahedron: Yellow and blue octahedron with vertices at +-i, +-j, +-k.
+    //
+    glm::vec3 octahedronRim[4] =    // CCW if looking down +X.
+    {
+        glm::vec3(0, -1, 0),
+        glm::vec3(0, 0, -1),
+        glm::vec3(0, 1, 0),
+        glm::vec3(0, 0, 1)
+    };
+    glm::vec3 octahedronFar(1, 0, 0);
+    glm::vec3 octahedronNear(-1, 0, 0);
+    //
+    PolygonMesh *mesh_octahedron = new PolygonMesh;
+    {
+        // +X (Far): Yellow
+        glm::vec3 yellow(0.8f, 0.8f, 0.0f);
+        for (int r = 0; r < 4; r++)
+            mesh_octahedron->AddTriangle(                                    // Order important if
+                    mesh_octahedron->AddVertex(octahedronRim[(r+3)%4], yellow),  // single-sided lighting.
+                    mesh_octahedron->AddVertex(octahedronRim[r], yellow),
+                    mesh_octahedron->AddVertex(octahedronFar, yellow));
+        // -X (Near): Blue
+        glm::vec3 blue(0.0f, 0.0f, 0.5f);
+        for (int r = 0; r < 4; r++)
+            mesh_octahedron->AddTriangle(
+                    mesh_octahedron->AddVertex(octahedronNear, blue),
+                    mesh_octahedron->AddVertex(octahedronRim[r], blue),
+                    mesh_octahedron->AddVertex(octahedronRim[(r+3)%4], blue));
+    }
+    
+    //
+    // cone: Red right-cone with unit-circle base in XY, height=2*r in Z.
+    //
+    float cone_radius = 1;
+    float cone_height = 2;
+    int cone_num_subdiv = 8;
+    //
+    float cone_subdiv_angle = d360 / cone_num_subdiv;
+    PolygonMesh *mesh_cone = new PolygonMesh;
+    {
+        glm::vec3 red(0.6f, 0.1f, 0.1f);
+        GLuint apex = mesh_cone->AddVertex(glm::vec3(0.0f, 0.0f, cone_height), red);
+        GLuint first = mesh_cone->AddVertex(glm::vec3(cone_radius, 0.0f, 0.0f), red);
+        GLuint prev = first;
+        for (int i = 1; i < cone_num_subdiv; i++)         // All but last vertex.
+        {
+            GLuint v = mesh_cone->AddVertex(glm::vec3(cone_radius*cos(i*cone_subdiv_angle),
+                    cone_radius*sin(i*cone_subdiv_angle), 0.0f), red);
+            mesh_cone->AddTriangle(apex, prev, v);
+            prev = v;
+        }
+        mesh_cone->AddTriangle(apex, prev, first);        // Last vertex should be first vertex.
+    }
+
+    // Register all meshes.
+    mesh_square->ComputeBounds();
+    mesh_windowFrame->ComputeBounds();
+    mesh_octahedron->ComputeBounds();
+    mesh_cone->ComputeBounds();
+    meshes.push_back(mesh_square);
+    meshes.push_back(mesh_windowFrame);
+    meshes.push_back(mesh_octahedron);
+    meshes.push_back(mesh_cone);
+    for (std::list<PolygonMesh *>::iterator iter = meshes.begin();
+            iter != meshes.end();
+            ++iter)
+        (*iter)->SetResources(&resources);
+
+
+    squareMesh = mesh_square;
+    frameMesh = mesh_windowFrame;
+    octahedronMesh = mesh_octahedron;
+    coneMesh = mesh_cone;
+
+    if (!modelPath.empty())
+        LoadModel();
+
+    BuildScene();
+
+    // This function has done its job.
+    initialized = true;
+}
+
+/*
+ * LoadModel() - Imports the model's meshes and places it. Reports the
+ *   load on std::cout, as a line of its own.
+ */
+void PortalScene::LoadModel()
+{
+    ModelCache cache;
+    if (!cache.Load(modelPath, modelObjects))
+    {
+        std::cerr << "PortalScene: leaving out model " << modelPath << "." << std::endl;
+        return;
+    }
+
+    int numTriangles = 0;
+    glm::vec3 bmin = modelObjects[0].mesh->boundsMin, bmax = modelObjects[0].mesh->boundsMax;
+    for (size_t k = 0; k < modelObjects.size(); k++)
+    {
+        PolygonMesh *mesh = modelObjects[k].mesh;
+        mesh->SetResources(&resources);
+        meshes.push_back(mesh);
+        numTriangles += mesh->NumTriangles();
+        bmin = glm::min(bmin, mesh->boundsMin);
+        bmax = glm::max(bmax, mesh->boundsMax);
+    }
+
+    // Bottom center to the origin, +Y up to +Z up, then scaled and placed.
+    using namespace glm_mishii_matrix_transforms;
+    const float d90 = 2*atan(1);
+    glm::vec3 extent = bmax - bmin;
+    float size = std::max(extent.x, std::max(extent.y, extent.z));
+    float s = (size > 0.0f ? 4.0f / size : 1.0f);
+    modelTransform = translate(mat4(), vec3(-3.0f, -6.0f, 0.0f))
+            * scale(mat4(), vec3(s, s, s))
+            * rotate(mat4(), d90, vec3(1.0f, 0.0f, 0.0f))
+            * translate(mat4(), -vec3(0.5f*(bmin.x + bmax.x), bmin.y, 0.5f*(bmin.z + bmax.z)));
+
+    std::cout << "model: path=" << modelPath
+              << " source=" << (cache.source == ModelCache::CACHED ? "cache" : "parsed")
+              << " objects=" << modelObjects.size()
+              << " triangles=" << numTriangles
+              << " load_ms=" << 1e3 * cache.seconds
+              << " hash_ms=" << 1e3 * cache.hashSeconds << std::endl;
+}
+
+/*
+ * ClearScene()
+ */
+void PortalScene::ClearScene()
+{
+    for (std::list<MeshObject *>::iterator iter = meshObjects.begin();
+            iter != meshObjects.end();
+            ++iter)
+        delete *iter;
+    meshObjects.clear();
+    animationTarget = NULL;
+}
+
+/*
+ * BuildScene()
+ */
+void PortalScene::BuildScene()
+{
+    // Constants.
+    const float d45 = atan(1);  // PI/4.
+
+    ClearScene();
+
+    /* ----------------------------------------------------
+     * Scene (world space).
+     * ----------------------------------------------------
+     */
+
+    // Scene contains a ground plane, an octahedron, a cone, and framed portals:
+    //   two by default, or a grid of portalPairs pairs for stress testing.
+
+    // To make glm matrix expressions succinct.
+    using namespace glm_mishii_matrix_transforms;
+
+    // Ground.
+    MeshObject *mobj_ground = new MeshObject(squareMesh, scale(mat4(), vec3(20.0f, 20.0f, 1.0f)));
+
+    // Octahedron.
+    MeshObject *mobj_octahedron = new MeshObject(octahedronMesh,
+            translate(mat4(), vec3(-3.0f, 6.0f, 2.0f))
+            * scale(mat4(), vec3(2.0f, 2.0f, 2.0f)));
+
+    // Cone.
+    MeshObject *mobj_cone = new MeshObject(coneMesh,
+            translate(mat4(), vec3(3.0f, -6.0f, 0.0f))
+            * scale(mat4(), vec3(2.0f, 2.0f, 2.0f)));
+
+    // Register the props.
+    meshObjects.push_back(mobj_ground);
+    meshObjects.push_back(mobj_octahedron);
+    meshObjects.push_back(mobj_cone);
+
+    // Imported model, if any.
+    for (size_t k = 0; k < modelObjects.size(); k++)
+        meshObjects.push_back(new MeshObject(modelObjects[k].mesh, modelTransform));
+
+    if (portalPairs > 0)
+        AddPortalGrid(portalPairs);
+    else
+    {
+        //
+        // Portals & frames.
+        //
+        mat4 Transform1 = translate(mat4(), vec3(-9.0f, 6.0f, 4.0f))
+                * rotate(mat4(), 2*d45, vec3(0.0f, 1.0f, 0.0f))
+                * scale(mat4(), vec3(4.0f, 4.0f, 1.0f));
+        mat4 Transform2 = translate(mat4(), vec3(9.0f, -6.0f, 4.0f))
+                * rotate(mat4(), -2*d45, vec3(0.0f, 1.0f, 0.0f))
+                * scale(mat4(), vec3(4.0f, 4.0f, 1.0f));
+        AddPortalPair(Transform1, Transform2);
+    }
+
+    BuildLights();
+
+    // Feed the animator.
+    animationTarget = mobj_octahedron;
+}
+
+/*
+ * BuildLights() - numLights colored point lights scattered over the ground.
+ *   A fixed seed keeps runs comparable.
+ */
+void PortalScene::BuildLights()
+{
+    unsigned int seed = 441;
+    lights.resize(numLights);
+    for (int i = 0; i < numLights; i++)
+    {
+        float f[6];
+        for (int k = 0; k < 6; k++)
+        {
+            seed = seed * 1103515245u + 12345u;
+            f[k] = ((seed >> 8) & 0xFFFF) / 65535.0f;
+        }
+        lights[i].position = glm::vec3(40.0f*f[0] - 20.0f, 40.0f*f[1] - 20.0f, 0.5f + 5.5f*f[2]);
+        lights[i].radius = 3.0f + 3.0f*f[3];
+        lights[i].color = glm::vec3(f[4], f[5], 1.0f - 0.5f*(f[4] + f[5]));
+    }
+}
+
+/*
+ * AddPortalPair() - Two linked portals, each with a frame.
+ */
+void PortalScene::AddPortalPair(const glm::mat4 &transform1,
+        const glm::mat4 &transform2)
+{
+    // Portals.
+    PortalObject *mobj_portal1 = new PortalObject(squareMesh, &meshObjects,
+            NULL, transform1);
+    PortalObject *mobj_portal2 = new PortalObject(squareMesh, &meshObjects,
+            NULL, transform2);
+    bool linked1 = mobj_portal1->SetDestPortal(mobj_portal2);
+    bool linked2 = mobj_portal2->SetDestPortal(mobj_portal1);
+    assert( linked1 && linked2 );  // Not inside assert(): NDEBUG would drop the calls.
+    (void) linked1;
+    (void) linked2;
+
+    // Frames around portals.
+    MeshObject* mobj_frame1 = new MeshObject(frameMesh, transform1);
+    MeshObject* mobj_frame2 = new MeshObject(frameMesh, transform2);
+
+    // Register all objects in the scene.
+    meshObjects.push_back(mobj_portal1);
+    meshObjects.push_back(mobj_portal2);
+    meshObjects.push_back(mobj_frame1);
+    meshObjects.push_back(mobj_frame2);
+}
+
+/*
+ * AddPortalGrid() - Stress scene: numPairs portal pairs on a grid over the
+ *   ground, tilted toward the default camera. Portal i links to portal
+ *   i + numPairs, so links cross the scene.
+ */
+void PortalScene::AddPortalGrid(int numPairs)
+{
+    using namespace glm_mishii_matrix_transforms;
+    const float d45 = atan(1);
+
+    int numPortals = 2*numPairs;
+    int cols = (int) ceil(sqrt((float) numPortals));
+    float spacing = 36.0f / cols;
+    float size = 0.35f * spacing;
+
+    std::vector<mat4> transforms(numPortals);
+    for (int i = 0; i < numPortals; i++)
+    {
+        float x = -18.0f + spacing * (i % cols + 0.5f);
+        float y = -18.0f + spacing * (i / cols + 0.5f);
+        transforms[i] = translate(mat4(), vec3(x, y, size))
+                * rotate(mat4(), -d45, vec3(1.0f, 0.0f, 0.0f))
+                * scale(mat4(), vec3(size, size, 1.0f));
+    }
+    for (int i = 0; i < numPairs; i++)
+        AddPortalPair(transforms[i], transforms[i + numPairs]);
+}
+
+/*
+ * RenderFrame() - Plans the portal views, then draws the frame as a
+ *   graph of passes: the clear, one pass per recursion level, and the
+ *   capture and counters when on. The levels' GL state is set up once for
+ *   all of them (PortalFrameRenderer::BeginRender()).
+ */
+void PortalScene::RenderFrame(const glm::mat4 &cameraViewMat, const glm::mat4 &projMat,
+        const ScissorRect &viewportRect)
+{
+    glm::mat4 viewMat = cameraViewMat;
+    LatchPose(viewMat);
+
+    PrepareFrame();
+
+    // Plan all portal views for this frame from the camera.
+    GLint stencilBits;
+    glGetIntegerv(GL_STENCIL_BITS, &stencilBits);
+
+    framePlanner.SetStencilBits(stencilBits);
+    double planStart = mishii_Seconds();
+    if (eyeSeparation > 0.0f)
+    {
+        BuildEyeCameras(viewMat, projMat, viewportRect);
+        framePlanner.PlanMultiView(meshObjects, eyeCameras, framePlan);
+    }
+    else
+    {
+        eyeCameras.clear();
+        framePlanner.Plan(meshObjects, viewMat, projMat, viewportRect, framePlan);
+    }
+    double planSeconds = mishii_Seconds() - planStart;
+
+    // Input that came in while planning still makes this frame.
+    if (latchMode == LATCH_VIEW && PortalFramePlanner::CanReproject(framePlan))
+    {
+        glm::mat4 lateViewMat = viewMat;
+        if (LatchPose(lateViewMat))
+        {
+            viewMat = lateViewMat;
+            framePlanner.Reproject(framePlan, viewMat, projMat, viewportRect);
+            if (stats.Enabled())
+                stats.Count("relatched", 1);
+        }
+    }
+
+    lastViewMat = viewMat;
+    lastProjMat = projMat;
+    lastViewport = viewportRect;
+
+    // "frame" is the framebuffer drawn into, "camera" the matrices and
+    //   light loaded into the GL, "lights" the point lights' hook.
+    frameGraph.Clear();
+    FrameGraph::Resource frame = frameGraph.AddResource("frame");
+    FrameGraph::Resource camera = frameGraph.AddResource("camera");
+    FrameGraph::Resource lightHook = frameGraph.AddResource("lights");
+    frameGraph.SetOutput(frame);
+
+    int pass = frameGraph.AddPass("clear", [&] { ClearFrame(viewMat, projMat, viewportRect); });
+    frameGraph.Writes(pass, frame);
+    frameGraph.Writes(pass, camera);
+
+    pass = frameGraph.AddPass("lights", [&]
+    {
+        // Point lights replace the fixed-function light in each view's content pass.
+        if (numLights > 0)
+        {
+            lighting.SetLights(&lights);
+            lighting.SetProjection(projMat, viewportRect);
+            lighting.ResetCounters();
+            frameRenderer.SetHook(&lighting);
+        }
+        else
+            frameRenderer.SetHook(NULL);
+    });
+    frameGraph.Writes(pass, lightHook);
+
+    int levels = frameGraph.AddStateGroup("portals",
+            [&]
+            {
+                frameRenderer.SetProjection(projMat, viewportRect);
+                frameRenderer.SetCountFill(stats.Enabled());
+                frameRenderer.BeginRender(framePlan);
+            },
+            [&] { frameRenderer.EndRender(framePlan); });
+    char name[32];
+    for (int level = 0; level < framePlan.NumLevels(); level++)
+    {
+        snprintf(name, sizeof name, "level %d", level);
+        pass = frameGraph.AddPass(name, [this, level] { frameRenderer.RenderLevel(framePlan, level); },
+                levels);
+        frameGraph.Reads(pass, camera);
+        frameGraph.Reads(pass, lightHook);
+        frameGraph.Reads(pass, frame);
+        frameGraph.Writes(pass, frame);
+
+        // Scaled views are drawn into an offscreen atlas and composited
+        //   within the level, so the levels' atlases share one target.
+        for (int vi = framePlan.LevelBegin(level); vi < framePlan.LevelEnd(level); vi++)
+            if (framePlan.views[vi].resolutionScale < 1.0f)
+            {
+                snprintf(name, sizeof name, "atlas%d", level);
+                FrameGraph::Resource atlas = frameGraph.AddResource(name, true);
+                frameGraph.Writes(pass, atlas);
+                frameGraph.Reads(pass, atlas);
+                break;
+            }
+    }
+
+    if (capture != NULL)
+    {
+        FrameGraph::Resource recorded = frameGraph.AddResource("capture");
+        frameGraph.SetOutput(recorded);
+        pass = frameGraph.AddPass("capture", [&] { capture->Capture(viewportRect); });
+        frameGraph.Reads(pass, frame);
+        frameGraph.Writes(pass, recorded);
+    }
+
+    frameGraph.Compile();
+    frameGraph.Execute();
+
+    if (stats.Enabled())
+    {
+        glFinish();  // Charge the GPU work to this frame.
+        stats.Count("plan_ms", 1e3 * planSeconds);
+        stats.Count("scaled", framePlan.numScaled);
+        stats.Count("fill_kpx", 1e-3 * frameRenderer.fillSamples);
+        stats.Count("nested_kpx", 1e-3 * frameRenderer.nestedPixels);
+        stats.Count("saved_kpx", 1e-3 * frameRenderer.savedPixels);
+    }
+    FinishFrame();
+}
+
+/*
+ * ClearFrame() - Loads the camera and the frame's GL state, and clears
+ *   the viewport.
+ */
+void PortalScene::ClearFrame(const glm::mat4 &viewMat, const glm::mat4 &projMat,
+        const ScissorRect &viewportRect)
+{
+    glViewport(viewportRect.x, viewportRect.y, viewportRect.width, viewportRect.height);
+    glMatrixMode(GL_PROJECTION);
+    glLoadMatrixf(glm::value_ptr(projMat));
+    glMatrixMode(GL_MODELVIEW);
+    glLoadMatrixf(glm::value_ptr(viewMat));
+
+    SetupLight();
+
+    glEnable(GL_COLOR_MATERIAL);
+    glEnable(GL_CULL_FACE);  // This is not the correct way to implement single-sided portals.
+                             // Single-sided portals should be configured using glStencilOpSeparate().
+    glEnable(GL_STENCIL_TEST);  // Needed for portal boundaries.
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_BLEND);  // Needed to empty portal viewport background.
+
+    // Initialize the stencil buffer. 0 marks the outermost level of portal recursion.
+    // Also initialize the color buffer to black.
+    glClearStencil(0);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    //glClear(GL_STENCIL_BUFFER_BIT);
+    glStencilMask(0xFF);  // The last frame left the stencil read-only, which would mask the clear.
+    glEnable(GL_SCISSOR_TEST);  // Only the viewport: tile renderers draw into part of a larger buffer.
+    glScissor(viewportRect.x, viewportRect.y, viewportRect.width, viewportRect.height);
+    glClear(GL_COLOR_BUFFER_BIT | GL_STENCIL_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    glDisable(GL_SCISSOR_TEST);
+
+    // Initialize the stencil test.
+    glStencilFunc(GL_EQUAL, 0, 0xFF);           // Outermost ref value.
+    glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);  // Default update action.
+    glStencilMask(0x0);                         // By default, read-only.
+}
+
+/*
+ * RenderFrameSoftware()
+ */
+void PortalScene::RenderFrameSoftware(const glm::mat4 &cameraViewMat, const glm::mat4 &projMat,
+        const ScissorRect &viewportRect, SoftRasterizer &raster, SoftFramebuffer &fb)
+{
+    glm::mat4 viewMat = cameraViewMat;
+    LatchPose(viewMat);
+
+    eyeCameras.clear();
+
+    PrepareFrame();
+
+    framePlanner.SetStencilBits(StencilAllocator::MAX_STENCIL_BITS);
+    framePlanner.Plan(meshObjects, viewMat, projMat, viewportRect, framePlan);
+    if (latchMode == LATCH_VIEW && PortalFramePlanner::CanReproject(framePlan))
+    {
+        glm::mat4 lateViewMat = viewMat;
+        if (LatchPose(lateViewMat))
+        {
+            viewMat = lateViewMat;
+            framePlanner.Reproject(framePlan, viewMat, projMat, viewportRect);
+            if (stats.Enabled())
+                stats.Count("relatched", 1);
+        }
+    }
+    lastViewMat = viewMat;
+    lastProjMat = projMat;
+    lastViewport = viewportRect;
+
+    // As set up by SetupLight(): light 0 at (1, 2, 3, 0), given under the
+    //   camera's modelview, plus the default global ambient of 0.2.
+    SoftLight light;
+    light.direction = glm::normalize(glm::mat3(viewMat) * glm::vec3(1.0f, 2.0f, 3.0f));
+    light.ambient = 0.2f + 0.2f;
+    light.diffuse = 0.8f;
+    raster.SetLight(light);
+    lighting.ResetCounters();  // Point lights are not drawn here.
+
+    fb.Clear(glm::vec4(0.0f), 1.0f, 0);
+    raster.Render(framePlan, projMat, viewportRect, fb);
+
+    if (capture != NULL)
+        capture->CapturePixels(fb.width, fb.height, fb.Pixels());
+
+    if (stats.Enabled())
+    {
+        stats.Count("tris", raster.numTriangles);
+        stats.Count("setup_ms", 1e3 * raster.setupSeconds);
+        stats.Count("raster_ms", 1e3 * raster.rasterSeconds);
+    }
+    FinishFrame();
+}
+
+/*
+ * BuildEyeCameras() - Left and right eyes of the camera viewMat, in the
+ *   left and right halves of viewport. The frusta are sheared to converge
+ *   halfway between the near and far planes, where there is no parallax.
+ */
+void PortalScene::BuildEyeCameras(const glm::mat4 &viewMat, const glm::mat4 &projMat,
+        const ScissorRect &viewport)
+{
+    float zNear = projMat[3][2] / (projMat[2][2] - 1.0f);
+    float zFar = projMat[3][2] / (projMat[2][2] + 1.0f);
+    float convergence = 0.5f * (zNear + zFar);
+
+    int leftWidth = viewport.width / 2;
+    eyeCameras.resize(2);
+    for (int e = 0; e < 2; e++)
+    {
+        float offset = (e == 0 ? -0.5f : 0.5f) * eyeSeparation;
+        EyeCamera &eye = eyeCameras[e];
+        eye.viewMat = glm::translate(glm::mat4(), glm::vec3(-offset, 0.0f, 0.0f)) * viewMat;
+        eye.projMat = projMat;
+        eye.projMat[0][0] *= 2.0f;  // Half the width, same vertical field.
+        eye.projMat[2][0] -= eye.projMat[0][0] * offset / convergence;
+        eye.viewport = (e == 0)
+            ? ScissorRect(viewport.x, viewport.y, leftWidth, viewport.height)
+            : ScissorRect(viewport.x + leftWidth, viewport.y,
+                    viewport.width - leftWidth, viewport.height);
+    }
+}
+
+/*
+ * LatchPose() - Replaces viewMat by the pose source's newest pose and
+ *   returns true, if the camera moved since the last latch.
+ */
+bool PortalScene::LatchPose(glm::mat4 &viewMat)
+{
+    if (poseSource == NULL || latchMode == LATCH_NONE)
+        return false;
+    double time;
+    if (!poseSource->LatchPose(viewMat, time))
+        return false;
+    NoteInput(time);
+    return true;
+}
+
+void PortalScene::NoteInput(double time)
+{
+    if (inputTime < 0.0 || time < inputTime)
+        inputTime = time;
+}
+
+void PortalScene::FramePresented(double poseTime)
+{
+    double now = mishii_Seconds();
+    if (stats.Enabled() && poseTime >= 0.0)
+        stats.Sample("pose_ms", 1e3 * (now - poseTime));
+    if (stats.Enabled() && inputTime >= 0.0)
+        stats.Sample("input_ms", 1e3 * (now - inputTime));
+    inputTime = -1.0;
+}
+
+/*
+ * PrepareFrame() - Frame start common to the GL and software paths.
+ */
+void PortalScene::PrepareFrame()
+{
+    if (stats.Enabled())
+        stats.BeginFrame();
+    resources.BeginFrame();
+
+    if (!initialized)
+    {
+        if (sweepMode == SWEEP_PORTALS)
+            portalPairs = SWEEP_FIRST_PAIRS;
+        else if (sweepMode == SWEEP_LIGHTS)
+            numLights = SWEEP_FIRST_LIGHTS;
+        if (sweepMode != SWEEP_NONE)
+            stats.SetReportInterval(0);  // Reported per sweep step instead.
+        InitializeScene();
+    }
+}
+
+/*
+ * FinishFrame() - Counters of the frame's plan, then the frame time.
+ */
+void PortalScene::FinishFrame()
+{
+    resources.EndFrame();
+    if (stats.Enabled())
+    {
+        stats.Count("views", framePlan.views.size());
+        stats.Count("culled", framePlan.numCulled);
+        stats.Count("shared", framePlan.numShared);
+        stats.Count("demoted", framePlan.numDemoted);
+        stats.Count("obj_culled", framePlan.numObjectsCulled);
+        stats.Count("draw_cmds", framePlan.numCommands);
+        stats.Count("lists_ms", 1e3 * framePlanner.BuildSeconds());
+        stats.Count("xform_hit_pct", 100.0 * framePlanner.Transforms().HitRate());
+        if (numLights > 0)
+        {
+            stats.Count("lightrefs", lighting.lightRefs);
+            stats.Count("bin_ms", 1e3 * lighting.binSeconds);
+        }
+        stats.Count("gpu_kb", resources.TotalBytes() / 1024.0);
+        stats.Count("list_kb", resources.Bytes(GpuResources::LISTS) / 1024.0);
+        stats.Count("buf_kb", resources.Bytes(GpuResources::BUFFERS) / 1024.0);
+        stats.Count("tex_kb", resources.Bytes(GpuResources::TEXTURES) / 1024.0);
+        if (resources.Budget() > 0)
+        {
+            stats.Count("budget_pct", 100.0 * resources.TotalBytes() / resources.Budget());
+            stats.Count("evicted", resources.numEvicted);
+            stats.Count("restored_kb", resources.restoredBytes / 1024.0);
+        }
+        if (capture != NULL)
+        {
+            stats.Count("cap_dropped", capture->lastDropped);
+            stats.Count("cap_blocked", capture->lastBlocked);
+            stats.Count("cap_wait_ms", 1e3 * capture->lastWaitSeconds);
+        }
+        stats.EndFrame();
+        if (sweepMode != SWEEP_NONE)
+            AdvanceSweep();
+    }
+}
+
+/*
+ * AdvanceSweep()
+ */
+void PortalScene::AdvanceSweep()
+{
+    if (++sweepFrames < SWEEP_STEP_FRAMES)
+        return;
+    sweepFrames = 0;
+
+    int size = (sweepMode == SWEEP_PORTALS ? 2*portalPairs : numLights);
+    const char *sizeName = (sweepMode == SWEEP_PORTALS ? "portals" : "lights");
+    std::cout << "sweep: " << sizeName << "=" << size << " ";
+    stats.Report();
+    sweepResults.push_back(std::make_pair(size, stats.LastMeanFrameTime()));
+
+    if (sweepMode == SWEEP_PORTALS && portalPairs < SWEEP_LAST_PAIRS)
+    {
+        portalPairs *= 2;
+        BuildScene();
+        return;
+    }
+    if (sweepMode == SWEEP_LIGHTS && numLights < SWEEP_LAST_LIGHTS)
+    {
+        numLights *= 4;
+        BuildLights();
+        return;
+    }
+
+    std::cout << "sweep summary (" << sizeName << ", mean frame ms):" << std::endl;
+    for (size_t i = 0; i < sweepResults.size(); i++)
+        std::cout << "  " << sweepResults[i].first
+                  << "\t" << 1e3 * sweepResults[i].second << std::endl;
+    sweepMode = SWEEP_NONE;
+    stats.SetReportInterval(100);
+}
+
+/*
+ * HandleKey()
+ */
+void PortalScene::HandleKey(char key)
+{
+    const float STEP = 0.8f;
+    float q = framePlanner.ViewQuality();
+    if (key == '[')
+        q = std::max(PortalFramePlanner::MIN_RESOLUTION_SCALE, q * STEP);
+    else if (key == ']')
+        q = (q / STEP > 0.99f) ? 1.0f : q / STEP;
+    else
+        return;
+    if (pathRecorder != NULL)
+        pathRecorder->NoteKey(key);
+    framePlanner.SetViewQuality(q);
+    std::cout << "view quality: " << q << std::endl;
+}
+
+/*
+ * AdvanceAnimation()
+ */
+void PortalScene::AdvanceAnimation()
+{
+    static float timeIncrement = 0.01;
+
+    using glm::mat4;
+    using glm::sin;
+    using glm::cos;
+    using glm::abs;
+    if (animationTarget != NULL)
+    {
+        float angle = 1.05*timeIncrement;
+        float s = sin(angle);
+        float c = cos(angle);
+        mat4 *modelMat = &(animationTarget->modelMat);
+
+        // Rotate about world Z direction at the target's origin.
+        // Matrices are accessed column-major, and column i contains
+        //   the world space coordinates of model axis i.
+        // Leave column 3 alone, it is the target's origin.
+        for (int i = 0; i <= 2; i++)
+        {
+            float a = (*modelMat)[i][0];
+            float b = (*modelMat)[i][1];
+            (*modelMat)[i][0] = a*c - b*s;
+            (*modelMat)[i][1] = a*s + b*c;
+        }
+
+        //Old animation...
+        //animationTarget->modelMat[3][2] = 3.0 + 2.0*animTime;
+    }
+
+    // Lights circle the world Z axis, the other way round.
+    {
+        float s = sin(-0.5*timeIncrement);
+        float c = cos(-0.5*timeIncrement);
+        for (size_t i = 0; i < lights.size(); i++)
+        {
+            glm::vec3 &p = lights[i].position;
+            float a = p.x;
+            float b = p.y;
+            p.x = a*c - b*s;
+            p.y = a*s + b*c;
+        }
+    }
+
+    animTime += timeIncrement;
+    if (abs(animTime) > 0.995)
+        timeIncrement = -timeIncrement;
+}
+
+/*
+ * ObjectName() - For printing picks.
+ */
+const char *PortalScene::ObjectName(const MeshObject *obj) const
+{
+    if (obj->AsPortal() != NULL)
+        return "portal";
+    if (obj->mesh == squareMesh)
+        return "ground";
+    if (obj->mesh == frameMesh)
+        return "frame";
+    if (obj->mesh == octahedronMesh)
+        return "octahedron";
+    if (obj->mesh == coneMesh)
+        return "cone";
+    for (size_t k = 0; k < modelObjects.size(); k++)
+        if (obj->mesh == modelObjects[k].mesh)
+            return modelObjects[k].name.c_str();
+    return "object";
+}
+
+/*
+ * Pick()
+ */
+bool PortalScene::Pick(int x, int y, std::ostream &out)
+{
+    if (!initialized)
+        return false;
+
+    // Objects animate, so index the scene as it is now.
+    rayCaster.Build(meshObjects);
+
+    const glm::mat4 *viewMat = &lastViewMat, *projMat = &lastProjMat;
+    const ScissorRect *viewport = &lastViewport;
+    for (size_t e = 0; e < eyeCameras.size(); e++)
+        if (eyeCameras[e].viewport.Overlaps(ScissorRect(x, y, 1, 1)))
+        {
+            viewMat = &eyeCameras[e].viewMat;
+            projMat = &eyeCameras[e].projMat;
+            viewport = &eyeCameras[e].viewport;
+        }
+
+    RayHit hit;
+    Ray ray = PortalRayCaster::PickRay(x, y, *viewMat, *projMat, *viewport);
+    if (!rayCaster.Cast(ray, hit))
+    {
+        out << "pick: x=" << x << " y=" << y << " nothing" << std::endl;
+        return false;
+    }
+
+    out << "pick: x=" << x << " y=" << y << " " << ObjectName(hit.object)
+        << " hops=" << hit.hops << (hit.hopLimited ? " (hop limit)" : "")
+        << " distance=" << hit.distance
+        << " at=(" << hit.position.x << ", " << hit.position.y << ", "
+        << hit.position.z << ")" << std::endl;
+    return true;
+}
+
+/*
+ * BenchmarkRays()
+ */
+void PortalScene::BenchmarkRays(std::ostream &out)
+{
+    if (portalPairs == 0)
+        portalPairs = SWEEP_LAST_PAIRS;
+    if (!initialized)
+        InitializeScene();
+
+    // The default camera, 1200x600.
+    Camera camera;
+    PortalRayCaster::Benchmark(out, meshObjects, camera.ViewMatrix(),
+            camera.ProjectionMatrix(2.0f), 1200, 600);
+}
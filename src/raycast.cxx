@@ -0,0 +1,398 @@
+/* =============================================================================
+ * raycast.cxx
+ * Masado Ishii
+ * v0.3 2026-10-19
+ *
+ * Description: Ray casting through the scene and across portal links.
+ *
+ * Attributions:
+ *   > Ray-triangle test after T. Moller and B. Trumbore, "Fast, Minimum
+ *     Storage Ray/Triangle Intersection", 1997.
+ * =============================================================================
+ */
+
+#include <algorithm>
+#include <iomanip>
+#include <limits>
+#include <thread>
+
+#include "../include/raycast.h"
+#include "../include/mesh.h"
+
+
+/* --------------------------------------------------------------------
+ * PortalRayCaster member functions.
+ * --------------------------------------------------------------------
+ */
+
+PortalRayCaster::~PortalRayCaster()
+{
+    Clear();
+}
+
+void PortalRayCaster::Clear()
+{
+    for (size_t i = 0; i < scenes.size(); i++)
+        delete scenes[i];
+    scenes.clear();
+}
+
+int PortalRayCaster::NumTriangles() const
+{
+    int n = 0;
+    for (size_t i = 0; i < scenes.size(); i++)
+        n += (int) scenes[i]->triangles.size();
+    return n;
+}
+
+/*
+ * SceneFor() - Index of scene's SceneIndex, creating an empty one if new.
+ */
+int PortalRayCaster::SceneFor(const MeshObjList *scene,
+        std::map<const MeshObjList *, int> &known)
+{
+    std::map<const MeshObjList *, int>::iterator found = known.find(scene);
+    if (found != known.end())
+        return found->second;
+
+    SceneIndex *index = new SceneIndex;
+    index->scene = scene;
+    scenes.push_back(index);
+    known[scene] = (int) scenes.size() - 1;
+    return (int) scenes.size() - 1;
+}
+
+/*
+ * Build()
+ */
+void PortalRayCaster::Build(const MeshObjList &root)
+{
+    Clear();
+    std::map<const MeshObjList *, int> known;
+    SceneFor(&root, known);
+
+    // Scenes found through portals are appended and indexed in turn.
+    for (size_t s = 0; s < scenes.size(); s++)
+    {
+        SceneIndex &index = *scenes[s];
+        for (MeshObjList::const_iterator iter = index.scene->begin();
+                iter != index.scene->end();
+                ++iter)
+        {
+            const MeshObject *obj = *iter;
+            const PolygonMesh *mesh = obj->mesh->AsPolygonMesh();
+            if (mesh == NULL)
+                continue;
+
+            ObjectEntry entry;
+            entry.object = obj;
+            entry.portal = obj->AsPortal();
+            entry.destScene = -1;
+            if (entry.portal != NULL && entry.portal->destPortal != NULL)
+            {
+                entry.hopMat = glm::inverse(entry.portal->LinkMatrix());
+                const MeshObjList *dest = entry.portal->destPortal->parentScene;
+                entry.destScene = SceneFor(dest != NULL ? dest : index.scene, known);
+            }
+            else
+                entry.portal = NULL;  // Unlinked portals are plain surfaces.
+            index.objects.push_back(entry);
+
+            for (int t = 0; t < mesh->NumTriangles(); t++)
+            {
+                glm::vec3 v[3];
+                for (int k = 0; k < 3; k++)
+                    v[k] = glm::vec3(obj->modelMat
+                            * glm::vec4(mesh->positions[mesh->triangles[3*t + k]], 1.0f));
+                Triangle tri;
+                tri.v0 = v[0];
+                tri.e1 = v[1] - v[0];
+                tri.e2 = v[2] - v[0];
+                tri.object = (int) index.objects.size() - 1;
+                tri.index = t;
+                index.triangles.push_back(tri);
+            }
+        }
+        BuildNodes(index);
+    }
+}
+
+
+/*
+ * BuildNodes() - Median split on the longest axis of the triangle
+ *   centroids, down to LEAF_SIZE triangles per leaf.
+ */
+void PortalRayCaster::BuildNodes(SceneIndex &index)
+{
+    std::vector<Triangle> &tris = index.triangles;
+    std::vector<Node> &nodes = index.nodes;
+    nodes.clear();
+    if (tris.empty())
+        return;
+    nodes.reserve(2 * tris.size() / LEAF_SIZE + 1);
+
+    struct Range { int node, begin, end; };
+    std::vector<Range> work;
+    nodes.push_back(Node());
+    Range top = { 0, 0, (int) tris.size() };
+    work.push_back(top);
+
+    while (!work.empty())
+    {
+        Range r = work.back();
+        work.pop_back();
+
+        glm::vec3 bmin(std::numeric_limits<float>::max());
+        glm::vec3 bmax(-std::numeric_limits<float>::max());
+        glm::vec3 cmin = bmin, cmax = bmax;
+        for (int i = r.begin; i < r.end; i++)
+        {
+            const Triangle &t = tris[i];
+            glm::vec3 v1 = t.v0 + t.e1, v2 = t.v0 + t.e2;
+            bmin = glm::min(bmin, glm::min(t.v0, glm::min(v1, v2)));
+            bmax = glm::max(bmax, glm::max(t.v0, glm::max(v1, v2)));
+            glm::vec3 c = t.v0 + (t.e1 + t.e2) / 3.0f;
+            cmin = glm::min(cmin, c);
+            cmax = glm::max(cmax, c);
+        }
+        nodes[r.node].bmin = bmin;
+        nodes[r.node].bmax = bmax;
+
+        glm::vec3 extent = cmax - cmin;
+        int axis = (extent.x >= extent.y && extent.x >= extent.z) ? 0
+                : (extent.y >= extent.z ? 1 : 2);
+        if (r.end - r.begin <= LEAF_SIZE || extent[axis] <= 0.0f)
+        {
+            nodes[r.node].first = r.begin;
+            nodes[r.node].count = r.end - r.begin;
+            continue;
+        }
+
+        int mid = (r.begin + r.end) / 2;
+        std::nth_element(tris.begin() + r.begin, tris.begin() + mid, tris.begin() + r.end,
+                [axis](const Triangle &a, const Triangle &b)
+                { return (3.0f*a.v0 + a.e1 + a.e2)[axis] < (3.0f*b.v0 + b.e1 + b.e2)[axis]; });
+
+        int left = (int) nodes.size();
+        nodes.resize(nodes.size() + 2);
+        nodes[r.node].first = left;
+        nodes[r.node].count = 0;
+        Range lr = { left, r.begin, mid };
+        Range rr = { left + 1, mid, r.end };
+        work.push_back(lr);
+        work.push_back(rr);
+    }
+}
+
+
+/*
+ * Intersect()
+ */
+int PortalRayCaster::Intersect(const SceneIndex &index, const glm::vec3 &origin,
+        const glm::vec3 &dir, const MeshObject *skip, float &tMax) const
+{
+    if (index.nodes.empty())
+        return -1;
+
+    const glm::vec3 invDir = 1.0f / dir;
+    int best = -1;
+
+    int stack[64];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0)
+    {
+        const Node &node = index.nodes[stack[--top]];
+
+        // Slab test against the node's box.
+        glm::vec3 t1 = (node.bmin - origin) * invDir;
+        glm::vec3 t2 = (node.bmax - origin) * invDir;
+        glm::vec3 tlo = glm::min(t1, t2), thi = glm::max(t1, t2);
+        float tEnter = std::max(std::max(tlo.x, tlo.y), std::max(tlo.z, 0.0f));
+        float tExit = std::min(std::min(thi.x, thi.y), std::min(thi.z, tMax));
+        if (tEnter > tExit)
+            continue;
+
+        if (node.count == 0)
+        {
+            // Visit the child nearer along the ray first.
+            const Node &left = index.nodes[node.first];
+            float dl = glm::dot(left.bmin + left.bmax - 2.0f*origin, dir);
+            const Node &right = index.nodes[node.first + 1];
+            float dr = glm::dot(right.bmin + right.bmax - 2.0f*origin, dir);
+            if (top + 2 > 64)
+                continue;  // Unreachable for median splits of any sane scene.
+            stack[top++] = (dl <= dr) ? node.first + 1 : node.first;
+            stack[top++] = (dl <= dr) ? node.first : node.first + 1;
+            continue;
+        }
+
+        for (int i = node.first; i < node.first + node.count; i++)
+        {
+            const Triangle &tri = index.triangles[i];
+            glm::vec3 p = glm::cross(dir, tri.e2);
+            float det = glm::dot(tri.e1, p);
+            if (det <= 1e-12f)  // Back face, or parallel to the ray.
+                continue;
+            float inv = 1.0f / det;
+            glm::vec3 s = origin - tri.v0;
+            float u = glm::dot(s, p) * inv;
+            if (u < 0.0f || u > 1.0f)
+                continue;
+            glm::vec3 q = glm::cross(s, tri.e1);
+            float v = glm::dot(dir, q) * inv;
+            if (v < 0.0f || u + v > 1.0f)
+                continue;
+            float t = glm::dot(tri.e2, q) * inv;
+            if (t > 0.0f && t < tMax && index.objects[tri.object].object != skip)
+            {
+                tMax = t;
+                best = i;
+            }
+        }
+    }
+    return best;
+}
+
+
+/*
+ * Cast()
+ */
+bool PortalRayCaster::Cast(const Ray &ray, RayHit &hit, int maxHops) const
+{
+    hit = RayHit();
+    if (scenes.empty())
+        return false;
+
+    int s = 0;
+    glm::vec3 origin = ray.origin, dir = ray.direction;
+    const MeshObject *skip = NULL;
+
+    while (true)
+    {
+        const SceneIndex &index = *scenes[s];
+        float t = std::numeric_limits<float>::max();
+        int i = Intersect(index, origin, dir, skip, t);
+        if (i < 0)
+            return false;
+
+        const Triangle &tri = index.triangles[i];
+        const ObjectEntry &entry = index.objects[tri.object];
+        glm::vec3 point = origin + t * dir;
+        hit.distance += t * glm::length(dir);
+
+        if (entry.portal != NULL)
+        {
+            if (hit.hops < maxHops)
+            {
+                // Out of destPortal, as the renderer's view through it.
+                hit.hops++;
+                origin = glm::vec3(entry.hopMat * glm::vec4(point, 1.0f));
+                dir = glm::vec3(entry.hopMat * glm::vec4(dir, 0.0f));
+                hit.pathMat = entry.hopMat * hit.pathMat;
+                skip = entry.portal->destPortal;
+                s = entry.destScene;
+                continue;
+            }
+            hit.hopLimited = true;
+        }
+
+        hit.object = entry.object;
+        hit.triangle = tri.index;
+        hit.scene = index.scene;
+        hit.position = point;
+        hit.normal = glm::normalize(glm::cross(tri.e1, tri.e2));
+        return true;
+    }
+}
+
+/*
+ * CastBatch()
+ */
+void PortalRayCaster::CastBatch(const std::vector<Ray> &rays, std::vector<RayHit> &hits,
+        WorkerPool &pool, int maxHops) const
+{
+    hits.resize(rays.size());
+    pool.ParallelFor((int) rays.size(), [&](int begin, int end, int chunk)
+    {
+        for (int i = begin; i < end; i++)
+            Cast(rays[i], hits[i], maxHops);
+    });
+}
+
+/*
+ * PickRay()
+ */
+Ray PortalRayCaster::PickRay(int x, int y, const glm::mat4 &viewMat,
+        const glm::mat4 &projMat, const ScissorRect &viewport)
+{
+    glm::vec4 vp(viewport.x, viewport.y, viewport.width, viewport.height);
+    glm::vec3 nearPoint = glm::unProject(glm::vec3(x + 0.5f, y + 0.5f, 0.0f),
+            viewMat, projMat, vp);
+    glm::vec3 farPoint = glm::unProject(glm::vec3(x + 0.5f, y + 0.5f, 1.0f),
+            viewMat, projMat, vp);
+    return Ray(nearPoint, farPoint - nearPoint);
+}
+
+
+/*
+ * Benchmark()
+ */
+void PortalRayCaster::Benchmark(std::ostream &out, const MeshObjList &root,
+        const glm::mat4 &viewMat, const glm::mat4 &projMat, int width, int height)
+{
+    const int REPEATS = 3;
+
+    PortalRayCaster caster;
+    caster.Build(root);  // Warm up.
+    double t0 = mishii_Seconds();
+    for (int r = 0; r < REPEATS; r++)
+        caster.Build(root);
+    double buildTime = (mishii_Seconds() - t0) / REPEATS;
+
+    ScissorRect viewport(0, 0, width, height);
+    std::vector<Ray> rays;
+    rays.reserve((size_t) width * height);
+    for (int y = 0; y < height; y++)
+        for (int x = 0; x < width; x++)
+            rays.push_back(PickRay(x, y, viewMat, projMat, viewport));
+    std::vector<RayHit> hits;
+
+    // Restored at the end, for whatever prints to out next.
+    std::ios::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+
+    out << std::fixed << std::setprecision(3)
+        << "ray casting, " << root.size() << " objects, "
+        << caster.NumTriangles() << " triangles, build ms=" << 1e3 * buildTime
+        << ", " << width << "x" << height << " rays:" << std::endl;
+
+    int maxThreads = (int) std::thread::hardware_concurrency();
+    if (maxThreads < 1)
+        maxThreads = 1;
+    for (int n = 1; ; n = std::min(2*n, maxThreads))
+    {
+        WorkerPool pool(n);
+        caster.CastBatch(rays, hits, pool);  // Warm up.
+        t0 = mishii_Seconds();
+        for (int r = 0; r < REPEATS; r++)
+            caster.CastBatch(rays, hits, pool);
+        double t = (mishii_Seconds() - t0) / REPEATS;
+
+        long numHit = 0, numHops = 0;
+        for (size_t i = 0; i < hits.size(); i++)
+        {
+            numHit += (hits[i].object != NULL);
+            numHops += hits[i].hops;
+        }
+        out << "  threads=" << n << " ms=" << 1e3 * t
+            << " mrays_per_s=" << 1e-6 * rays.size() / t
+            << " hit=" << (double) numHit / rays.size()
+            << " hops_per_ray=" << (double) numHops / rays.size() << std::endl;
+
+        if (n == maxThreads)
+            break;
+    }
+    out.flags(flags);
+    out.precision(precision);
+}
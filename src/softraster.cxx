@@ -0,0 +1,420 @@
+/* =============================================================================
+ * softraster.cxx
+ * Masado Ishii
+ * v0.3 2026-10-19
+ *
+ * Description: Tile-based, multithreaded CPU rasterizer that executes a
+ *   PortalFramePlan without a GL context.
+ *
+ * Attributions:
+ *   > Edge functions after J. Pineda, "A Parallel Algorithm for Polygon
+ *     Rasterization", SIGGRAPH 1988.
+ * =============================================================================
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "../include/softraster.h"
+#include "../include/mesh.h"
+
+
+/* --------------------------------------------------------------------
+ * SoftFramebuffer member functions.
+ * --------------------------------------------------------------------
+ */
+
+void SoftFramebuffer::Resize(int w, int h)
+{
+    width = w;
+    height = h;
+    color.resize((size_t) w * h);
+    depth.resize((size_t) w * h);
+    stencil.resize((size_t) w * h);
+}
+
+void SoftFramebuffer::Clear(const glm::vec4 &clearColor, float clearDepth,
+        unsigned char clearStencil)
+{
+    unsigned char rgba[4];
+    for (int k = 0; k < 4; k++)
+        rgba[k] = (unsigned char) (glm::clamp(clearColor[k], 0.0f, 1.0f) * 255.0f + 0.5f);
+    unsigned int packed;
+    memcpy(&packed, rgba, 4);
+
+    std::fill(color.begin(), color.end(), packed);
+    std::fill(depth.begin(), depth.end(), clearDepth);
+    std::fill(stencil.begin(), stencil.end(), clearStencil);
+}
+
+
+/* --------------------------------------------------------------------
+ * SoftRasterizer member functions.
+ * --------------------------------------------------------------------
+ */
+
+SoftRasterizer::SoftRasterizer(WorkerPool &pool)
+        : numTriangles(0), numBinned(0), setupSeconds(0.0), rasterSeconds(0.0),
+          pool(pool), tilesX(0), tilesY(0)
+{
+    light.direction = glm::vec3(0.0f, 0.0f, 1.0f);
+    light.ambient = 0.4f;
+    light.diffuse = 0.8f;
+}
+
+/*
+ * Render() - Records the passes of PortalFrameRenderer::Render(), bins
+ *   them to tiles, then rasterizes the tiles.
+ */
+void SoftRasterizer::Render(const PortalFramePlan &plan, const glm::mat4 &proj,
+        const ScissorRect &vp, SoftFramebuffer &fb)
+{
+    double t0 = mishii_Seconds();
+    projMat = proj;
+    viewport = vp;
+    bounds = vp.Intersect(ScissorRect(0, 0, fb.width, fb.height));
+    triangles.clear();
+
+    for (int level = 0; level < plan.NumLevels(); level++)
+    {
+        // ResetLevel(): far depth and black inside each portal.
+        if (level > 0)
+            for (int vi = plan.LevelBegin(level); vi < plan.LevelEnd(level); vi++)
+            {
+                const PortalView &view = plan.views[vi];
+                Submit(*view.portal, plan.views[view.parent].viewMat, MODE_RESET,
+                        view.stencilRef, 0, view.scissor);
+            }
+
+        // DrawLevel()
+        for (int vi = plan.LevelBegin(level); vi < plan.LevelEnd(level); vi++)
+        {
+            const PortalView &view = plan.views[vi];
+            for (size_t i = 0; i < view.drawList.size(); i++)
+                Submit(*view.drawList[i], view.viewMat, MODE_DRAW,
+                        view.stencilRef, 0, view.scissor);
+        }
+
+        // MarkLevel(): flip (parent ^ child) where the child portal shows.
+        if (level + 1 < plan.NumLevels())
+            for (int vi = plan.LevelBegin(level); vi < plan.LevelEnd(level); vi++)
+            {
+                const PortalView &view = plan.views[vi];
+                for (size_t c = 0; c < view.children.size(); c++)
+                {
+                    const PortalView &child = plan.views[view.children[c]];
+                    Submit(*child.portal, view.viewMat, MODE_MARK, view.stencilRef,
+                            view.stencilRef ^ child.stencilRef, child.scissor);
+                }
+            }
+    }
+    numTriangles = (int) triangles.size();
+
+    // Bin in submission order.
+    tilesX = (fb.width + TILE_SIZE - 1) / TILE_SIZE;
+    tilesY = (fb.height + TILE_SIZE - 1) / TILE_SIZE;
+    bins.resize(tilesX * tilesY);
+    for (size_t b = 0; b < bins.size(); b++)
+        bins[b].clear();
+    numBinned = 0;
+    for (int i = 0; i < numTriangles; i++)
+    {
+        const Triangle &tri = triangles[i];
+        for (int ty = tri.y0 / TILE_SIZE; ty <= (tri.y1 - 1) / TILE_SIZE; ty++)
+            for (int tx = tri.x0 / TILE_SIZE; tx <= (tri.x1 - 1) / TILE_SIZE; tx++)
+            {
+                bins[ty * tilesX + tx].push_back(i);
+                numBinned++;
+            }
+    }
+
+    double t1 = mishii_Seconds();
+    setupSeconds = t1 - t0;
+
+    // Tiles are dealt round-robin, since the busy ones tend to cluster.
+    int numTiles = tilesX * tilesY;
+    int numThreads = pool.NumThreads();
+    pool.ParallelFor(numThreads, [&](int begin, int end, int chunk)
+    {
+        for (int first = begin; first < end; first++)
+            for (int t = first; t < numTiles; t += numThreads)
+                RasterTile(t, fb);
+    });
+
+    rasterSeconds = mishii_Seconds() - t1;
+}
+
+/*
+ * Submit() - Transforms, lights, clips and sets up obj's triangles.
+ */
+void SoftRasterizer::Submit(const MeshObject &obj, const glm::mat4 &viewMat, Mode mode,
+        GLint ref, GLint writeMask, const ScissorRect &scissor)
+{
+    const PolygonMesh *mesh = obj.mesh->AsPolygonMesh();
+    if (mesh == NULL)
+        return;  // Only CPU-side geometry can be rasterized.
+
+    glm::mat4 modelView = viewMat * obj.modelMat;
+    glm::mat4 mvp = projMat * modelView;
+
+    size_t n = mesh->positions.size();
+    clipVerts.resize(n);
+    for (size_t i = 0; i < n; i++)
+        clipVerts[i] = mvp * glm::vec4(mesh->positions[i], 1.0f);
+
+    litColors.resize(n);
+    if (mode == MODE_DRAW)
+    {
+        // No per-vertex normals: the GL's current normal (0, 0, 1) for all.
+        glm::vec3 normal = glm::transpose(glm::inverse(glm::mat3(modelView)))
+                * glm::vec3(0.0f, 0.0f, 1.0f);
+        float f = light.ambient
+                + light.diffuse * std::max(0.0f, glm::dot(normal, light.direction));
+        for (size_t i = 0; i < n; i++)
+            litColors[i] = 255.0f * glm::clamp(f * mesh->colors[i], 0.0f, 1.0f);
+    }
+
+    for (int t = 0; t < mesh->NumTriangles(); t++)
+    {
+        glm::vec4 clip[3];
+        glm::vec3 color[3];
+        for (int k = 0; k < 3; k++)
+        {
+            clip[k] = clipVerts[mesh->triangles[3*t + k]];
+            color[k] = litColors[mesh->triangles[3*t + k]];
+        }
+
+        bool inside = true;
+        for (int k = 0; k < 3; k++)
+            inside = inside && clip[k].z >= -clip[k].w && clip[k].z <= clip[k].w;
+        if (inside)
+        {
+            SetupTriangle(clip, color, mode, ref, writeMask, scissor);
+            continue;
+        }
+
+        // Clip against the near and far planes, then fan out.
+        glm::vec4 poly[2][6];
+        glm::vec3 polyColor[2][6];
+        int count = 3;
+        for (int k = 0; k < 3; k++)
+        {
+            poly[0][k] = clip[k];
+            polyColor[0][k] = color[k];
+        }
+        int cur = 0;
+        for (int plane = 0; plane < 2 && count > 0; plane++)
+        {
+            float sign = (plane == 0 ? 1.0f : -1.0f);  // Near: z + w >= 0; far: w - z >= 0.
+            int out = 0;
+            for (int k = 0; k < count; k++)
+            {
+                const glm::vec4 &a = poly[cur][k], &b = poly[cur][(k + 1) % count];
+                float da = a.w + sign * a.z, db = b.w + sign * b.z;
+                if (da >= 0.0f)
+                {
+                    poly[1-cur][out] = a;
+                    polyColor[1-cur][out++] = polyColor[cur][k];
+                }
+                if ((da >= 0.0f) != (db >= 0.0f))
+                {
+                    float s = da / (da - db);
+                    poly[1-cur][out] = a + s * (b - a);
+                    polyColor[1-cur][out++] = polyColor[cur][k]
+                            + s * (polyColor[cur][(k + 1) % count] - polyColor[cur][k]);
+                }
+            }
+            count = out;
+            cur = 1 - cur;
+        }
+        for (int k = 1; k + 1 < count; k++)
+        {
+            glm::vec4 fanClip[3] = { poly[cur][0], poly[cur][k], poly[cur][k+1] };
+            glm::vec3 fanColor[3] = { polyColor[cur][0], polyColor[cur][k], polyColor[cur][k+1] };
+            SetupTriangle(fanClip, fanColor, mode, ref, writeMask, scissor);
+        }
+    }
+}
+
+/*
+ * SetupTriangle() - Viewport transform, back-face culling, and the edge
+ *   and attribute planes.
+ */
+void SoftRasterizer::SetupTriangle(const glm::vec4 clip[3], const glm::vec3 color[3],
+        Mode mode, GLint ref, GLint writeMask, const ScissorRect &scissor)
+{
+    glm::vec3 v[3];
+    for (int k = 0; k < 3; k++)
+    {
+        float invW = 1.0f / clip[k].w;
+        v[k].x = viewport.x + 0.5f * (clip[k].x * invW + 1.0f) * viewport.width;
+        v[k].y = viewport.y + 0.5f * (clip[k].y * invW + 1.0f) * viewport.height;
+        v[k].z = (mode == MODE_RESET) ? 1.0f : 0.5f * (clip[k].z * invW + 1.0f);
+    }
+
+    // Counterclockwise in window space is front facing; cull the rest.
+    float area2 = (v[1].x - v[0].x) * (v[2].y - v[0].y)
+                - (v[2].x - v[0].x) * (v[1].y - v[0].y);
+    if (!(area2 > 0.0f))
+        return;
+
+    Triangle tri;
+    ScissorRect box((int) std::floor(std::min(v[0].x, std::min(v[1].x, v[2].x))),
+                    (int) std::floor(std::min(v[0].y, std::min(v[1].y, v[2].y))), 0, 0);
+    box.width = (int) std::ceil(std::max(v[0].x, std::max(v[1].x, v[2].x))) - box.x + 1;
+    box.height = (int) std::ceil(std::max(v[0].y, std::max(v[1].y, v[2].y))) - box.y + 1;
+    box = box.Intersect(scissor).Intersect(bounds);
+    if (box.Empty())
+        return;
+    tri.x0 = box.x;
+    tri.y0 = box.y;
+    tri.x1 = box.x + box.width;
+    tri.y1 = box.y + box.height;
+
+    // Edge k is opposite vertex k; E_k / area2 is its barycentric weight.
+    float invArea = 1.0f / area2;
+    for (int k = 0; k < 3; k++)
+    {
+        const glm::vec3 &a = v[(k + 1) % 3], &b = v[(k + 2) % 3];
+        tri.edgeA[k] = a.y - b.y;
+        tri.edgeB[k] = b.x - a.x;
+        tri.edgeC[k] = -(tri.edgeA[k] * a.x + tri.edgeB[k] * a.y);
+        tri.edgeTopLeft[k] = tri.edgeA[k] > 0.0f || (tri.edgeA[k] == 0.0f && tri.edgeB[k] < 0.0f);
+    }
+
+    tri.zA = tri.zB = tri.zC = 0.0f;
+    for (int c = 0; c < 3; c++)
+        tri.rgbA[c] = tri.rgbB[c] = tri.rgbC[c] = 0.0f;
+    for (int k = 0; k < 3; k++)
+    {
+        float wa = tri.edgeA[k] * invArea, wb = tri.edgeB[k] * invArea, wc = tri.edgeC[k] * invArea;
+        tri.zA += v[k].z * wa;
+        tri.zB += v[k].z * wb;
+        tri.zC += v[k].z * wc;
+        for (int c = 0; c < 3; c++)
+        {
+            tri.rgbA[c] += color[k][c] * wa;
+            tri.rgbB[c] += color[k][c] * wb;
+            tri.rgbC[c] += color[k][c] * wc;
+        }
+    }
+
+    tri.mode = (unsigned char) mode;
+    tri.ref = (unsigned char) ref;
+    tri.writeMask = (unsigned char) writeMask;
+    triangles.push_back(tri);
+}
+
+/*
+ * RasterTile() - All triangles binned to one tile, in order.
+ */
+void SoftRasterizer::RasterTile(int tile, SoftFramebuffer &fb) const
+{
+    const int tx0 = (tile % tilesX) * TILE_SIZE, ty0 = (tile / tilesX) * TILE_SIZE;
+    const int tx1 = std::min(tx0 + TILE_SIZE, fb.width), ty1 = std::min(ty0 + TILE_SIZE, fb.height);
+    const std::vector<int> &bin = bins[tile];
+
+    for (size_t b = 0; b < bin.size(); b++)
+    {
+        const Triangle &tri = triangles[bin[b]];
+        int x0 = std::max(tri.x0, tx0), x1 = std::min(tri.x1, tx1);
+        int y0 = std::max(tri.y0, ty0), y1 = std::min(tri.y1, ty1);
+
+        for (int y = y0; y < y1; y++)
+        {
+            float py = y + 0.5f;
+            size_t row = (size_t) y * fb.width;
+
+            for (int x = x0; x < x1; x += 4)
+            {
+                float px = x + 0.5f;
+
+                // Coverage and depth for pixels x .. x+3.
+                int mask;
+                float z[4];
+#ifdef __SSE2__
+                const __m128 lane = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+                __m128 pxs = _mm_add_ps(_mm_set1_ps(px), lane);
+                __m128 pys = _mm_set1_ps(py);
+                __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+                for (int k = 0; k < 3; k++)
+                {
+                    __m128 e = _mm_add_ps(_mm_add_ps(
+                            _mm_mul_ps(_mm_set1_ps(tri.edgeA[k]), pxs),
+                            _mm_mul_ps(_mm_set1_ps(tri.edgeB[k]), pys)),
+                            _mm_set1_ps(tri.edgeC[k]));
+                    __m128 in = tri.edgeTopLeft[k] ? _mm_cmpge_ps(e, _mm_setzero_ps())
+                                                   : _mm_cmpgt_ps(e, _mm_setzero_ps());
+                    inside = _mm_and_ps(inside, in);
+                }
+                mask = _mm_movemask_ps(inside);
+                if (mask == 0)
+                    continue;
+                _mm_storeu_ps(z, _mm_add_ps(_mm_add_ps(
+                        _mm_mul_ps(_mm_set1_ps(tri.zA), pxs),
+                        _mm_mul_ps(_mm_set1_ps(tri.zB), pys)),
+                        _mm_set1_ps(tri.zC)));
+#else
+                mask = 0;
+                for (int l = 0; l < 4; l++)
+                {
+                    float lx = px + l;
+                    bool in = true;
+                    for (int k = 0; k < 3; k++)
+                    {
+                        float e = tri.edgeA[k] * lx + tri.edgeB[k] * py + tri.edgeC[k];
+                        in = in && (tri.edgeTopLeft[k] ? e >= 0.0f : e > 0.0f);
+                    }
+                    mask |= (in ? 1 : 0) << l;
+                    z[l] = tri.zA * lx + tri.zB * py + tri.zC;
+                }
+                if (mask == 0)
+                    continue;
+#endif
+                if (x + 4 > x1)
+                    mask &= (1 << (x1 - x)) - 1;
+
+                for (int l = 0; l < 4; l++)
+                {
+                    if (!(mask & (1 << l)))
+                        continue;
+                    size_t i = row + x + l;
+                    if (fb.stencil[i] != tri.ref)
+                        continue;
+
+                    switch (tri.mode)
+                    {
+                      case MODE_RESET:  // Depth test ALWAYS, blend ZERO, ZERO.
+                        fb.depth[i] = 1.0f;
+                        fb.color[i] = 0;
+                        break;
+                      case MODE_DRAW:
+                        if (z[l] < fb.depth[i])
+                        {
+                            float lx = px + l;
+                            unsigned char rgba[4];
+                            for (int c = 0; c < 3; c++)
+                            {
+                                float v = tri.rgbA[c] * lx + tri.rgbB[c] * py + tri.rgbC[c];
+                                rgba[c] = (unsigned char) std::min(255.0f, std::max(0.0f, v + 0.5f));
+                            }
+                            rgba[3] = 255;
+                            memcpy(&fb.color[i], rgba, 4);
+                            fb.depth[i] = z[l];
+                        }
+                        break;
+                      case MODE_MARK:  // No depth or color writes; GL_INVERT under the mask.
+                        if (z[l] < fb.depth[i])
+                            fb.stencil[i] ^= tri.writeMask;
+                        break;
+                    }
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,361 @@
+/* =============================================================================
+ * tiledrender.cxx
+ * Masado Ishii
+ * v0.3 2026-10-19
+ *
+ * Description: Sort-first rendering across processes: strip balancing,
+ *   the render processes, and the compositor backend.
+ *
+ * Attributions:
+ * =============================================================================
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "../include/tiledrender.h"
+#include "../include/parallel.h"
+#include "../include/portalscene.h"
+#include "../include/viewscaling.h"  // ScaledViewTarget::SubProjection().
+
+
+/* --------------------------------------------------------------------
+ * TileBalancer member functions.
+ * --------------------------------------------------------------------
+ */
+
+void TileBalancer::Reset(int h, int numTiles)
+{
+    height = h;
+    bounds.resize(numTiles + 1);
+    for (int t = 0; t <= numTiles; t++)
+        bounds[t] = (int) ((long) h * t / numTiles);
+}
+
+void TileBalancer::Update(const std::vector<double> &seconds)
+{
+    int n = NumTiles();
+    double total = 0.0;
+    for (int t = 0; t < n; t++)
+        total += seconds[t];
+    if (!(total > 0.0))
+        return;
+
+    // Boundary k goes where the cost summed from the bottom reaches k/n of
+    //   the total. Strips that cost nothing are passed over, so the strip
+    //   the boundary lands in always has a cost.
+    std::vector<int> target(bounds);
+    int t = 0;
+    double below = 0.0;  // Cost of the strips under strip t.
+    for (int k = 1; k < n; k++)
+    {
+        double goal = total * k / n;
+        while (below + seconds[t] < goal)
+            below += seconds[t++];
+        double rowCost = seconds[t] / std::max(Rows(t), 1);
+        target[k] = bounds[t] + (int) ((goal - below) / rowCost + 0.5);
+    }
+
+    // Halfway there, damping the noise in frame times; then keep every
+    //   strip at least MIN_ROWS high.
+    for (int k = 1; k < n; k++)
+        bounds[k] += (target[k] - bounds[k]) / 2;
+    for (int k = 1; k < n; k++)
+        bounds[k] = std::max(bounds[k], bounds[k-1] + MIN_ROWS);
+    for (int k = n - 1; k >= 1; k--)
+        bounds[k] = std::min(bounds[k], bounds[k+1] - MIN_ROWS);
+}
+
+
+/* --------------------------------------------------------------------
+ * TiledRenderBackend member functions.
+ * --------------------------------------------------------------------
+ */
+
+TiledRenderBackend::TiledRenderBackend(RenderBackend *d, PortalScene &s,
+        const std::string &worker, int n)
+        : display(d), scene(&s), workerBackend(worker), numProcs(n),
+          width(0), height(0), pixels(NULL), pixelBytes(0), frame(0), failed(false)
+{
+}
+
+TiledRenderBackend::~TiledRenderBackend()
+{
+    StopWorkers();
+    delete display;
+}
+
+const char *TiledRenderBackend::WorkerBackend(const std::string &displayName)
+{
+    if (displayName == "soft")
+        return "soft";
+#ifdef FV_HAVE_OSMESA
+    if (displayName == "osmesa")
+        return "osmesa";
+#endif
+#ifdef FV_HAVE_EGL
+    return "egl";
+#elif defined(FV_HAVE_OSMESA)
+    return "osmesa";
+#else
+    return "soft";
+#endif
+}
+
+bool TiledRenderBackend::Open(int w, int h)
+{
+    width = w;
+    height = h;
+    numProcs = std::max(1, std::min(numProcs, h / TileBalancer::MIN_ROWS));
+
+    pixelBytes = 4 * (size_t) w * h;
+    void *shared = mmap(NULL, pixelBytes, PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (shared == MAP_FAILED)
+    {
+        std::cerr << "TiledRenderBackend: mmap: " << strerror(errno) << std::endl;
+        pixels = NULL;
+        return false;
+    }
+    pixels = (unsigned char *) shared;
+
+    // Fork before any GL context of this process exists that a render
+    //   process could inherit. The shared worker threads may already run;
+    //   RunWorker() starts its own. Unflushed output would print twice.
+    std::cout.flush();
+    std::cerr.flush();
+    for (int p = 0; p < numProcs; p++)
+    {
+        int fds[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0)
+        {
+            std::cerr << "TiledRenderBackend: socketpair: " << strerror(errno) << std::endl;
+            StopWorkers();
+            return false;
+        }
+        pid_t pid = fork();
+        if (pid < 0)
+        {
+            std::cerr << "TiledRenderBackend: fork: " << strerror(errno) << std::endl;
+            close(fds[0]);
+            close(fds[1]);
+            StopWorkers();
+            return false;
+        }
+        if (pid == 0)
+        {
+            close(fds[0]);
+            for (size_t q = 0; q < sockets.size(); q++)
+                close(sockets[q]);
+            RunWorker(fds[1]);
+            _exit(EXIT_SUCCESS);  // Skips the parent's destructors and exit handlers.
+        }
+        close(fds[1]);
+        sockets.push_back(fds[0]);
+        children.push_back(pid);
+    }
+
+    // Each process answers once its backend is open.
+    bool ready = true;
+    for (int p = 0; p < numProcs; p++)
+    {
+        Reply reply;
+        if (!ReadAll(sockets[p], &reply, sizeof reply) || reply.frame != 0)
+            ready = false;
+    }
+    if (!ready)
+    {
+        std::cerr << "TiledRenderBackend: a render process could not open the '"
+                  << workerBackend << "' backend." << std::endl;
+        StopWorkers();
+        return false;
+    }
+
+    balancer.Reset(h, numProcs);
+    tileSeconds.assign(numProcs, 0.0);
+    frame = 0;
+    failed = false;
+    return display->Open(w, h);
+}
+
+void TiledRenderBackend::Close()
+{
+    StopWorkers();
+    display->Close();
+}
+
+void TiledRenderBackend::StopWorkers()
+{
+    Command quit;
+    memset(&quit, 0, sizeof quit);
+    quit.frame = -1;
+    for (size_t p = 0; p < sockets.size(); p++)
+    {
+        WriteAll(sockets[p], &quit, sizeof quit);
+        close(sockets[p]);
+    }
+    for (size_t p = 0; p < children.size(); p++)
+        waitpid(children[p], NULL, 0);
+    sockets.clear();
+    children.clear();
+
+    if (pixels != NULL)
+        munmap(pixels, pixelBytes);
+    pixels = NULL;
+}
+
+void TiledRenderBackend::DrawFrame(PortalScene &s, const Camera &camera)
+{
+    if (failed)
+        return;
+
+    FrameStats &stats = s.GetStats();
+    if (stats.Enabled())
+        stats.BeginFrame();
+
+    glm::mat4 viewMat = camera.ViewMatrix();
+    glm::mat4 projMat = camera.ProjectionMatrix((float) width / height);
+
+    Command command;
+    command.frame = ++frame;
+    command.width = width;
+    command.height = height;
+    memcpy(command.viewMat, glm::value_ptr(viewMat), sizeof command.viewMat);
+    memcpy(command.projMat, glm::value_ptr(projMat), sizeof command.projMat);
+
+    // All strips render at once; each process writes its own rows.
+    for (int p = 0; p < numProcs && !failed; p++)
+    {
+        command.tileY = balancer.Begin(p);
+        command.tileRows = balancer.Rows(p);
+        failed = !WriteAll(sockets[p], &command, sizeof command);
+    }
+    double dispatched = mishii_Seconds();
+    for (int p = 0; p < numProcs && !failed; p++)
+    {
+        Reply reply;
+        failed = !ReadAll(sockets[p], &reply, sizeof reply) || reply.frame != frame;
+        tileSeconds[p] = reply.seconds;
+    }
+    if (failed)
+    {
+        std::cerr << "TiledRenderBackend: lost a render process; stopping." << std::endl;
+        return;
+    }
+    double gathered = mishii_Seconds();
+
+    display->ShowPixels(width, height, pixels);
+    if (s.GetCapture() != NULL)
+        s.GetCapture()->CapturePixels(width, height, pixels);
+
+    if (stats.Enabled())
+    {
+        double slowest = *std::max_element(tileSeconds.begin(), tileSeconds.end());
+        double fastest = *std::min_element(tileSeconds.begin(), tileSeconds.end());
+        stats.Count("tile_max_ms", 1e3 * slowest);
+        stats.Count("tile_min_ms", 1e3 * fastest);
+        stats.Count("gather_ms", 1e3 * (gathered - dispatched));
+        stats.Count("show_ms", 1e3 * (mishii_Seconds() - gathered));
+        stats.EndFrame();
+    }
+
+    balancer.Update(tileSeconds);
+}
+
+/*
+ * RunWorker() - Body of a render process: draws the strip of each frame
+ *   command into the shared frame until told to stop.
+ */
+void TiledRenderBackend::RunWorker(int socket)
+{
+    // Only the forking thread came along, so the shared pools are restarted
+    //   before the scene or a soft backend waits on them.
+    WorkerPool::RestartShared();
+    TaskScheduler::RestartShared();
+    scene->SetScheduler(&TaskScheduler::Shared());
+
+    // The compositor records and reports frames.
+    scene->SetCapture(NULL);
+    scene->GetStats().SetEnabled(false);
+
+    std::unique_ptr<RenderBackend> backend(CreateRenderBackend(workerBackend));
+    Reply reply;
+    reply.frame = 0;
+    reply.seconds = 0.0;
+    if (!backend || !backend->Open(width, height))
+    {
+        reply.frame = -1;
+        WriteAll(socket, &reply, sizeof reply);
+        return;
+    }
+    WriteAll(socket, &reply, sizeof reply);
+
+    Command command;
+    while (ReadAll(socket, &command, sizeof command) && command.frame >= 0)
+    {
+        scene->AdvanceAnimation();  // In step with the compositor's loop.
+
+        double start = mishii_Seconds();
+        glm::mat4 viewMat, projMat;
+        memcpy(glm::value_ptr(viewMat), command.viewMat, sizeof command.viewMat);
+        memcpy(glm::value_ptr(projMat), command.projMat, sizeof command.projMat);
+
+        // The strip fills the bottom of this process's drawable.
+        ScissorRect frameRect(0, 0, command.width, command.height);
+        ScissorRect strip(0, command.tileY, command.width, command.tileRows);
+        ScissorRect viewport(0, 0, command.width, command.tileRows);
+        glm::mat4 stripProj = ScaledViewTarget::SubProjection(projMat, frameRect, strip);
+
+        backend->DrawView(*scene, viewMat, stripProj, viewport);
+        backend->ReadPixels(viewport, pixels + 4 * (size_t) command.tileY * command.width,
+                command.width);
+
+        reply.frame = command.frame;
+        reply.seconds = mishii_Seconds() - start;
+        if (!WriteAll(socket, &reply, sizeof reply))
+            break;
+    }
+    scene->ReleaseGpuResources();
+    backend->Close();
+}
+
+bool TiledRenderBackend::WriteAll(int fd, const void *data, size_t n)
+{
+    const char *p = (const char *) data;
+    while (n > 0)
+    {
+        ssize_t done = send(fd, p, n, MSG_NOSIGNAL);  // EPIPE, not SIGPIPE, if it exited.
+        if (done < 0 && errno == EINTR)
+            continue;
+        if (done <= 0)
+            return false;
+        p += done;
+        n -= done;
+    }
+    return true;
+}
+
+bool TiledRenderBackend::ReadAll(int fd, void *data, size_t n)
+{
+    char *p = (char *) data;
+    while (n > 0)
+    {
+        ssize_t done = recv(fd, p, n, 0);
+        if (done < 0 && errno == EINTR)
+            continue;
+        if (done <= 0)
+            return false;
+        p += done;
+        n -= done;
+    }
+    return true;
+}
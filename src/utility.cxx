@@ -12,6 +12,12 @@
 
 #include <ostream>
 #include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <time.h>
+#include <unistd.h>
+#include <cstdlib>
 #include "../include/utility.h"
 
 /* ------------------------------------------------------------------
@@ -32,3 +38,54 @@ void mishii_PrintMatrix(std::ostream &out, const float *mat, int num_rows, int n
 }
 
 
+
+/* ------------------------------------------------------------------
+ * Utility routine: mishii_Seconds().
+ * ------------------------------------------------------------------
+ */
+double mishii_Seconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
+
+/* ------------------------------------------------------------------
+ * Utility routines: mishii_ProcessAge(), mishii_ResidentKB().
+ * ------------------------------------------------------------------
+ */
+double mishii_ProcessAge()
+{
+    std::ifstream statFile("/proc/self/stat");
+    std::ifstream uptimeFile("/proc/uptime");
+    std::string stat;
+    double uptime;
+    if (!std::getline(statFile, stat) || !(uptimeFile >> uptime))
+        return -1.0;
+
+    // Fields after the parenthesized command name start at field 3;
+    //   starttime is field 22.
+    size_t close = stat.rfind(')');
+    if (close == std::string::npos)
+        return -1.0;
+    std::istringstream fields(stat.substr(close + 2));
+    std::string skip;
+    for (int field = 3; field < 22; field++)
+        fields >> skip;
+    double startTicks;
+    if (!(fields >> startTicks))
+        return -1.0;
+
+    return uptime - startTicks / sysconf(_SC_CLK_TCK);
+}
+
+long mishii_ResidentKB(bool peak)
+{
+    std::ifstream status("/proc/self/status");
+    std::string key = (peak ? "VmHWM:" : "VmRSS:");
+    std::string line;
+    while (std::getline(status, line))
+        if (line.compare(0, key.size(), key) == 0)
+            return atol(line.c_str() + key.size());
+    return -1;
+}
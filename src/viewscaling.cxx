@@ -0,0 +1,339 @@
+/* =============================================================================
+ * viewscaling.cxx
+ * Masado Ishii
+ * v0.3 2026-10-19
+ *
+ * Description: Offscreen target for portal views drawn at reduced
+ *   resolution.
+ *
+ * Attributions:
+ * =============================================================================
+ */
+
+#ifndef GL_GLEXT_PROTOTYPES
+#define GL_GLEXT_PROTOTYPES  // GL 3.0 entry points; must precede the first gl.h.
+#endif
+#include <GL/gl.h>
+#include <GL/glext.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#include "../include/viewscaling.h"
+
+
+/* --------------------------------------------------------------------
+ * Shader sources.
+ * --------------------------------------------------------------------
+ */
+
+namespace
+{
+    const char *compositeVertexShader =
+        "#version 120\n"
+        "void main()\n"
+        "{\n"
+        "    gl_Position = ftransform();\n"
+        "}\n";
+
+    // Window position to atlas coordinates: uv = xy * slotMap.xy + slotMap.zw.
+    const char *compositeFragmentShader =
+        "#version 120\n"
+        "uniform sampler2D colorTex;\n"
+        "uniform sampler2D depthTex;\n"
+        "uniform vec4 slotMap;\n"
+        "void main()\n"
+        "{\n"
+        "    vec2 uv = gl_FragCoord.xy * slotMap.xy + slotMap.zw;\n"
+        "    gl_FragColor = texture2D(colorTex, uv);\n"
+        "    gl_FragDepth = texture2D(depthTex, uv).r;\n"
+        "}\n";
+
+    GLuint CompileShader(GLenum type, const char *source)
+    {
+        GLuint shader = glCreateShader(type);
+        glShaderSource(shader, 1, &source, NULL);
+        glCompileShader(shader);
+
+        GLint ok;
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+        if (!ok)
+        {
+            char log[1024];
+            glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+            std::cerr << "ScaledViewTarget: shader compile failed:" << std::endl
+                      << log << std::endl;
+            glDeleteShader(shader);
+            return 0;
+        }
+        return shader;
+    }
+}
+
+
+/* --------------------------------------------------------------------
+ * ScaledViewTarget member functions.
+ * --------------------------------------------------------------------
+ */
+
+ScaledViewTarget::ScaledViewTarget(GpuResources &r)
+        : resources(r), initialized(false), usable(false), framebuffer(-1),
+          colorTexture(-1), depthTexture(-1), capacityW(0), capacityH(0),
+          program(0), uSlotMap(-1), shelfX(0), shelfY(0), shelfH(0), usedW(0), usedH(0),
+          prevFramebuffer(0)
+{
+}
+
+ScaledViewTarget::~ScaledViewTarget()
+{
+    // Assumes the context that created them is still current.
+    Evict(resources);
+    if (program != 0)
+        glDeleteProgram(program);
+}
+
+glm::mat4 ScaledViewTarget::SubProjection(const glm::mat4 &projMat,
+        const ScissorRect &viewport, const ScissorRect &rect)
+{
+    // Window x maps to rect's NDC as x' = a * x_ndc + b, likewise y.
+    glm::mat4 crop(1.0f);
+    crop[0][0] = (float) viewport.width / rect.width;
+    crop[1][1] = (float) viewport.height / rect.height;
+    crop[3][0] = (2.0f * (viewport.x - rect.x) + viewport.width) / rect.width - 1.0f;
+    crop[3][1] = (2.0f * (viewport.y - rect.y) + viewport.height) / rect.height - 1.0f;
+    return crop * projMat;
+}
+
+void ScaledViewTarget::BeginBatch(const glm::mat4 &proj, const ScissorRect &vp)
+{
+    projMat = proj;
+    viewport = vp;
+    slots.clear();
+    shelfX = shelfY = shelfH = 0;
+    usedW = usedH = 0;
+}
+
+int ScaledViewTarget::AddSlot(const ScissorRect &rect, float scale)
+{
+    int w = std::max(1, (int) std::ceil(rect.width * scale));
+    int h = std::max(1, (int) std::ceil(rect.height * scale));
+
+    // Next shelf when this one is full; no slot is wider than the viewport.
+    //   A one pixel gutter keeps filtering from reaching into neighbours.
+    if (shelfX > 0 && shelfX + w > viewport.width)
+    {
+        shelfX = 0;
+        shelfY += shelfH + 1;
+        shelfH = 0;
+    }
+
+    Slot slot;
+    slot.rect = rect;
+    slot.atlas = ScissorRect(shelfX, shelfY, w, h);
+    slots.push_back(slot);
+
+    shelfX += w + 1;
+    shelfH = std::max(shelfH, h);
+    usedW = std::max(usedW, shelfX);
+    usedH = std::max(usedH, shelfY + shelfH);
+    return (int) slots.size() - 1;
+}
+
+bool ScaledViewTarget::Available()
+{
+    if (!initialized)
+        usable = Initialize();
+    return usable;
+}
+
+bool ScaledViewTarget::Bind()
+{
+    if (!Available() || slots.empty())
+        return false;
+    if (framebuffer < 0 && !CreateAtlas())
+    {
+        Evict(resources);
+        usable = false;
+        return false;
+    }
+    Reserve(usedW, usedH);
+    resources.Touch(framebuffer);
+    resources.Touch(colorTexture);
+    resources.Touch(depthTexture);
+
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &prevFramebuffer);
+    glGetIntegerv(GL_VIEWPORT, prevViewport);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, resources.Name(framebuffer));
+    glDisable(GL_STENCIL_TEST);  // The atlas has no stencil; the composite is stenciled.
+    glScissor(0, 0, usedW, usedH);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    glMatrixMode(GL_PROJECTION);
+    glPushMatrix();
+    glMatrixMode(GL_MODELVIEW);
+    return true;
+}
+
+void ScaledViewTarget::BeginSlot(int s, glm::mat4 &subProj, ScissorRect &subViewport)
+{
+    const Slot &slot = slots[s];
+    subViewport = slot.atlas;
+    glViewport(subViewport.x, subViewport.y, subViewport.width, subViewport.height);
+    glScissor(subViewport.x, subViewport.y, subViewport.width, subViewport.height);
+
+    subProj = SubProjection(projMat, viewport, slot.rect);
+    glMatrixMode(GL_PROJECTION);
+    glLoadMatrixf(glm::value_ptr(subProj));
+    glMatrixMode(GL_MODELVIEW);
+}
+
+void ScaledViewTarget::Unbind()
+{
+    glMatrixMode(GL_PROJECTION);
+    glPopMatrix();
+    glMatrixMode(GL_MODELVIEW);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, prevFramebuffer);
+    glViewport(prevViewport[0], prevViewport[1], prevViewport[2], prevViewport[3]);
+    glEnable(GL_STENCIL_TEST);
+}
+
+void ScaledViewTarget::BeginComposite(int s)
+{
+    const Slot &slot = slots[s];
+    float kx = (float) slot.atlas.width / (slot.rect.width * capacityW);
+    float ky = (float) slot.atlas.height / (slot.rect.height * capacityH);
+
+    glUseProgram(program);
+    glUniform4f(uSlotMap, kx, ky,
+            (float) slot.atlas.x / capacityW - slot.rect.x * kx,
+            (float) slot.atlas.y / capacityH - slot.rect.y * ky);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, resources.Name(depthTexture));
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, resources.Name(colorTexture));
+}
+
+void ScaledViewTarget::EndComposite()
+{
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glActiveTexture(GL_TEXTURE0);
+    glUseProgram(0);
+}
+
+bool ScaledViewTarget::Initialize()
+{
+    initialized = true;
+
+    GLuint vs = CompileShader(GL_VERTEX_SHADER, compositeVertexShader);
+    GLuint fs = CompileShader(GL_FRAGMENT_SHADER, compositeFragmentShader);
+    if (vs == 0 || fs == 0)
+        return false;
+
+    program = glCreateProgram();
+    glAttachShader(program, vs);
+    glAttachShader(program, fs);
+    glLinkProgram(program);
+    glDeleteShader(vs);
+    glDeleteShader(fs);
+
+    GLint ok;
+    glGetProgramiv(program, GL_LINK_STATUS, &ok);
+    if (!ok)
+    {
+        char log[1024];
+        glGetProgramInfoLog(program, sizeof(log), NULL, log);
+        std::cerr << "ScaledViewTarget: program link failed:" << std::endl
+                  << log << std::endl;
+        return false;
+    }
+
+    glUseProgram(program);
+    glUniform1i(glGetUniformLocation(program, "colorTex"), 0);
+    glUniform1i(glGetUniformLocation(program, "depthTex"), 1);
+    uSlotMap = glGetUniformLocation(program, "slotMap");
+    glUseProgram(0);
+
+    return CreateAtlas();
+}
+
+/*
+ * CreateAtlas() - The atlas textures, at a small size, and the framebuffer.
+ */
+bool ScaledViewTarget::CreateAtlas()
+{
+    // Color is upsampled linearly; depth must not be blended across edges.
+    colorTexture = resources.Create(GpuResources::TEXTURES, this);
+    glBindTexture(GL_TEXTURE_2D, resources.Name(colorTexture));
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    depthTexture = resources.Create(GpuResources::TEXTURES, this);
+    glBindTexture(GL_TEXTURE_2D, resources.Name(depthTexture));
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_NONE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    framebuffer = resources.Create(GpuResources::FRAMEBUFFERS, this);
+    Reserve(64, 64);
+
+    GLint prev;
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &prev);
+    glBindFramebuffer(GL_FRAMEBUFFER, resources.Name(framebuffer));
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+            resources.Name(colorTexture), 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D,
+            resources.Name(depthTexture), 0);
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, prev);
+    if (status != GL_FRAMEBUFFER_COMPLETE)
+    {
+        std::cerr << "ScaledViewTarget: framebuffer incomplete (0x"
+                  << std::hex << status << std::dec << ")." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/*
+ * Reserve() - Grows the textures to at least w x h. Attachments follow the
+ *   texture objects, so the framebuffer needs no update.
+ */
+void ScaledViewTarget::Reserve(int w, int h)
+{
+    if (w <= capacityW && h <= capacityH)
+        return;
+    capacityW = std::max(w, capacityW);
+    capacityH = std::max(h, capacityH);
+
+    glBindTexture(GL_TEXTURE_2D, resources.Name(colorTexture));
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, capacityW, capacityH, 0,
+            GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glBindTexture(GL_TEXTURE_2D, resources.Name(depthTexture));
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, capacityW, capacityH, 0,
+            GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, NULL);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    size_t texels = (size_t) capacityW * capacityH;
+    resources.SetBytes(colorTexture, 4 * texels);
+    resources.SetBytes(depthTexture, 4 * texels);  // Stored as 32 bits.
+}
+
+void ScaledViewTarget::Evict(GpuResources &r)
+{
+    r.Delete(framebuffer);
+    r.Delete(colorTexture);
+    r.Delete(depthTexture);
+    framebuffer = colorTexture = depthTexture = -1;
+    capacityW = capacityH = 0;
+}
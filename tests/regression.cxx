@@ -0,0 +1,336 @@
+/* =============================================================================
+ * regression.cxx
+ * Masado Ishii
+ * v0.3 2026-10-19
+ *
+ * Description: Rendering and frame time regression test, run by CTest for
+ *   each canonical scene. Draws the scene on the CPU rasterizer (no GPU
+ *   needed), compares the last frame with a golden image, and the median
+ *   frame time with a stored baseline.
+ *
+ *   funnelvision_regress [options] SCENE
+ *     --golden DIR        Golden images, SCENE.png (default tests/golden).
+ *     --baseline FILE     Median frame times by scene and build type
+ *                         (default tests/baseline.txt).
+ *     --out DIR           Where frames that differ, and generated models,
+ *                         are written (default .).
+ *     --build-type NAME   Baseline entries to compare with (default "default").
+ *     --max-slowdown X    Fail if the median is over X times the baseline
+ *                         (default 1.5, and at least 1 ms over it); 0
+ *                         skips the timing check.
+ *     --update            Write the golden image and baseline entry instead.
+ *
+ * Attributions:
+ * =============================================================================
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../include/camera.h"
+#include "../include/imagefile.h"
+#include "../include/portalscene.h"
+#include "../include/softraster.h"
+
+
+namespace
+{
+
+const int WIDTH = 256, HEIGHT = 128;
+const int WARMUP_FRAMES = 5;
+const int TIMED_FRAMES = 40;
+
+// A pixel is off if a channel differs by more than CHANNEL_TOLERANCE; the
+//   frame fails if more than PIXEL_TOLERANCE of its pixels are off. The
+//   rasterizer's float math may round differently between compilers.
+const int    CHANNEL_TOLERANCE = 24;
+const double PIXEL_TOLERANCE = 0.002;
+
+// Timing noise: the limit is never under the baseline plus this much.
+const double MIN_SLACK_MS = 1.0;
+
+// Cubes per side of the "instances" model: INSTANCE_GRID^3 objects.
+const int INSTANCE_GRID = 16;
+
+struct SceneSpec
+{
+    const char *name;
+    const char *about;
+    int portalPairs;
+    bool instances;    // Add the generated model of many cubes.
+    int minLevels;     // Recursion levels the last frame must reach.
+    float position[3], focalPoint[3], viewUp[3];
+    float viewAngle, clipNear, clipFar;
+};
+
+const SceneSpec SCENES[] =
+{
+    { "default", "two portals, default camera", 0, false, 2,
+      { 0.0f, 0.0f, 70.0f }, { 0.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, 30.0f, 20.0f, 120.0f },
+    { "deep", "looking into a portal, views nested to the recursion limit", 0, false,
+      PortalFramePlanner::MAX_PORTAL_RECURSION_DEPTH + 1,
+      { 0.0f, 6.0f, 5.0f }, { -9.0f, 6.0f, 4.0f }, { 0.0f, 0.0f, 1.0f }, 60.0f, 0.5f, 120.0f },
+    { "grid", "64 portals", 32, false, 2,
+      { 0.0f, 0.0f, 70.0f }, { 0.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, 30.0f, 20.0f, 120.0f },
+    { "instances", "4096 mesh objects", 0, true, 1,
+      { 6.0f, -20.0f, 12.0f }, { -3.0f, -6.0f, 2.0f }, { 0.0f, 0.0f, 1.0f }, 30.0f, 1.0f, 120.0f },
+};
+
+const SceneSpec *FindScene(const std::string &name)
+{
+    for (size_t k = 0; k < sizeof SCENES / sizeof SCENES[0]; k++)
+        if (name == SCENES[k].name)
+            return &SCENES[k];
+    return NULL;
+}
+
+/* A lattice of small cubes, each its own OBJ object. */
+bool WriteInstanceModel(const std::string &path)
+{
+    FILE *f = fopen(path.c_str(), "w");
+    if (f == NULL)
+        return false;
+    const int n = INSTANCE_GRID;
+    for (int i = 0; i < n*n*n; i++)
+    {
+        int x = i % n, y = (i / n) % n, z = i / (n*n);
+        fprintf(f, "o cube%d\n", i);
+        for (int c = 0; c < 8; c++)
+            fprintf(f, "v %g %g %g %.3f %.3f %.3f\n",
+                    x + 0.6f*(c & 1), y + 0.6f*((c >> 1) & 1), z + 0.6f*((c >> 2) & 1),
+                    (float) x / n, (float) y / n, (float) z / n);
+        // Corners numbered by bits (x, y, z); two triangles per face.
+        static const int faces[6][4] =
+            { {0,2,3,1}, {4,5,7,6}, {0,1,5,4}, {2,6,7,3}, {0,4,6,2}, {1,3,7,5} };
+        for (int q = 0; q < 6; q++)
+            fprintf(f, "f %d %d %d %d\n", faces[q][0] - 8, faces[q][1] - 8,
+                    faces[q][2] - 8, faces[q][3] - 8);
+    }
+    return fclose(f) == 0;
+}
+
+/* Baseline lines: "SCENE BUILD_TYPE MEDIAN_MS". */
+bool ReadBaseline(const std::string &path, const std::string &scene,
+        const std::string &buildType, double &medianMs)
+{
+    std::ifstream in(path.c_str());
+    std::string line;
+    while (std::getline(in, line))
+    {
+        std::istringstream fields(line);
+        std::string s, b;
+        double ms;
+        if (line.empty() || line[0] == '#' || !(fields >> s >> b >> ms))
+            continue;
+        if (s == scene && b == buildType)
+        {
+            medianMs = ms;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool WriteBaseline(const std::string &path, const std::string &scene,
+        const std::string &buildType, double medianMs)
+{
+    std::vector<std::string> lines;
+    {
+        std::ifstream in(path.c_str());
+        std::string line;
+        while (std::getline(in, line))
+        {
+            std::istringstream fields(line);
+            std::string s, b;
+            if ((fields >> s >> b) && line[0] != '#' && s == scene && b == buildType)
+                continue;
+            lines.push_back(line);
+        }
+    }
+    std::ostringstream entry;
+    entry << scene << " " << buildType << " " << std::fixed << std::setprecision(3) << medianMs;
+    lines.push_back(entry.str());
+
+    std::ofstream out(path.c_str());
+    for (size_t k = 0; k < lines.size(); k++)
+        out << lines[k] << "\n";
+    return (bool) out;
+}
+
+int CountOffPixels(const std::vector<unsigned char> &a, const unsigned char *b, size_t numPixels)
+{
+    int off = 0;
+    for (size_t p = 0; p < numPixels; p++)
+        for (int c = 0; c < 3; c++)
+            if (abs((int) a[4*p + c] - (int) b[4*p + c]) > CHANNEL_TOLERANCE)
+            {
+                off++;
+                break;
+            }
+    return off;
+}
+
+}
+
+
+/* --------------------------------------------------------------------
+ * main()
+ * --------------------------------------------------------------------
+ */
+int main(int argc, char *argv[])
+{
+    std::string goldenDir = "tests/golden", baselinePath = "tests/baseline.txt";
+    std::string outDir = ".", buildType = "default", sceneName;
+    double maxSlowdown = 1.5;
+    bool update = false, badArgs = false;
+    for (int i = 1; i < argc; i++)
+    {
+        bool hasValue = (i+1 < argc);
+        if (strcmp(argv[i], "--golden") == 0 && hasValue)
+            goldenDir = argv[++i];
+        else if (strcmp(argv[i], "--baseline") == 0 && hasValue)
+            baselinePath = argv[++i];
+        else if (strcmp(argv[i], "--out") == 0 && hasValue)
+            outDir = argv[++i];
+        else if (strcmp(argv[i], "--build-type") == 0 && hasValue)
+            buildType = (argv[++i][0] != '\0' ? argv[i] : "default");
+        else if (strcmp(argv[i], "--max-slowdown") == 0 && hasValue)
+            maxSlowdown = atof(argv[++i]);
+        else if (strcmp(argv[i], "--update") == 0)
+            update = true;
+        else if (argv[i][0] != '-' && sceneName.empty())
+            sceneName = argv[i];
+        else
+            badArgs = true;
+    }
+    const SceneSpec *spec = FindScene(sceneName);
+    if (spec == NULL || badArgs)
+    {
+        std::cerr << "Usage: " << argv[0] << " [--golden DIR] [--baseline FILE] [--out DIR]"
+                  << " [--build-type NAME] [--max-slowdown X] [--update] SCENE" << std::endl
+                  << "Scenes:";
+        for (size_t k = 0; k < sizeof SCENES / sizeof SCENES[0]; k++)
+            std::cerr << " " << SCENES[k].name;
+        std::cerr << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    PortalScene scene;
+    scene.SetPortalPairs(spec->portalPairs);
+    if (spec->instances)
+    {
+        std::string modelPath = outDir + "/instances.obj";
+        if (!WriteInstanceModel(modelPath))
+        {
+            std::cerr << "regress: cannot write " << modelPath << std::endl;
+            return EXIT_FAILURE;
+        }
+        scene.SetModel(modelPath);
+    }
+
+    Camera camera;
+    camera.position = glm::vec3(spec->position[0], spec->position[1], spec->position[2]);
+    camera.focalPoint = glm::vec3(spec->focalPoint[0], spec->focalPoint[1], spec->focalPoint[2]);
+    camera.viewUp = glm::vec3(spec->viewUp[0], spec->viewUp[1], spec->viewUp[2]);
+    camera.viewAngle = spec->viewAngle;
+    camera.clipNear = spec->clipNear;
+    camera.clipFar = spec->clipFar;
+    glm::mat4 viewMat = camera.ViewMatrix();
+    glm::mat4 projMat = camera.ProjectionMatrix((float) WIDTH / HEIGHT);
+    ScissorRect viewport(0, 0, WIDTH, HEIGHT);
+
+    SoftRasterizer raster;
+    SoftFramebuffer fb;
+    fb.Resize(WIDTH, HEIGHT);
+    std::vector<double> frameMs;
+    for (int frame = 0; frame < WARMUP_FRAMES + TIMED_FRAMES; frame++)
+    {
+        scene.AdvanceAnimation();
+        double start = mishii_Seconds();
+        scene.RenderFrameSoftware(viewMat, projMat, viewport, raster, fb);
+        if (frame >= WARMUP_FRAMES)
+            frameMs.push_back(1e3 * (mishii_Seconds() - start));
+    }
+    std::sort(frameMs.begin(), frameMs.end());
+    double medianMs = frameMs[frameMs.size() / 2];
+    int levels = scene.GetFramePlan().NumLevels();
+
+    std::string goldenPath = goldenDir + "/" + spec->name + ".png";
+    if (update)
+    {
+        bool ok = WritePNG(goldenPath, WIDTH, HEIGHT, fb.Pixels())
+            && WriteBaseline(baselinePath, spec->name, buildType, medianMs);
+        std::cout << "regress: scene=" << spec->name << " updated " << goldenPath
+                  << " and " << baselinePath << " (" << buildType << " median_ms="
+                  << medianMs << ")" << std::endl;
+        return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    bool pass = true;
+    std::cout << "regress: scene=" << spec->name << " (" << spec->about << ")" << std::endl;
+
+    std::cout << "  levels=" << levels;
+    if (levels < spec->minLevels)
+    {
+        std::cout << " FAIL (expected " << spec->minLevels << ")";
+        pass = false;
+    }
+    std::cout << std::endl;
+
+    int goldenWidth, goldenHeight;
+    std::vector<unsigned char> golden;
+    std::cout << "  image: ";
+    if (!ReadPNG(goldenPath, goldenWidth, goldenHeight, golden))
+    {
+        std::cout << "FAIL (cannot read " << goldenPath << ")" << std::endl;
+        pass = false;
+    }
+    else if (goldenWidth != WIDTH || goldenHeight != HEIGHT)
+    {
+        std::cout << "FAIL (golden is " << goldenWidth << "x" << goldenHeight << ")" << std::endl;
+        pass = false;
+    }
+    else
+    {
+        size_t numPixels = (size_t) WIDTH * HEIGHT;
+        int off = CountOffPixels(golden, fb.Pixels(), numPixels);
+        std::cout << "pixels_off=" << off << "/" << numPixels;
+        if (off > PIXEL_TOLERANCE * numPixels)
+        {
+            std::string actualPath = outDir + "/" + spec->name + ".actual.png";
+            WritePNG(actualPath, WIDTH, HEIGHT, fb.Pixels());
+            std::cout << " FAIL (wrote " << actualPath << ")";
+            pass = false;
+        }
+        std::cout << std::endl;
+    }
+
+    double baselineMs;
+    std::cout << std::fixed << std::setprecision(3) << "  median_ms=" << medianMs;
+    if (maxSlowdown <= 0.0)
+        std::cout << " (not checked)";
+    else if (!ReadBaseline(baselinePath, spec->name, buildType, baselineMs))
+        std::cout << " (no " << buildType << " baseline; not checked)";
+    else
+    {
+        double limitMs = std::max(maxSlowdown * baselineMs, baselineMs + MIN_SLACK_MS);
+        std::cout << " baseline_ms=" << baselineMs << " limit_ms=" << limitMs;
+        if (medianMs > limitMs)
+        {
+            std::cout << " FAIL";
+            pass = false;
+        }
+    }
+    std::cout << std::endl;
+
+    std::cout << "  " << (pass ? "PASS" : "FAIL") << std::endl;
+    return pass ? EXIT_SUCCESS : EXIT_FAILURE;
+}